@@ -0,0 +1,157 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :barrier_accumulator;
+import :command_buffer;
+import :util;
+
+using namespace prosper;
+
+static bool is_same_state(const util::BarrierImageLayout &a, const util::BarrierImageLayout &b) { return a.layout == b.layout && a.accessMask == b.accessMask && a.stageMask == b.stageMask; }
+
+BarrierAccumulator::BarrierAccumulator()
+{
+	m_pending.srcStageMask = PipelineStageFlags::None;
+	m_pending.dstStageMask = PipelineStageFlags::None;
+}
+
+bool BarrierAccumulator::Overlaps(const util::ImageBarrier &barrier, const IImage &img, const util::ImageSubresourceRange &range) const
+{
+	if(barrier.image != &img)
+		return false;
+	auto &other = barrier.subresourceRange;
+	auto layersOverlap = range.baseArrayLayer < other.baseArrayLayer + other.layerCount && other.baseArrayLayer < range.baseArrayLayer + range.layerCount;
+	auto mipmapsOverlap = range.baseMipLevel < other.baseMipLevel + other.levelCount && other.baseMipLevel < range.baseMipLevel + range.levelCount;
+	return layersOverlap && mipmapsOverlap;
+}
+
+void BarrierAccumulator::UpdateImageState(IImage &img, const util::ImageSubresourceRange &range, const util::BarrierImageLayout &state)
+{
+	auto numLayers = img.GetLayerCount();
+	auto numMipmaps = img.GetMipmapCount();
+	auto &imgState = m_imageStates[&img];
+	if(imgState.numLayers != numLayers || imgState.numMipmaps != numMipmaps) {
+		// New image (or a different image at the same address)
+		imgState.numLayers = numLayers;
+		imgState.numMipmaps = numMipmaps;
+		imgState.subresources.clear();
+		imgState.subresources.resize(numLayers * numMipmaps);
+	}
+	auto endLayer = pragma::math::min(range.baseArrayLayer + range.layerCount, numLayers);
+	auto endMipmap = pragma::math::min(range.baseMipLevel + range.levelCount, numMipmaps);
+	for(auto layer = range.baseArrayLayer; layer < endLayer; ++layer) {
+		for(auto mipmap = range.baseMipLevel; mipmap < endMipmap; ++mipmap)
+			imgState.subresources[layer * numMipmaps + mipmap] = state;
+	}
+}
+
+std::optional<util::BarrierImageLayout> BarrierAccumulator::FindImageState(const IImage &img, const util::ImageSubresourceRange &subresourceRange) const
+{
+	auto it = m_imageStates.find(&img);
+	if(it == m_imageStates.end())
+		return {};
+	auto &imgState = it->second;
+	util::ImageSubresourceRange range {};
+	util::apply_image_subresource_range(subresourceRange, range, const_cast<IImage &>(img));
+	if(range.baseArrayLayer + range.layerCount > imgState.numLayers || range.baseMipLevel + range.levelCount > imgState.numMipmaps)
+		return {};
+	std::optional<util::BarrierImageLayout> result {};
+	for(auto layer = range.baseArrayLayer; layer < range.baseArrayLayer + range.layerCount; ++layer) {
+		for(auto mipmap = range.baseMipLevel; mipmap < range.baseMipLevel + range.levelCount; ++mipmap) {
+			auto &state = imgState.subresources[layer * imgState.numMipmaps + mipmap];
+			if(!state.has_value())
+				return {};
+			if(!result.has_value())
+				result = *state;
+			else if(!is_same_state(*result, *state))
+				return {};
+		}
+	}
+	return result;
+}
+
+void BarrierAccumulator::AddImageBarrier(ICommandBuffer &cmd, IImage &img, const util::BarrierImageLayout &srcBarrierInfo, const util::BarrierImageLayout &dstBarrierInfo, const util::ImageSubresourceRange &subresourceRange, std::optional<ImageAspectFlags> aspectMask)
+{
+	++m_stats.numBarriers;
+	util::ImageSubresourceRange range {};
+	util::apply_image_subresource_range(subresourceRange, range, img);
+	for(auto &barrier : m_pending.imageBarriers) {
+		if(!Overlaps(barrier, img, range))
+			continue;
+		auto &other = barrier.subresourceRange;
+		if(other.baseArrayLayer == range.baseArrayLayer && other.layerCount == range.layerCount && other.baseMipLevel == range.baseMipLevel && other.levelCount == range.levelCount && barrier.aspectMask == aspectMask && barrier.newLayout == srcBarrierInfo.layout) {
+			// No commands can have been recorded since the pending transition, so e.g. A -> B followed by B -> C can be collapsed into A -> C
+			barrier.newLayout = dstBarrierInfo.layout;
+			barrier.dstAccessMask = dstBarrierInfo.accessMask;
+			m_pending.dstStageMask |= dstBarrierInfo.stageMask;
+			++m_stats.numMergedBarriers;
+			UpdateImageState(img, range, dstBarrierInfo);
+			return;
+		}
+		// A single pipeline barrier can't contain two different transitions for the same subresource
+		Flush(cmd);
+		break;
+	}
+	m_pending.srcStageMask |= srcBarrierInfo.stageMask;
+	m_pending.dstStageMask |= dstBarrierInfo.stageMask;
+	m_pending.imageBarriers.push_back(util::create_image_barrier(img, srcBarrierInfo, dstBarrierInfo, range, aspectMask));
+	UpdateImageState(img, range, dstBarrierInfo);
+}
+
+void BarrierAccumulator::AddBufferBarrier(ICommandBuffer &cmd, IBuffer &buf, PipelineStageFlags srcStageMask, PipelineStageFlags dstStageMask, AccessFlags srcAccessMask, AccessFlags dstAccessMask, DeviceSize offset, DeviceSize size)
+{
+	++m_stats.numBarriers;
+	if(size == std::numeric_limits<DeviceSize>::max())
+		size = buf.GetSize();
+	m_pending.srcStageMask |= srcStageMask;
+	m_pending.dstStageMask |= dstStageMask;
+
+	auto start = buf.GetStartOffset() + offset;
+	auto end = start + size;
+	for(auto &barrier : m_pending.bufferBarriers) {
+		if(barrier.buffer != &buf || barrier.offset > end || start > barrier.offset + barrier.size)
+			continue;
+		// Overlapping or adjacent ranges of the same buffer are merged into one barrier
+		auto mergedStart = pragma::math::min(barrier.offset, start);
+		auto mergedEnd = pragma::math::max(barrier.offset + barrier.size, end);
+		barrier.offset = mergedStart;
+		barrier.size = mergedEnd - mergedStart;
+		barrier.srcAccessMask |= srcAccessMask;
+		barrier.dstAccessMask |= dstAccessMask;
+		++m_stats.numMergedBarriers;
+		return;
+	}
+	util::BufferBarrierInfo bufBarrier {};
+	bufBarrier.srcAccessMask = srcAccessMask;
+	bufBarrier.dstAccessMask = dstAccessMask;
+	bufBarrier.offset = start;
+	bufBarrier.size = size;
+	m_pending.bufferBarriers.push_back(util::create_buffer_barrier(bufBarrier, buf));
+}
+
+bool BarrierAccumulator::Flush(ICommandBuffer &cmd)
+{
+	if(!HasPendingBarriers())
+		return true;
+	// The pending barriers are cleared before they're recorded, since RecordPipelineBarrier flushes the pending barriers itself
+	auto barrierInfo = std::move(m_pending);
+	m_pending.imageBarriers.clear();
+	m_pending.bufferBarriers.clear();
+	m_pending.srcStageMask = PipelineStageFlags::None;
+	m_pending.dstStageMask = PipelineStageFlags::None;
+	++m_stats.numRecordedPipelineBarriers;
+	return cmd.RecordPipelineBarrier(barrierInfo);
+}
+
+void BarrierAccumulator::Reset()
+{
+	m_pending.imageBarriers.clear();
+	m_pending.bufferBarriers.clear();
+	m_pending.srcStageMask = PipelineStageFlags::None;
+	m_pending.dstStageMask = PipelineStageFlags::None;
+	m_imageStates.clear();
+}
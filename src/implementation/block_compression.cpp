@@ -0,0 +1,393 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :block_compression;
+import :format_info;
+
+using namespace prosper;
+
+namespace {
+	using Texels = std::array<std::array<uint8_t, 4>, 16>;
+	using Color = std::array<float, 3>;
+
+	void load_block(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Texels &outTexels)
+	{
+		for(auto y = 0u; y < 4; ++y) {
+			auto srcY = pragma::math::min(blockY * 4 + y, height - 1);
+			for(auto x = 0u; x < 4; ++x) {
+				auto srcX = pragma::math::min(blockX * 4 + x, width - 1);
+				std::memcpy(outTexels[y * 4 + x].data(), rgba + (static_cast<size_t>(srcY) * width + srcX) * 4, 4);
+			}
+		}
+	}
+
+	uint16_t pack_565(const Color &color)
+	{
+		auto quantize = [](float v, float maxValue) { return static_cast<uint16_t>(std::clamp(std::round(v * maxValue / 255.f), 0.f, maxValue)); };
+		return (quantize(color[0], 31.f) << 11) | (quantize(color[1], 63.f) << 5) | quantize(color[2], 31.f);
+	}
+	Color unpack_565(uint16_t color)
+	{
+		auto r = (color >> 11) & 31;
+		auto g = (color >> 5) & 63;
+		auto b = color & 31;
+		return {static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)), static_cast<float>((b << 3) | (b >> 2))};
+	}
+	Color lerp(const Color &a, const Color &b, float t) { return {a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t, a[2] + (b[2] - a[2]) * t}; }
+	float distance_sq(const Color &a, const Color &b)
+	{
+		auto dr = a[0] - b[0];
+		auto dg = a[1] - b[1];
+		auto db = a[2] - b[2];
+		return dr * dr + dg * dg + db * db;
+	}
+
+	struct ColorBlock {
+		std::array<Color, 16> colors;
+		std::array<bool, 16> transparent;
+		uint32_t numOpaque = 0;
+		bool threeColorMode = false;
+	};
+
+	void compute_color_endpoints(const ColorBlock &block, util::BlockCompressionQuality quality, Color &outE0, Color &outE1)
+	{
+		Color minColor {255.f, 255.f, 255.f};
+		Color maxColor {0.f, 0.f, 0.f};
+		Color mean {0.f, 0.f, 0.f};
+		for(auto i = 0u; i < 16; ++i) {
+			if(block.transparent[i])
+				continue;
+			for(auto c = 0u; c < 3; ++c) {
+				minColor[c] = pragma::math::min(minColor[c], block.colors[i][c]);
+				maxColor[c] = pragma::math::max(maxColor[c], block.colors[i][c]);
+				mean[c] += block.colors[i][c];
+			}
+		}
+		if(quality == util::BlockCompressionQuality::Fast) {
+			// Inset the bounding box slightly, since the extremes are rarely hit exactly
+			for(auto c = 0u; c < 3; ++c) {
+				auto inset = (maxColor[c] - minColor[c]) / 16.f;
+				outE0[c] = maxColor[c] - inset;
+				outE1[c] = minColor[c] + inset;
+			}
+			return;
+		}
+		for(auto &c : mean)
+			c /= static_cast<float>(block.numOpaque);
+
+		// Covariance matrix (xx, xy, xz, yy, yz, zz)
+		std::array<float, 6> cov {};
+		for(auto i = 0u; i < 16; ++i) {
+			if(block.transparent[i])
+				continue;
+			auto r = block.colors[i][0] - mean[0];
+			auto g = block.colors[i][1] - mean[1];
+			auto b = block.colors[i][2] - mean[2];
+			cov[0] += r * r;
+			cov[1] += r * g;
+			cov[2] += r * b;
+			cov[3] += g * g;
+			cov[4] += g * b;
+			cov[5] += b * b;
+		}
+		// Power iteration for the principal axis
+		Color axis {maxColor[0] - minColor[0], maxColor[1] - minColor[1], maxColor[2] - minColor[2]};
+		for(auto i = 0u; i < 8; ++i) {
+			Color next {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2], cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2], cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+			auto maxComponent = pragma::math::max(std::abs(next[0]), pragma::math::max(std::abs(next[1]), std::abs(next[2])));
+			if(maxComponent < 1e-6f)
+				break;
+			for(auto c = 0u; c < 3; ++c)
+				axis[c] = next[c] / maxComponent;
+		}
+		auto len = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if(len < 1e-6f) {
+			// All texels have the same color
+			outE0 = outE1 = mean;
+			return;
+		}
+		for(auto &c : axis)
+			c /= len;
+		auto minT = std::numeric_limits<float>::max();
+		auto maxT = std::numeric_limits<float>::lowest();
+		for(auto i = 0u; i < 16; ++i) {
+			if(block.transparent[i])
+				continue;
+			auto t = (block.colors[i][0] - mean[0]) * axis[0] + (block.colors[i][1] - mean[1]) * axis[1] + (block.colors[i][2] - mean[2]) * axis[2];
+			minT = pragma::math::min(minT, t);
+			maxT = pragma::math::max(maxT, t);
+		}
+		for(auto c = 0u; c < 3; ++c) {
+			outE0[c] = std::clamp(mean[c] + axis[c] * maxT, 0.f, 255.f);
+			outE1[c] = std::clamp(mean[c] + axis[c] * minT, 0.f, 255.f);
+		}
+	}
+
+	struct ColorBlockEncoding {
+		uint16_t c0 = 0;
+		uint16_t c1 = 0;
+		std::array<uint8_t, 16> indices {};
+		std::array<float, 16> weights {}; // Interpolation weight of c1 for every texel
+		float error = std::numeric_limits<float>::max();
+	};
+	// Quantizes the endpoints and assigns the closest palette entry to every texel
+	ColorBlockEncoding evaluate_color_endpoints(const ColorBlock &block, const Color &e0, const Color &e1)
+	{
+		ColorBlockEncoding encoding {};
+		encoding.c0 = pack_565(e0);
+		encoding.c1 = pack_565(e1);
+		// The order of the endpoints determines the mode; c0 > c1: four colors, otherwise three colors and transparent black
+		if(block.threeColorMode ? (encoding.c0 > encoding.c1) : (encoding.c0 < encoding.c1))
+			std::swap(encoding.c0, encoding.c1);
+		auto p0 = unpack_565(encoding.c0);
+		auto p1 = unpack_565(encoding.c1);
+		std::array<Color, 4> palette;
+		std::array<float, 4> weights;
+		uint32_t numColors;
+		if(!block.threeColorMode && encoding.c0 != encoding.c1) {
+			palette = {p0, p1, lerp(p0, p1, 1.f / 3.f), lerp(p0, p1, 2.f / 3.f)};
+			weights = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+			numColors = 4;
+		}
+		else {
+			palette = {p0, p1, lerp(p0, p1, 0.5f), Color {}};
+			weights = {0.f, 1.f, 0.5f, 0.f};
+			numColors = 3;
+		}
+		encoding.error = 0.f;
+		for(auto i = 0u; i < 16; ++i) {
+			if(block.transparent[i]) {
+				encoding.indices[i] = 3;
+				continue;
+			}
+			auto bestIdx = 0u;
+			auto bestDist = std::numeric_limits<float>::max();
+			for(auto j = 0u; j < numColors; ++j) {
+				auto dist = distance_sq(block.colors[i], palette[j]);
+				if(dist < bestDist) {
+					bestDist = dist;
+					bestIdx = j;
+				}
+			}
+			encoding.indices[i] = bestIdx;
+			encoding.weights[i] = weights[bestIdx];
+			encoding.error += bestDist;
+		}
+		return encoding;
+	}
+	// Least-squares fit of the endpoints for the current index assignment
+	bool refine_color_endpoints(const ColorBlock &block, const ColorBlockEncoding &encoding, Color &outE0, Color &outE1)
+	{
+		float aa = 0.f, bb = 0.f, ab = 0.f;
+		Color ax {}, bx {};
+		for(auto i = 0u; i < 16; ++i) {
+			if(block.transparent[i])
+				continue;
+			auto beta = encoding.weights[i];
+			auto alpha = 1.f - beta;
+			aa += alpha * alpha;
+			bb += beta * beta;
+			ab += alpha * beta;
+			for(auto c = 0u; c < 3; ++c) {
+				ax[c] += alpha * block.colors[i][c];
+				bx[c] += beta * block.colors[i][c];
+			}
+		}
+		auto det = aa * bb - ab * ab;
+		if(std::abs(det) < 1e-6f)
+			return false;
+		for(auto c = 0u; c < 3; ++c) {
+			outE0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.f, 255.f);
+			outE1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.f, 255.f);
+		}
+		return true;
+	}
+
+	void write_u16(uint8_t *dst, uint16_t v)
+	{
+		dst[0] = static_cast<uint8_t>(v & 0xFF);
+		dst[1] = static_cast<uint8_t>(v >> 8);
+	}
+
+	// BC1 color block, also used by BC3 (which always uses the four color mode)
+	void encode_color_block(const Texels &texels, uint8_t *dst, bool useAlpha, util::BlockCompressionQuality quality)
+	{
+		ColorBlock block {};
+		for(auto i = 0u; i < 16; ++i) {
+			block.transparent[i] = useAlpha && texels[i][3] < 128;
+			block.colors[i] = {static_cast<float>(texels[i][0]), static_cast<float>(texels[i][1]), static_cast<float>(texels[i][2])};
+			if(!block.transparent[i])
+				++block.numOpaque;
+		}
+		if(block.numOpaque == 0) {
+			write_u16(dst, 0);
+			write_u16(dst + 2, 0);
+			std::memset(dst + 4, 0xFF, 4);
+			return;
+		}
+		block.threeColorMode = (block.numOpaque < 16);
+
+		Color e0, e1;
+		compute_color_endpoints(block, quality, e0, e1);
+		auto encoding = evaluate_color_endpoints(block, e0, e1);
+		if(quality == util::BlockCompressionQuality::High) {
+			for(auto i = 0u; i < 2 && encoding.error > 0.f; ++i) {
+				if(!refine_color_endpoints(block, encoding, e0, e1))
+					break;
+				auto refined = evaluate_color_endpoints(block, e0, e1);
+				if(refined.error >= encoding.error)
+					break;
+				encoding = refined;
+			}
+		}
+
+		write_u16(dst, encoding.c0);
+		write_u16(dst + 2, encoding.c1);
+		uint32_t indices = 0;
+		for(auto i = 0u; i < 16; ++i)
+			indices |= static_cast<uint32_t>(encoding.indices[i]) << (i * 2);
+		for(auto i = 0u; i < 4; ++i)
+			dst[4 + i] = static_cast<uint8_t>((indices >> (i * 8)) & 0xFF);
+	}
+
+	// Assigns the closest palette entry to every value, returns the total error
+	float assign_single_channel_indices(const std::array<uint8_t, 16> &values, const std::array<float, 8> &palette, std::array<uint8_t, 16> &outIndices)
+	{
+		auto error = 0.f;
+		for(auto i = 0u; i < 16; ++i) {
+			auto bestIdx = 0u;
+			auto bestDist = std::numeric_limits<float>::max();
+			for(auto j = 0u; j < palette.size(); ++j) {
+				auto d = static_cast<float>(values[i]) - palette[j];
+				if(d * d < bestDist) {
+					bestDist = d * d;
+					bestIdx = j;
+				}
+			}
+			outIndices[i] = bestIdx;
+			error += bestDist;
+		}
+		return error;
+	}
+
+	// BC4 block, also used for the alpha of BC3 and both channels of BC5
+	void encode_single_channel_block(const std::array<uint8_t, 16> &values, uint8_t *dst, util::BlockCompressionQuality quality)
+	{
+		auto [itMin, itMax] = std::minmax_element(values.begin(), values.end());
+		// a0 > a1: Eight interpolated values
+		uint8_t a0 = *itMax;
+		uint8_t a1 = *itMin;
+		std::array<float, 8> palette {};
+		palette[0] = a0;
+		palette[1] = a1;
+		for(auto i = 2u; i < 8; ++i)
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7.f;
+		std::array<uint8_t, 16> indices;
+		auto error = assign_single_channel_indices(values, palette, indices);
+
+		if(quality == util::BlockCompressionQuality::High && error > 0.f) {
+			// a0 <= a1: Six interpolated values plus 0 and 255, which is better for blocks with a few extreme values
+			uint8_t minValue = 255;
+			uint8_t maxValue = 0;
+			for(auto v : values) {
+				if(v == 0 || v == 255)
+					continue;
+				minValue = pragma::math::min(minValue, v);
+				maxValue = pragma::math::max(maxValue, v);
+			}
+			if(minValue > maxValue)
+				minValue = maxValue = 0;
+			std::array<float, 8> palette6 {};
+			palette6[0] = minValue;
+			palette6[1] = maxValue;
+			for(auto i = 2u; i < 6; ++i)
+				palette6[i] = ((6 - i) * minValue + (i - 1) * maxValue) / 5.f;
+			palette6[6] = 0.f;
+			palette6[7] = 255.f;
+			std::array<uint8_t, 16> indices6;
+			auto error6 = assign_single_channel_indices(values, palette6, indices6);
+			if(error6 < error) {
+				a0 = minValue;
+				a1 = maxValue;
+				indices = indices6;
+			}
+		}
+
+		dst[0] = a0;
+		dst[1] = a1;
+		uint64_t bits = 0;
+		for(auto i = 0u; i < 16; ++i)
+			bits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+		for(auto i = 0u; i < 6; ++i)
+			dst[2 + i] = static_cast<uint8_t>((bits >> (i * 8)) & 0xFF);
+	}
+
+	void encode_channel(const Texels &texels, uint32_t channel, uint8_t *dst, util::BlockCompressionQuality quality)
+	{
+		std::array<uint8_t, 16> values;
+		for(auto i = 0u; i < 16; ++i)
+			values[i] = texels[i][channel];
+		encode_single_channel_block(values, dst, quality);
+	}
+};
+
+bool util::is_block_compression_supported(Format format)
+{
+	switch(format) {
+	case Format::BC1_RGB_UNorm_Block:
+	case Format::BC1_RGB_SRGB_Block:
+	case Format::BC1_RGBA_UNorm_Block:
+	case Format::BC1_RGBA_SRGB_Block:
+	case Format::BC3_UNorm_Block:
+	case Format::BC3_SRGB_Block:
+	case Format::BC4_UNorm_Block:
+	case Format::BC5_UNorm_Block:
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+void util::compress_blocks(Format format, const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t firstBlockRow, uint32_t numBlockRows, uint8_t *dst, BlockCompressionQuality quality)
+{
+	auto numBlocksX = (width + 3) / 4;
+	auto numBlocksY = (height + 3) / 4;
+	auto blockSize = get_format_info(format).blockSize;
+	auto lastBlockRow = pragma::math::min(firstBlockRow + numBlockRows, numBlocksY);
+	Texels texels;
+	for(auto blockY = firstBlockRow; blockY < lastBlockRow; ++blockY) {
+		for(auto blockX = 0u; blockX < numBlocksX; ++blockX) {
+			load_block(rgba, width, height, blockX, blockY, texels);
+			auto *block = dst + (static_cast<size_t>(blockY) * numBlocksX + blockX) * blockSize;
+			switch(format) {
+			case Format::BC1_RGB_UNorm_Block:
+			case Format::BC1_RGB_SRGB_Block:
+				encode_color_block(texels, block, false, quality);
+				break;
+			case Format::BC1_RGBA_UNorm_Block:
+			case Format::BC1_RGBA_SRGB_Block:
+				encode_color_block(texels, block, true, quality);
+				break;
+			case Format::BC3_UNorm_Block:
+			case Format::BC3_SRGB_Block:
+				encode_channel(texels, 3, block, quality);
+				encode_color_block(texels, block + 8, false, quality);
+				break;
+			case Format::BC4_UNorm_Block:
+				encode_channel(texels, 0, block, quality);
+				break;
+			case Format::BC5_UNorm_Block:
+				encode_channel(texels, 0, block, quality);
+				encode_channel(texels, 1, block + 8, quality);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
@@ -6,6 +6,7 @@ module;
 module pragma.prosper;
 
 import :buffer.buffer;
+import :buffer.staging_uploader;
 
 prosper::IBuffer::IBuffer(IPrContext &context, const util::BufferCreateInfo &bufCreateInfo, DeviceSize startOffset, DeviceSize size) : ContextObject(context), std::enable_shared_from_this<IBuffer>(), m_createInfo {bufCreateInfo}, m_startOffset {startOffset}, m_size {size} {}
 
@@ -81,6 +82,9 @@ bool prosper::IBuffer::Write(Offset offset, Size size, const void *data) const
 	if(m_mappedTmpBuffer != nullptr) {
 		auto &context = const_cast<IPrContext &>(GetContext());
 		auto &buf = m_mappedTmpBuffer->buffer;
+		// Uploads that were queued from other threads before this write must not land after it
+		if(auto *uploader = context.GetStagingUploader())
+			uploader->FlushPendingUploads(*this, offset, size);
 		if(buf->Write(0ull, size, data) == false)
 			return false;
 		util::BufferCopy copyInfo {};
@@ -93,6 +97,12 @@ bool prosper::IBuffer::Write(Offset offset, Size size, const void *data) const
 		return r;
 	}
 	if(pragma::math::is_flag_set(m_createInfo.memoryFeatures, MemoryFeatureFlags::HostAccessable) == false) {
+		auto &context = const_cast<IPrContext &>(GetContext());
+		if(std::this_thread::get_id() != context.GetMainThreadId()) {
+			// Setup command buffers are only available on the main thread, the write will be submitted with the next frame instead
+			auto *uploader = context.GetStagingUploader();
+			return uploader && uploader->Upload(*const_cast<IBuffer *>(this), offset, size, data).has_value();
+		}
 		if(Map(offset, size, BufferUsageFlags::TransferDstBit, BufferUsageFlags::TransferSrcBit, MapFlags::WriteBit, nullptr) == false)
 			return false;
 		Write(offset, size, data);
@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :buffer.buffer_update_queue;
+
+using namespace prosper;
+
+uint64_t BufferUpdateQueue::AppendData(const void *data, uint64_t size)
+{
+	auto offset = m_data.size();
+	m_data.resize(offset + size);
+	std::memcpy(m_data.data() + offset, data, size);
+	return offset;
+}
+
+void BufferUpdateQueue::Add(IBuffer &buffer, uint64_t offset, uint64_t size, const void *data, const detail::BufferUpdateInfo &updateInfo)
+{
+	if(size == 0)
+		return;
+	auto itBuf = m_bufferIndices.find(&buffer);
+	if(itBuf == m_bufferIndices.end()) {
+		itBuf = m_bufferIndices.insert(std::make_pair(&buffer, m_buffers.size())).first;
+		m_buffers.push_back({});
+		m_buffers.back().buffer = &buffer;
+	}
+	auto &updates = m_buffers[itBuf->second];
+	if(updateInfo.srcAccessMask.has_value()) {
+		updates.srcStageMask |= *updateInfo.srcStageMask;
+		updates.srcAccessMask |= *updateInfo.srcAccessMask;
+	}
+	if(updateInfo.postUpdateBarrierStageMask.has_value() && updateInfo.postUpdateBarrierAccessMask.has_value()) {
+		updates.postStageMask |= *updateInfo.postUpdateBarrierStageMask;
+		updates.postAccessMask |= *updateInfo.postUpdateBarrierAccessMask;
+	}
+	++m_numPendingUpdates;
+
+	// Find all ranges that overlap or touch the new range
+	auto &ranges = updates.ranges;
+	auto end = offset + size;
+	auto itEnd = ranges.upper_bound(end);
+	auto itFirst = itEnd;
+	while(itFirst != ranges.begin()) {
+		auto itPrev = std::prev(itFirst);
+		if(itPrev->first + itPrev->second.size < offset)
+			break;
+		itFirst = itPrev;
+	}
+	if(itFirst == itEnd) {
+		ranges[offset] = {size, AppendData(data, size)};
+		return;
+	}
+	if(std::next(itFirst) == itEnd && offset >= itFirst->first) {
+		auto &range = itFirst->second;
+		auto rangeStart = itFirst->first;
+		auto rangeEnd = rangeStart + range.size;
+		if(end <= rangeEnd) {
+			// Fully contained, overwrite the existing data
+			std::memcpy(m_data.data() + range.dataOffset + (offset - rangeStart), data, size);
+			return;
+		}
+		if(range.dataOffset + range.size == m_data.size()) {
+			// The range's data is at the end of the blob and can be extended in place (common case for sequential updates)
+			auto overlap = rangeEnd - offset;
+			std::memcpy(m_data.data() + range.dataOffset + (offset - rangeStart), data, overlap);
+			AppendData(static_cast<const uint8_t *>(data) + overlap, size - overlap);
+			range.size = end - rangeStart;
+			return;
+		}
+	}
+
+	// Merge all affected ranges into a new one, the new data takes precedence
+	auto itLast = std::prev(itEnd);
+	auto mergedStart = pragma::math::min(offset, itFirst->first);
+	auto mergedEnd = pragma::math::max(end, itLast->first + itLast->second.size);
+	auto dataOffset = m_data.size();
+	m_data.resize(dataOffset + (mergedEnd - mergedStart));
+	for(auto it = itFirst; it != itEnd; ++it)
+		std::memcpy(m_data.data() + dataOffset + (it->first - mergedStart), m_data.data() + it->second.dataOffset, it->second.size);
+	std::memcpy(m_data.data() + dataOffset + (offset - mergedStart), data, size);
+	ranges.erase(itFirst, itEnd);
+	ranges[mergedStart] = {mergedEnd - mergedStart, dataOffset};
+}
+
+bool BufferUpdateQueue::Record(ICommandBuffer &cmd)
+{
+	m_stats = {};
+	m_stats.numUpdates = m_numPendingUpdates;
+	auto fRecordBarrier = [this, &cmd](bool preUpdate) {
+		util::PipelineBarrierInfo barrierInfo {};
+		barrierInfo.srcStageMask = preUpdate ? PipelineStageFlags::None : PipelineStageFlags::TransferBit;
+		barrierInfo.dstStageMask = preUpdate ? PipelineStageFlags::TransferBit : PipelineStageFlags::None;
+		for(auto &updates : m_buffers) {
+			auto stageMask = preUpdate ? updates.srcStageMask : updates.postStageMask;
+			if(stageMask == PipelineStageFlags::None || updates.ranges.empty())
+				continue;
+			(preUpdate ? barrierInfo.srcStageMask : barrierInfo.dstStageMask) |= stageMask;
+			// One barrier per buffer, covering all of its updated ranges
+			auto start = updates.ranges.begin()->first;
+			auto &last = *updates.ranges.rbegin();
+			util::BufferBarrierInfo bufBarrier {};
+			bufBarrier.srcAccessMask = preUpdate ? updates.srcAccessMask : AccessFlags::TransferWriteBit;
+			bufBarrier.dstAccessMask = preUpdate ? AccessFlags::TransferWriteBit : updates.postAccessMask;
+			bufBarrier.offset = updates.buffer->GetStartOffset() + start;
+			bufBarrier.size = (last.first + last.second.size) - start;
+			barrierInfo.bufferBarriers.push_back(util::create_buffer_barrier(bufBarrier, *updates.buffer));
+		}
+		if(barrierInfo.bufferBarriers.empty())
+			return true;
+		++m_stats.numRecordedBarriers;
+		return cmd.RecordPipelineBarrier(barrierInfo);
+	};
+
+	auto success = cmd.FlushBarriers();
+	success = fRecordBarrier(true) && success;
+	for(auto &updates : m_buffers) {
+		for(auto &[offset, range] : updates.ranges) {
+			const auto maxUpdateSize = 65'536ull; // Maximum size allowed per vkCmdUpdateBuffer-call (see https://www.khronos.org/registry/vulkan/specs/1.1-extensions/man/html/vkCmdUpdateBuffer.html)
+			for(auto dataOffset = decltype(range.size) {0u}; dataOffset < range.size; dataOffset += maxUpdateSize) {
+				auto updateSize = pragma::math::min(maxUpdateSize, range.size - dataOffset);
+				success = cmd.RecordUpdateBuffer(*updates.buffer, offset + dataOffset, updateSize, m_data.data() + range.dataOffset + dataOffset) && success;
+				++m_stats.numRecordedUpdates;
+			}
+		}
+	}
+	success = fRecordBarrier(false) && success;
+	Clear();
+	return success;
+}
+
+void BufferUpdateQueue::Clear()
+{
+	m_data.clear();
+	m_buffers.clear();
+	m_bufferIndices.clear();
+	m_numPendingUpdates = 0;
+}
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :buffer.device_image_buffer_defragmenter;
+
+using namespace prosper;
+
+DeviceImageBufferDefragmenter::DeviceImageBufferDefragmenter(IPrContext &context, std::vector<std::shared_ptr<IDynamicResizableBuffer>> &buffers) : m_context {context}, m_buffers {buffers} {}
+
+bool DeviceImageBufferDefragmenter::Step()
+{
+	auto released = false;
+	// At least one buffer is kept, to avoid having to re-allocate it for the next image
+	for(auto it = m_buffers.begin(); it != m_buffers.end() && m_buffers.size() > 1;) {
+		if((*it)->GetAllocatedSubBuffers().empty() == false) {
+			++it;
+			continue;
+		}
+		// The memory may still be referenced by commands of frames that are in flight
+		m_context.KeepResourceAliveUntilPresentationComplete(*it);
+		it = m_buffers.erase(it);
+		++m_stats.numReleasedBuffers;
+		released = true;
+	}
+	return released;
+}
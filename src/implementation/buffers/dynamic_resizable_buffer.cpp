@@ -89,87 +89,110 @@ static void test_dynamic_resizable_buffer()
 
 IDynamicResizableBuffer::IDynamicResizableBuffer(IPrContext &context, IBuffer &buffer, const util::BufferCreateInfo &createInfo) : IResizableBuffer {buffer}
 {
-	m_freeRanges.push_back({0ull, createInfo.size});
+	InsertFreeMemoryRange(0ull, createInfo.size);
 	m_alignment = context.CalcBufferAlignment(createInfo.usageFlags);
 }
 
-void IDynamicResizableBuffer::InsertFreeMemoryRange(std::list<Range>::iterator itWhere, DeviceSize startOffset, DeviceSize size)
+void IDynamicResizableBuffer::InsertFreeMemoryRange(DeviceSize startOffset, DeviceSize size)
 {
-	if(itWhere == m_freeRanges.end()) {
-		if(m_freeRanges.empty() == false) {
-			auto &range = m_freeRanges.back();
-			if(range.startOffset + range.size == startOffset) {
-				range.size += size;
-				return;
-			}
-		}
-		m_freeRanges.push_back({startOffset, size});
-		return;
-	}
-	if(itWhere != m_freeRanges.begin()) {
-		auto itPrev = itWhere;
-		--itPrev;
-		if(itPrev->startOffset + itPrev->size == startOffset) {
-			itPrev->size += size;
-			if(itPrev->startOffset + itPrev->size == itWhere->startOffset) {
-				itPrev->size += itWhere->size;
-				m_freeRanges.erase(itWhere);
-			}
-			return;
-		}
-		m_freeRanges.insert(itWhere, {startOffset, size});
-		return;
-	}
-	if(startOffset + size == itWhere->startOffset) {
-		itWhere->startOffset = startOffset;
-		itWhere->size += size;
-		return;
-	}
-	m_freeRanges.push_front({startOffset, size});
+	m_freeRanges.insert(std::make_pair(startOffset, size));
+	m_freeRangesBySize.insert(std::make_pair(size, startOffset));
+	m_freeSize += size;
+}
+IDynamicResizableBuffer::FreeRangeMap::iterator IDynamicResizableBuffer::EraseFreeMemoryRange(FreeRangeMap::iterator it)
+{
+	m_freeRangesBySize.erase(std::make_pair(it->second, it->first));
+	m_freeSize -= it->second;
+	return m_freeRanges.erase(it);
 }
 void IDynamicResizableBuffer::MarkMemoryRangeAsFree(DeviceSize startOffset, DeviceSize size)
 {
 	if(size == 0ull)
 		return;
-	auto it = std::find_if(m_freeRanges.begin(), m_freeRanges.end(), [startOffset, size](const Range &range) { return startOffset < range.startOffset; });
-	InsertFreeMemoryRange(it, startOffset, size);
+	// Merge with adjacent free ranges
+	auto itNext = m_freeRanges.lower_bound(startOffset);
+	if(itNext != m_freeRanges.begin()) {
+		auto itPrev = std::prev(itNext);
+		if(itPrev->first + itPrev->second == startOffset) {
+			startOffset = itPrev->first;
+			size += itPrev->second;
+			EraseFreeMemoryRange(itPrev);
+		}
+	}
+	if(itNext != m_freeRanges.end() && startOffset + size == itNext->first) {
+		size += itNext->second;
+		EraseFreeMemoryRange(itNext);
+	}
+	InsertFreeMemoryRange(startOffset, size);
 }
-std::list<IDynamicResizableBuffer::Range>::iterator IDynamicResizableBuffer::FindFreeRange(DeviceSize size, uint32_t alignment)
+IDynamicResizableBuffer::FreeRangeMap::iterator IDynamicResizableBuffer::FindFreeRange(DeviceSize size, uint32_t alignment)
 {
-	// Find the smallest available space that can fit the requested size (including alignment padding)
-	auto itMin = m_freeRanges.end();
-	auto minSize = std::numeric_limits<DeviceSize>::max();
-	for(auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
-		auto &range = *it;
-		auto reqSize = size + util::get_offset_alignment_padding(range.startOffset, alignment);
-		if(reqSize > range.size || range.size > minSize)
+	// Any range of at least size + alignment - 1 bytes fits regardless of where it starts, so look up the
+	// smallest of those first. Ranges are ordered by size, so this is a single lookup.
+	auto maxPadding = (alignment > 0u) ? static_cast<DeviceSize>(alignment - 1u) : DeviceSize {0ull};
+	auto it = m_freeRangesBySize.lower_bound(std::make_pair(size + maxPadding, DeviceSize {0ull}));
+	if(it != m_freeRangesBySize.end())
+		return m_freeRanges.find(it->second);
+
+	// Otherwise only the ranges in [size, size + alignment - 1) are left, which may or may not fit depending on their alignment padding
+	for(it = m_freeRangesBySize.lower_bound(std::make_pair(size, DeviceSize {0ull})); it != m_freeRangesBySize.end(); ++it) {
+		auto &[rangeSize, rangeStartOffset] = *it;
+		auto reqSize = size + util::get_offset_alignment_padding(rangeStartOffset, alignment);
+		if(reqSize > rangeSize)
 			continue;
-		minSize = range.size;
-		itMin = it;
+		return m_freeRanges.find(rangeStartOffset);
 	}
-	return itMin;
+	return m_freeRanges.end();
+}
+
+DeviceSize IDynamicResizableBuffer::ReserveFreeRange(FreeRangeMap::iterator it, DeviceSize size, uint32_t alignment)
+{
+	auto rangeStartOffset = it->first;
+	auto rangeSize = it->second;
+	EraseFreeMemoryRange(it);
+	auto offset = rangeStartOffset + util::get_offset_alignment_padding(rangeStartOffset, alignment);
+
+	if(offset > rangeStartOffset)
+		MarkMemoryRangeAsFree(rangeStartOffset, offset - rangeStartOffset); // Anterior range
+	if(offset + size < rangeStartOffset + rangeSize)
+		MarkMemoryRangeAsFree(offset + size, (rangeStartOffset + rangeSize) - (offset + size)); // Posterior range
+	return offset;
+}
+
+void IDynamicResizableBuffer::AddSubBuffer(IBuffer &subBuffer)
+{
+	subBuffer.m_parentSlot = m_allocatedSubBuffers.size();
+	m_allocatedSubBuffers.push_back(&subBuffer);
+}
+void IDynamicResizableBuffer::RemoveSubBuffer(IBuffer &subBuffer)
+{
+	// Swap-and-pop: The last sub-buffer is moved into the freed slot, so the list stays dense
+	auto slot = subBuffer.m_parentSlot;
+	assert(slot < m_allocatedSubBuffers.size() && m_allocatedSubBuffers[slot] == &subBuffer);
+	auto *lastSubBuffer = m_allocatedSubBuffers.back();
+	m_allocatedSubBuffers[slot] = lastSubBuffer;
+	lastSubBuffer->m_parentSlot = slot;
+	m_allocatedSubBuffers.pop_back();
+	subBuffer.m_parentSlot = INVALID_INDEX;
 }
 
 const std::vector<IBuffer *> &IDynamicResizableBuffer::GetAllocatedSubBuffers() const { return m_allocatedSubBuffers; }
 uint64_t IDynamicResizableBuffer::GetFreeSize() const
 {
-	auto size = 0ull;
-	m_bufferMutex.lock();
-	for(auto &range : m_freeRanges)
-		size += range.size;
-	m_bufferMutex.unlock();
-	return size;
+	std::scoped_lock lock {m_bufferMutex};
+	return m_freeSize;
 }
 float IDynamicResizableBuffer::GetFragmentationPercent() const
 {
-	m_bufferMutex.lock();
+	std::scoped_lock lock {m_bufferMutex};
 	auto size = GetSize();
-	auto fragmentSize = 0ull;
-	for(auto &range : m_freeRanges) {
-		if(range.startOffset + range.size < size)
-			fragmentSize += range.size;
+	auto fragmentSize = m_freeSize;
+	// The trailing free range doesn't count towards fragmentation
+	if(m_freeRanges.empty() == false) {
+		auto &[startOffset, rangeSize] = *m_freeRanges.rbegin();
+		if(startOffset + rangeSize >= size)
+			fragmentSize -= rangeSize;
 	}
-	m_bufferMutex.unlock();
 	return fragmentSize / static_cast<double>(size);
 }
 
@@ -205,8 +228,12 @@ void IDynamicResizableBuffer::DebugPrint(std::stringstream &strFilledData, std::
 			++itRange;
 		}
 	};
+	std::vector<Range> freeRanges;
+	freeRanges.reserve(m_freeRanges.size());
+	for(auto &[startOffset, rangeSize] : m_freeRanges)
+		freeRanges.push_back({startOffset, rangeSize});
 	fPrintRangeData(allocatedRanges, strFilledData);
-	fPrintRangeData(m_freeRanges, strFreeData);
+	fPrintRangeData(freeRanges, strFreeData);
 
 	if(bufferData == nullptr)
 		return;
@@ -231,18 +258,8 @@ bool IDynamicResizableBuffer::EnsureCapacity(DeviceSize requestSize, uint32_t al
 	if(!ReallocateMemory(requiredSize))
 		return false;
 
-	// Update free range
-	auto bNewRange = true;
-	if(m_freeRanges.empty() == false) {
-		auto &rangeLast = m_freeRanges.back();
-		if(rangeLast.startOffset + rangeLast.size == oldSize) {
-			rangeLast.size = m_baseSize - rangeLast.startOffset;
-			bNewRange = false;
-		}
-	}
-	if(bNewRange == true)
-		m_freeRanges.push_back({oldSize, m_baseSize - oldSize});
-	//
+	// Update free range (merges with the trailing free range, if there is one)
+	MarkMemoryRangeAsFree(oldSize, m_baseSize - oldSize);
 
 	RunReallocationCallbacks();
 	return true;
@@ -254,40 +271,25 @@ std::shared_ptr<IBuffer> IDynamicResizableBuffer::AllocateBuffer(DeviceSize requ
 	if(requestSize == 0ull)
 		return nullptr;
 	std::scoped_lock lock {m_bufferMutex};
-	auto offset = 0ull;
 	auto it = FindFreeRange(requestSize, alignment);
-	if(it != m_freeRanges.end()) {
-		offset = it->startOffset;
-		auto rangeStartOffset = it->startOffset;
-		auto rangeSize = it->size;
-		m_freeRanges.erase(it);
-		offset += util::get_offset_alignment_padding(offset, alignment);
-
-		if(offset > rangeStartOffset)
-			MarkMemoryRangeAsFree(rangeStartOffset, offset - rangeStartOffset); // Anterior range
-		if(offset + requestSize < rangeStartOffset + rangeSize)
-			MarkMemoryRangeAsFree(offset + requestSize, (rangeStartOffset + rangeSize) - (offset + requestSize)); // Posterior range
-	}
-	else {
+	if(it == m_freeRanges.end()) {
 		if(reallocateIfNoSpaceAvailable == false || EnsureCapacity(requestSize, alignment) == false)
 			return nullptr;
 		return AllocateBuffer(requestSize, alignment, data);
 	}
+	auto offset = ReserveFreeRange(it, requestSize, alignment);
 
 	auto pThis = std::dynamic_pointer_cast<IDynamicResizableBuffer>(shared_from_this());
 
 	auto subBuffer = CreateSubBuffer(offset, requestSize, [pThis, requestSize](IBuffer &subBuffer) {
 		std::scoped_lock lock {pThis->m_bufferMutex};
-		auto it = std::find_if(pThis->m_allocatedSubBuffers.begin(), pThis->m_allocatedSubBuffers.end(), [&subBuffer](const IBuffer *subBufferOther) { return subBufferOther == &subBuffer; });
-		pThis->m_allocatedSubBuffers.erase(it);
+		pThis->RemoveSubBuffer(subBuffer);
 		pThis->MarkMemoryRangeAsFree(subBuffer.GetStartOffset(), requestSize);
 	});
 	assert(subBuffer);
 	subBuffer->SetParent(*this);
 	if(data != nullptr)
 		subBuffer->Write(0ull, requestSize, data);
-	if(m_allocatedSubBuffers.size() == m_allocatedSubBuffers.capacity())
-		m_allocatedSubBuffers.reserve(m_allocatedSubBuffers.size() + 50u);
-	m_allocatedSubBuffers.push_back(subBuffer.get());
+	AddSubBuffer(*subBuffer);
 	return subBuffer;
 }
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :buffer.frame_ring_allocator;
+
+using namespace prosper;
+
+FrameRingAllocator::FrameRingAllocator(IPrContext &context, DeviceSize segmentSize) : m_context {context}, m_numSegments {pragma::math::max<uint8_t>(context.GetMaxNumberOfFramesInFlight(), 1)}
+{
+	util::BufferCreateInfo createInfo {};
+	createInfo.debugName = "frame_ring_buffer";
+	createInfo.memoryFeatures = MemoryFeatureFlags::HostAccessable | MemoryFeatureFlags::Dynamic;
+	createInfo.flags |= util::BufferCreateInfo::Flags::Persistent;
+	createInfo.usageFlags = BufferUsageFlags::IndexBufferBit | BufferUsageFlags::StorageBufferBit | BufferUsageFlags::TransferDstBit | BufferUsageFlags::TransferSrcBit | BufferUsageFlags::UniformBufferBit | BufferUsageFlags::VertexBufferBit;
+	m_minAlignment = pragma::math::max<DeviceSize>(context.CalcBufferAlignment(createInfo.usageFlags), 1);
+	// Keep the segments aligned, so that alignment within a segment carries over to the buffer
+	segmentSize += (m_minAlignment - (segmentSize % m_minAlignment)) % m_minAlignment;
+	createInfo.size = segmentSize * m_numSegments;
+	m_buffer = context.CreateBuffer(createInfo);
+	void *ptr = nullptr;
+	if(!m_buffer || !m_buffer->Map(0ull, createInfo.size, IBuffer::MapFlags::WriteBit | IBuffer::MapFlags::PersistentBit, &ptr) || !ptr) {
+		context.Log("Failed to create frame ring buffer!", pragma::util::LogSeverity::Warning);
+		m_buffer = nullptr;
+		return;
+	}
+	m_mappedData = static_cast<uint8_t *>(ptr);
+	m_segmentSize = segmentSize;
+	m_segments = std::make_unique<Segment[]>(m_numSegments);
+}
+
+FrameRingAllocator::~FrameRingAllocator()
+{
+	if(m_buffer)
+		m_buffer->Unmap();
+}
+
+void FrameRingAllocator::BeginFrame(uint8_t frameResourceIndex)
+{
+	if(!m_segments)
+		return;
+	auto idx = frameResourceIndex % m_numSegments;
+	m_segments[idx].offset.store(0, std::memory_order_relaxed);
+	m_currentSegment.store(idx, std::memory_order_release);
+}
+
+void FrameRingAllocator::EndFrame() { m_currentSegment.store(NO_SEGMENT, std::memory_order_release); }
+
+FrameRingAllocator::Allocation FrameRingAllocator::Allocate(DeviceSize size, uint32_t alignment, const void *data)
+{
+	if(!m_segments || size == 0)
+		return {};
+	auto effectiveAlignment = pragma::math::max<DeviceSize>(alignment, m_minAlignment);
+	auto segmentIdx = m_currentSegment.load(std::memory_order_acquire);
+	if(segmentIdx == NO_SEGMENT) {
+		m_numRejected.fetch_add(1, std::memory_order_relaxed);
+		return {};
+	}
+	auto &segment = m_segments[segmentIdx];
+	auto offset = segment.offset.load(std::memory_order_relaxed);
+	DeviceSize alignedOffset;
+	DeviceSize end;
+	do {
+		alignedOffset = offset + ((effectiveAlignment - (offset % effectiveAlignment)) % effectiveAlignment);
+		end = alignedOffset + size;
+		if(end > m_segmentSize) {
+			m_numOverflows.fetch_add(1, std::memory_order_relaxed);
+			return {};
+		}
+	} while(!segment.offset.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+
+	m_numAllocations.fetch_add(1, std::memory_order_relaxed);
+	auto highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+	while(end > highWaterMark && !m_highWaterMark.compare_exchange_weak(highWaterMark, end, std::memory_order_relaxed))
+		;
+
+	Allocation allocation {};
+	allocation.buffer = m_buffer.get();
+	allocation.offset = segmentIdx * m_segmentSize + alignedOffset;
+	allocation.size = size;
+	allocation.data = m_mappedData + allocation.offset;
+	if(data)
+		std::memcpy(allocation.data, data, size);
+	return allocation;
+}
+
+std::shared_ptr<IBuffer> FrameRingAllocator::AllocateBuffer(DeviceSize size, uint32_t alignment, const void *data)
+{
+	auto allocation = Allocate(size, alignment, data);
+	if(!allocation.IsValid())
+		return nullptr;
+	auto subBuffer = m_buffer->CreateSubBuffer(allocation.offset, allocation.size);
+	if(subBuffer)
+		subBuffer->SetParent(*m_buffer);
+	return subBuffer;
+}
+
+FrameRingAllocator::Stats FrameRingAllocator::GetStats() const
+{
+	Stats stats {};
+	stats.highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+	stats.numAllocations = m_numAllocations.load(std::memory_order_relaxed);
+	stats.numOverflows = m_numOverflows.load(std::memory_order_relaxed);
+	stats.numRejected = m_numRejected.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void FrameRingAllocator::ResetStats()
+{
+	m_highWaterMark = 0;
+	m_numAllocations = 0;
+	m_numOverflows = 0;
+	m_numRejected = 0;
+}
@@ -0,0 +1,157 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :buffer.image_readback;
+
+using namespace prosper;
+
+ImageReadback::ImageReadback(IPrContext &context) : m_context {context} {}
+
+ImageReadback::~ImageReadback()
+{
+	// Readbacks that are still in flight are completed, queued readbacks are discarded
+	std::vector<IFence *> fences;
+	fences.reserve(m_submissions.size());
+	for(auto &submission : m_submissions) {
+		if(submission.fence)
+			fences.push_back(submission.fence.get());
+	}
+	if(!fences.empty())
+		m_context.WaitForFences(fences);
+	Poll();
+	for(auto &request : m_queuedRequests) {
+		if(request.onComplete)
+			request.onComplete(nullptr);
+	}
+}
+
+void ImageReadback::Enqueue(Request &&request)
+{
+	std::scoped_lock lock {m_queueMutex};
+	m_queuedRequests.push_back(std::move(request));
+	++m_stats.numRequests;
+}
+
+std::shared_ptr<IFence> ImageReadback::AcquireFence()
+{
+	if(m_freeFences.empty())
+		return m_context.CreateFence();
+	auto fence = std::move(m_freeFences.back());
+	m_freeFences.pop_back();
+	fence->Reset();
+	return fence;
+}
+
+std::optional<ImageReadback::StagingBuffer> ImageReadback::AcquireStagingBuffer(DeviceSize size)
+{
+	uint32_t sizeClass = 0;
+	auto classSize = MIN_STAGING_BUFFER_SIZE;
+	while(classSize < size) {
+		classSize <<= 1;
+		++sizeClass;
+	}
+	if(sizeClass < m_freeStagingBuffers.size() && !m_freeStagingBuffers[sizeClass].empty()) {
+		auto &freeBuffers = m_freeStagingBuffers[sizeClass];
+		StagingBuffer stagingBuffer {std::move(freeBuffers.back()), sizeClass};
+		freeBuffers.pop_back();
+		++m_stats.numStagingBuffersReused;
+		return stagingBuffer;
+	}
+	util::BufferCreateInfo bufCreateInfo {};
+	bufCreateInfo.debugName = "image_readback_buffer";
+	bufCreateInfo.memoryFeatures = MemoryFeatureFlags::GPUToCPU;
+	bufCreateInfo.size = classSize;
+	bufCreateInfo.usageFlags = BufferUsageFlags::TransferDstBit;
+	auto buf = m_context.CreateBuffer(bufCreateInfo);
+	if(!buf)
+		return {};
+	++m_stats.numStagingBuffersCreated;
+	return StagingBuffer {std::move(buf), sizeClass};
+}
+
+void ImageReadback::ReleaseStagingBuffer(StagingBuffer &&stagingBuffer)
+{
+	if(stagingBuffer.sizeClass >= m_freeStagingBuffers.size())
+		m_freeStagingBuffers.resize(stagingBuffer.sizeClass + 1);
+	m_freeStagingBuffers[stagingBuffer.sizeClass].push_back(std::move(stagingBuffer.buffer));
+}
+
+void ImageReadback::Flush()
+{
+	if(std::this_thread::get_id() != m_context.GetMainThreadId())
+		throw std::logic_error {"Image readbacks can only be flushed on the main thread!"};
+	std::vector<Request> requests;
+	{
+		std::scoped_lock lock {m_queueMutex};
+		if(m_queuedRequests.empty())
+			return;
+		requests = std::move(m_queuedRequests);
+		m_queuedRequests.clear();
+	}
+
+	uint32_t queueFamilyIndex;
+	auto cmd = m_context.AllocatePrimaryLevelCommandBuffer(QueueFamilyType::Universal, queueFamilyIndex);
+	if(!cmd || !cmd->StartRecording(true, false)) {
+		m_context.Log("Failed to record image readbacks! " + pragma::util::to_string(requests.size()) + " readbacks have been discarded.", pragma::util::LogSeverity::Error);
+		for(auto &request : requests) {
+			if(request.onComplete)
+				request.onComplete(nullptr);
+		}
+		return;
+	}
+	Submission submission {};
+	submission.readbacks.reserve(requests.size());
+	std::vector<Request> failedRequests;
+	for(auto &request : requests) {
+		auto stagingBuffer = AcquireStagingBuffer(request.size);
+		if(!stagingBuffer || !request.record(*cmd, *stagingBuffer->buffer)) {
+			if(stagingBuffer)
+				ReleaseStagingBuffer(std::move(*stagingBuffer));
+			failedRequests.push_back(std::move(request));
+			continue;
+		}
+		cmd->RecordBufferBarrier(*stagingBuffer->buffer, PipelineStageFlags::TransferBit, PipelineStageFlags::HostBit, AccessFlags::TransferWriteBit, AccessFlags::HostReadBit);
+		submission.readbacks.push_back({std::move(request), std::move(*stagingBuffer)});
+	}
+	if(cmd->StopRecording() && !submission.readbacks.empty()) {
+		submission.fence = AcquireFence();
+		submission.cmd = cmd;
+		m_context.SubmitCommandBuffer(*cmd, QueueFamilyType::Universal, false, submission.fence.get());
+		++m_stats.numSubmissions;
+		m_submissions.push_back(std::move(submission));
+	}
+	else {
+		for(auto &readback : submission.readbacks) {
+			ReleaseStagingBuffer(std::move(readback.stagingBuffer));
+			failedRequests.push_back(std::move(readback.request));
+		}
+	}
+	for(auto &request : failedRequests) {
+		if(request.onComplete)
+			request.onComplete(nullptr);
+	}
+}
+
+void ImageReadback::Poll()
+{
+	// Submissions complete in order, so there is no need to look past the first one that hasn't
+	while(!m_submissions.empty()) {
+		auto &submission = m_submissions.front();
+		if(!submission.fence->IsSet())
+			break;
+		auto completed = std::move(submission);
+		m_submissions.pop_front();
+		m_freeFences.push_back(std::move(completed.fence));
+		for(auto &readback : completed.readbacks) {
+			if(readback.request.onComplete)
+				readback.request.onComplete(readback.stagingBuffer.buffer.get());
+			ReleaseStagingBuffer(std::move(readback.stagingBuffer));
+		}
+	}
+}
+
+void ImageReadback::ClearStagingBuffers() { m_freeStagingBuffers.clear(); }
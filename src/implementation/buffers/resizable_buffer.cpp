@@ -22,7 +22,15 @@ bool IResizableBuffer::ReallocateMemory(size_t requiredSize)
 	if(!IsResizable())
 		return false;
 	auto &context = GetContext();
-	if(m_reallocationBehavior == ReallocationBehavior::DeviceWaitIdle)
+	auto reallocationBehavior = m_reallocationBehavior;
+	if(reallocationBehavior == ReallocationBehavior::CopyOnGPU) {
+		constexpr auto requiredUsageFlags = BufferUsageFlags::TransferSrcBit | BufferUsageFlags::TransferDstBit;
+		if((GetUsageFlags() & requiredUsageFlags) != requiredUsageFlags) {
+			context.Log("Prosper buffer '" + GetDebugName() + "' can not be reallocated on the GPU because it is missing the transfer usage flags! Falling back to device wait...", pragma::util::LogSeverity::Warning);
+			reallocationBehavior = ReallocationBehavior::DeviceWaitIdle;
+		}
+	}
+	if(reallocationBehavior == ReallocationBehavior::DeviceWaitIdle)
 		context.WaitIdle();
 	context.Log("Reallocating prosper buffer '" + GetDebugName() + "' of size " + pragma::util::get_pretty_bytes(m_baseSize) + " to " + pragma::util::get_pretty_bytes(requiredSize) + "...");
 
@@ -34,20 +42,76 @@ bool IResizableBuffer::ReallocateMemory(size_t requiredSize)
 	createInfo.size = m_baseSize;
 	auto newBuffer = context.CreateBuffer(createInfo);
 	assert(newBuffer);
-	std::vector<uint8_t> oldData(oldSize);
-	Read(0ull, oldData.size(), oldData.data());
-	if(m_reallocationBehavior == ReallocationBehavior::SafelyFreeOldBuffer)
-		ReleaseBufferSafely();
+	if(!newBuffer) {
+		m_baseSize = oldSize;
+		return false;
+	}
+	std::vector<uint8_t> oldData;
+	if(reallocationBehavior == ReallocationBehavior::CopyOnGPU) {
+		// Host writes to the new buffer would not be ordered with the copy, so we have to wait for it if the buffer is host-accessible.
+		// The same applies if the old buffer can't be kept alive until the copy has completed.
+		auto waitForCopy = !CanReleaseBufferSafely() || pragma::math::is_flag_set(m_createInfo.memoryFeatures, MemoryFeatureFlags::HostAccessable);
+		if(!CopyToReallocatedBuffer(*newBuffer, oldSize, waitForCopy)) {
+			m_baseSize = oldSize;
+			return false;
+		}
+		if(!waitForCopy)
+			ReleaseBufferSafely();
+	}
+	else {
+		oldData.resize(oldSize);
+		Read(0ull, oldData.size(), oldData.data());
+		if(reallocationBehavior == ReallocationBehavior::SafelyFreeOldBuffer)
+			ReleaseBufferSafely();
+	}
 
-	for(auto *subBuffer : m_allocatedSubBuffers)
+	for(auto *subBuffer : m_allocatedSubBuffers) {
+		if(!subBuffer)
+			continue; // Free slot
 		subBuffer->RecreateInternalSubBuffer(*newBuffer);
-	newBuffer->Write(0ull, oldData.size(), oldData.data());
+	}
+	if(!oldData.empty())
+		newBuffer->Write(0ull, oldData.size(), oldData.data());
 	MoveInternalBuffer(*newBuffer);
 	m_size = m_baseSize;
 	newBuffer = nullptr;
 	return true;
 }
 
+bool IResizableBuffer::CopyToReallocatedBuffer(IBuffer &newBuffer, DeviceSize size, bool waitForCompletion)
+{
+	auto &context = GetContext();
+	uint32_t queueFamilyIndex;
+	auto cmd = context.AllocatePrimaryLevelCommandBuffer(QueueFamilyType::Universal, queueFamilyIndex);
+	if(!cmd || !cmd->StartRecording(true, false))
+		return false;
+	// Previous writes to the old buffer have to be complete before the copy, and the copy has to be complete before the new buffer is used
+	auto res = cmd->RecordBufferBarrier(*this, PipelineStageFlags::AllCommands, PipelineStageFlags::TransferBit, AccessFlags::MemoryWriteBit, AccessFlags::TransferReadBit, 0ull, size);
+	if(res) {
+		util::BufferCopy copyInfo {};
+		copyInfo.size = size;
+		res = cmd->RecordCopyBuffer(copyInfo, *this, newBuffer)
+		  && cmd->RecordBufferBarrier(newBuffer, PipelineStageFlags::TransferBit, PipelineStageFlags::AllCommands, AccessFlags::TransferWriteBit, AccessFlags::MemoryReadBit | AccessFlags::MemoryWriteBit, 0ull, size);
+	}
+	cmd->StopRecording();
+	if(!res)
+		return false;
+	if(!waitForCompletion) {
+		// Anything that is submitted to the universal queue afterwards, including setup commands, staging uploads and the frame whose
+		// presentation releases the old buffer, executes after the copy.
+		context.SubmitCommandBuffer(*cmd, QueueFamilyType::Universal, false);
+		context.SetDeviceBusy(true);
+		context.KeepResourceAliveUntilPresentationComplete(cmd);
+		return true;
+	}
+	// This only waits for the work that has already been submitted to the queue, not for the entire device
+	auto fence = context.CreateFence();
+	if(!fence)
+		return false;
+	context.SubmitCommandBuffer(*cmd, QueueFamilyType::Universal, false, fence.get());
+	return context.WaitForFence(*fence) == Result::Success;
+}
+
 void IResizableBuffer::RunReallocationCallbacks()
 {
 	for(auto *subBuffer : m_allocatedSubBuffers) {
@@ -0,0 +1,372 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#include <cassert>
+
+module pragma.prosper;
+
+import :buffer.staging_uploader;
+
+using namespace prosper;
+
+StagingUploader::StagingUploader(IPrContext &context, const CreateInfo &createInfo) : m_context {context}, m_queueFamilyType {createInfo.queueFamilyType}
+{
+	util::BufferCreateInfo bufCreateInfo {};
+	bufCreateInfo.debugName = "staging_upload_buffer";
+	bufCreateInfo.memoryFeatures = MemoryFeatureFlags::HostAccessable | MemoryFeatureFlags::HostCoherent | MemoryFeatureFlags::Dynamic;
+	bufCreateInfo.size = createInfo.ringBufferSize;
+	bufCreateInfo.flags |= util::BufferCreateInfo::Flags::Persistent;
+	bufCreateInfo.usageFlags = BufferUsageFlags::TransferSrcBit;
+	m_ringBuffer = context.CreateBuffer(bufCreateInfo);
+	void *ptr = nullptr;
+	if(!m_ringBuffer || !m_ringBuffer->Map(0ull, bufCreateInfo.size, IBuffer::MapFlags::WriteBit | IBuffer::MapFlags::PersistentBit, &ptr) || !ptr) {
+		context.Log("Failed to create staging upload buffer! Uploads will be written synchronously.", pragma::util::LogSeverity::Warning);
+		m_ringBuffer = nullptr;
+		return;
+	}
+	m_ringData = static_cast<uint8_t *>(ptr);
+	m_ringBufferSize = bufCreateInfo.size;
+}
+
+StagingUploader::~StagingUploader()
+{
+	if(!m_pendingRegions.empty()) {
+		if(std::this_thread::get_id() == m_context.GetMainThreadId())
+			Flush();
+		else
+			m_context.Log("Staging uploader was destroyed outside of the main thread! " + pragma::util::to_string(m_pendingRegions.size()) + " pending uploads have been discarded.", pragma::util::LogSeverity::Error);
+	}
+	if(!m_submissions.empty()) {
+		std::vector<IFence *> fences;
+		fences.reserve(m_submissions.size());
+		for(auto &submission : m_submissions) {
+			if(submission.fence)
+				fences.push_back(submission.fence.get());
+		}
+		if(!fences.empty())
+			m_context.WaitForFences(fences);
+	}
+	if(m_ringBuffer)
+		m_ringBuffer->Unmap();
+}
+
+std::shared_ptr<IFence> StagingUploader::AcquireFence()
+{
+	if(m_freeFences.empty())
+		return m_context.CreateFence();
+	auto fence = std::move(m_freeFences.back());
+	m_freeFences.pop_back();
+	fence->Reset();
+	return fence;
+}
+
+std::optional<uint64_t> StagingUploader::AllocateRingSpace(std::unique_lock<std::mutex> &lock, DeviceSize size)
+{
+	assert(size <= m_ringBufferSize);
+	auto isMainThread = (std::this_thread::get_id() == m_context.GetMainThreadId());
+	for(;;) {
+		// Allocations never wrap around, the remainder of the buffer is skipped instead
+		auto physOffset = m_ringHead % m_ringBufferSize;
+		auto padding = (physOffset + size > m_ringBufferSize) ? (m_ringBufferSize - physOffset) : 0ull;
+		if(m_ringHead + padding + size - m_ringTail <= m_ringBufferSize) {
+			auto start = m_ringHead + padding;
+			m_ringHead = start + size;
+			return start;
+		}
+		if(!isMainThread) {
+			// Only the main thread can submit. Waiting for it here could deadlock if it is waiting for this thread,
+			// so the caller has to fall back to a dedicated staging buffer instead.
+			return {};
+		}
+		lock.unlock();
+		Flush();
+		RetireCompletedSubmissions(true);
+		std::this_thread::yield();
+		lock.lock();
+	}
+	return {};
+}
+
+std::optional<StagingUploader::CompletionValue> StagingUploader::Upload(IBuffer &dstBuffer, DeviceSize dstOffset, DeviceSize size, const void *data)
+{
+	if(dstOffset + size > dstBuffer.GetSize())
+		throw std::out_of_range {"Upload range (offset: " + pragma::util::to_string(dstOffset) + ", size: " + pragma::util::to_string(size) + ") out of bounds of buffer of size " + pragma::util::to_string(dstBuffer.GetSize()) + "!"};
+	if(size == 0)
+		return 0;
+
+	// Resolve the root buffer, so that uploads to neighbouring sub-buffers can be merged
+	auto *root = &dstBuffer;
+	auto rootOffset = dstOffset;
+	while(auto parent = root->GetParent()) {
+		rootOffset += root->GetStartOffset();
+		root = parent.get();
+	}
+	if(pragma::math::is_flag_set(root->GetCreateInfo().memoryFeatures, MemoryFeatureFlags::HostAccessable))
+		return root->Write(rootOffset, size, data) ? std::optional<CompletionValue> {0} : std::optional<CompletionValue> {};
+	if(!pragma::math::is_flag_set(root->GetUsageFlags(), BufferUsageFlags::TransferDstBit)) {
+		m_context.Log("Attempted to upload data to buffer without transfer destination usage flag!", pragma::util::LogSeverity::Warning);
+		return {};
+	}
+
+	auto alignedSize = (size + COPY_ALIGNMENT - 1) & ~(COPY_ALIGNMENT - 1);
+	auto isMainThread = (std::this_thread::get_id() == m_context.GetMainThreadId());
+	if(!m_ringData || alignedSize > m_ringBufferSize) {
+		if(!isMainThread)
+			return UploadThroughDedicatedBuffer(*root, rootOffset, size, data);
+		// Make sure the write can't be overwritten by previously queued uploads
+		Wait(Flush());
+		{
+			std::scoped_lock lock {m_mutex};
+			++m_stats.numFallbackWrites;
+		}
+		return root->Write(rootOffset, size, data) ? std::optional<CompletionValue> {0} : std::optional<CompletionValue> {};
+	}
+
+	std::unique_lock lock {m_mutex};
+	auto pos = AllocateRingSpace(lock, alignedSize);
+	if(!pos) {
+		lock.unlock();
+		// The ring buffer is full and only the main thread can free up space
+		return UploadThroughDedicatedBuffer(*root, rootOffset, size, data);
+	}
+	// The data is copied without holding the lock, Flush will not submit anything past this position until we're done
+	auto itWrite = m_pendingWrites.insert(*pos);
+	lock.unlock();
+
+	auto srcOffset = *pos % m_ringBufferSize;
+	std::memcpy(m_ringData + srcOffset, data, size);
+
+	lock.lock();
+	m_pendingWrites.erase(itWrite);
+	m_pendingRegions.push_back({root->shared_from_this(), nullptr, srcOffset, rootOffset, size});
+	++m_stats.numUploads;
+	return m_submittedValue + 1;
+}
+
+std::optional<StagingUploader::CompletionValue> StagingUploader::UploadThroughDedicatedBuffer(IBuffer &root, DeviceSize rootOffset, DeviceSize size, const void *data)
+{
+	util::BufferCreateInfo createInfo {};
+	createInfo.debugName = "staging_upload_dedicated_buffer";
+	createInfo.memoryFeatures = MemoryFeatureFlags::HostAccessable | MemoryFeatureFlags::HostCoherent | MemoryFeatureFlags::Stream;
+	createInfo.size = size;
+	createInfo.usageFlags = BufferUsageFlags::TransferSrcBit;
+	auto srcBuffer = m_context.CreateBuffer(createInfo, data);
+	if(!srcBuffer) {
+		m_context.Log("Failed to create dedicated staging buffer of size " + pragma::util::to_string(size) + "! Upload has been discarded.", pragma::util::LogSeverity::Error);
+		return {};
+	}
+	std::scoped_lock lock {m_mutex};
+	m_pendingRegions.push_back({root.shared_from_this(), std::move(srcBuffer), 0ull, rootOffset, size});
+	++m_stats.numUploads;
+	++m_stats.numDedicatedBuffers;
+	return m_submittedValue + 1;
+}
+
+StagingUploader::CompletionValue StagingUploader::Flush()
+{
+	if(std::this_thread::get_id() != m_context.GetMainThreadId())
+		throw std::logic_error {"Staging uploads can only be flushed on the main thread!"};
+	RetireCompletedSubmissions(false);
+
+	std::scoped_lock lock {m_mutex};
+	if(m_pendingRegions.empty())
+		return m_submittedValue;
+	auto ringEnd = m_pendingWrites.empty() ? m_ringHead : pragma::math::min(m_ringHead, *m_pendingWrites.begin());
+
+	// Split the regions into batches without overlapping destination ranges. Copies within a batch
+	// can be reordered and merged freely, consecutive batches are separated by a barrier.
+	struct Batch {
+		std::vector<CopyRegion *> regions;
+		std::unordered_map<IBuffer *, std::map<DeviceSize, DeviceSize>> dstRanges; // offset -> end
+	};
+	std::vector<Batch> batches;
+	std::unordered_map<IBuffer *, std::pair<DeviceSize, DeviceSize>> dstBounds;
+	std::vector<std::shared_ptr<IBuffer>> dstBuffers;
+	std::vector<std::shared_ptr<IBuffer>> srcBuffers;
+	batches.push_back({});
+	for(auto &region : m_pendingRegions) {
+		if(region.srcBuffer)
+			srcBuffers.push_back(region.srcBuffer);
+		auto overlaps = [&region](Batch &batch) {
+			auto it = batch.dstRanges.find(region.dstBuffer.get());
+			if(it == batch.dstRanges.end())
+				return false;
+			auto &ranges = it->second;
+			auto itRange = ranges.lower_bound(region.dstOffset + region.size);
+			if(itRange == ranges.begin())
+				return false;
+			return std::prev(itRange)->second > region.dstOffset;
+		};
+		if(overlaps(batches.back()))
+			batches.push_back({});
+		auto &batch = batches.back();
+		batch.regions.push_back(&region);
+		batch.dstRanges[region.dstBuffer.get()][region.dstOffset] = region.dstOffset + region.size;
+
+		auto it = dstBounds.find(region.dstBuffer.get());
+		if(it == dstBounds.end()) {
+			dstBounds[region.dstBuffer.get()] = {region.dstOffset, region.dstOffset + region.size};
+			dstBuffers.push_back(region.dstBuffer);
+		}
+		else {
+			it->second.first = pragma::math::min(it->second.first, region.dstOffset);
+			it->second.second = pragma::math::max(it->second.second, region.dstOffset + region.size);
+		}
+	}
+
+	auto fRecordBarrier = [&dstBounds](ICommandBuffer &cmd, PipelineStageFlags srcStage, PipelineStageFlags dstStage, AccessFlags srcAccess, AccessFlags dstAccess) {
+		util::PipelineBarrierInfo barrierInfo {};
+		barrierInfo.srcStageMask = srcStage;
+		barrierInfo.dstStageMask = dstStage;
+		barrierInfo.bufferBarriers.reserve(dstBounds.size());
+		for(auto &[buf, bounds] : dstBounds) {
+			util::BufferBarrierInfo bufBarrier {};
+			bufBarrier.srcAccessMask = srcAccess;
+			bufBarrier.dstAccessMask = dstAccess;
+			bufBarrier.offset = buf->GetStartOffset() + bounds.first;
+			bufBarrier.size = bounds.second - bounds.first;
+			barrierInfo.bufferBarriers.push_back(util::create_buffer_barrier(bufBarrier, *buf));
+		}
+		return cmd.RecordPipelineBarrier(barrierInfo);
+	};
+	auto fRecordCopies = [this, &batches, &fRecordBarrier](ICommandBuffer &cmd) {
+		if(!fRecordBarrier(cmd, PipelineStageFlags::AllCommands, PipelineStageFlags::TransferBit, AccessFlags::MemoryReadBit | AccessFlags::MemoryWriteBit, AccessFlags::TransferWriteBit))
+			return false;
+		for(auto i = decltype(batches.size()) {0u}; i < batches.size(); ++i) {
+			auto &regions = batches[i].regions;
+			if(i > 0 && !fRecordBarrier(cmd, PipelineStageFlags::TransferBit, PipelineStageFlags::TransferBit, AccessFlags::TransferWriteBit, AccessFlags::TransferWriteBit))
+				return false;
+			std::sort(regions.begin(), regions.end(), [](const CopyRegion *a, const CopyRegion *b) { return (a->dstBuffer.get() != b->dstBuffer.get()) ? (a->dstBuffer.get() < b->dstBuffer.get()) : (a->dstOffset < b->dstOffset); });
+			for(auto it = regions.begin(); it != regions.end();) {
+				auto &first = **it;
+				util::BufferCopy copyInfo {};
+				copyInfo.srcOffset = first.srcOffset;
+				copyInfo.dstOffset = first.dstOffset;
+				copyInfo.size = first.size;
+				// Merge regions that are contiguous in both the staging and the destination buffer
+				for(++it; it != regions.end(); ++it) {
+					auto &next = **it;
+					if(next.dstBuffer != first.dstBuffer || next.srcBuffer != first.srcBuffer || next.dstOffset != copyInfo.dstOffset + copyInfo.size || next.srcOffset != copyInfo.srcOffset + copyInfo.size)
+						break;
+					copyInfo.size += next.size;
+				}
+				if(!cmd.RecordCopyBuffer(copyInfo, first.srcBuffer ? *first.srcBuffer : *m_ringBuffer, *first.dstBuffer))
+					return false;
+				++m_stats.numCopyRegions;
+			}
+		}
+		return fRecordBarrier(cmd, PipelineStageFlags::TransferBit, PipelineStageFlags::AllCommands, AccessFlags::TransferWriteBit, AccessFlags::MemoryReadBit | AccessFlags::MemoryWriteBit);
+	};
+
+	Submission submission {};
+	submission.value = ++m_submittedValue;
+	submission.ringEnd = ringEnd;
+	submission.dstBuffers = std::move(dstBuffers);
+	submission.srcBuffers = std::move(srcBuffers);
+
+	uint32_t queueFamilyIndex;
+	auto cmd = m_context.AllocatePrimaryLevelCommandBuffer(m_queueFamilyType, queueFamilyIndex);
+	auto success = false;
+	if(cmd && cmd->StartRecording(true, false)) {
+		success = fRecordCopies(*cmd);
+		success = cmd->StopRecording() && success;
+	}
+	if(success) {
+		submission.fence = AcquireFence();
+		submission.cmd = cmd;
+		m_context.SubmitCommandBuffer(*cmd, m_queueFamilyType, false, submission.fence.get());
+		++m_stats.numSubmissions;
+	}
+	else
+		m_context.Log("Failed to record staging buffer uploads! " + pragma::util::to_string(m_pendingRegions.size()) + " uploads have been discarded.", pragma::util::LogSeverity::Error);
+	// Failed submissions have no fence and are retired immediately
+	m_submissions.push_back(std::move(submission));
+	m_pendingRegions.clear();
+	m_stateChanged.notify_all();
+	return m_submittedValue;
+}
+
+void StagingUploader::FlushPendingUploads(const IBuffer &dstBuffer, DeviceSize dstOffset, DeviceSize size)
+{
+	auto *root = &dstBuffer;
+	auto rootOffset = dstOffset;
+	while(auto parent = root->GetParent()) {
+		rootOffset += root->GetStartOffset();
+		root = parent.get();
+	}
+	{
+		std::scoped_lock lock {m_mutex};
+		auto it = std::find_if(m_pendingRegions.begin(), m_pendingRegions.end(), [root, rootOffset, size](const CopyRegion &region) { return region.dstBuffer.get() == root && region.dstOffset < rootOffset + size && rootOffset < region.dstOffset + region.size; });
+		if(it == m_pendingRegions.end())
+			return;
+	}
+	auto value = Flush();
+	// Submissions on the universal queue are executed before any synchronous writes submitted after them,
+	// uploads on other queues have to be complete first.
+	if(m_queueFamilyType != QueueFamilyType::Universal)
+		Wait(value);
+}
+
+void StagingUploader::RetireCompletedSubmissions(bool waitForOldest)
+{
+	if(waitForOldest) {
+		std::shared_ptr<IFence> fence;
+		{
+			std::scoped_lock lock {m_mutex};
+			if(!m_submissions.empty())
+				fence = m_submissions.front().fence;
+		}
+		if(fence)
+			m_context.WaitForFence(*fence);
+	}
+
+	std::scoped_lock lock {m_mutex};
+	auto retired = false;
+	while(!m_submissions.empty()) {
+		auto &submission = m_submissions.front();
+		if(submission.fence && !submission.fence->IsSet())
+			break;
+		m_ringTail = submission.ringEnd;
+		m_completedValue = submission.value;
+		if(submission.fence)
+			m_freeFences.push_back(std::move(submission.fence));
+		m_submissions.pop_front();
+		retired = true;
+	}
+	if(retired)
+		m_stateChanged.notify_all();
+}
+
+StagingUploader::CompletionValue StagingUploader::GetCompletedValue()
+{
+	RetireCompletedSubmissions(false);
+	std::scoped_lock lock {m_mutex};
+	return m_completedValue;
+}
+
+void StagingUploader::Wait(CompletionValue value)
+{
+	auto isMainThread = (std::this_thread::get_id() == m_context.GetMainThreadId());
+	for(;;) {
+		{
+			std::unique_lock lock {m_mutex};
+			if(m_completedValue >= value)
+				return;
+			if(value > m_submittedValue) {
+				if(m_pendingRegions.empty() && m_pendingWrites.empty())
+					return; // Nothing to wait for
+				if(!isMainThread) {
+					// Wait for the next flush
+					m_stateChanged.wait(lock);
+					continue;
+				}
+				lock.unlock();
+				Flush();
+				continue;
+			}
+		}
+		RetireCompletedSubmissions(true);
+	}
+}
@@ -20,7 +20,7 @@ std::shared_ptr<prosper::SwapBuffer> prosper::SwapBuffer::Create(IPrContext &con
 			return nullptr;
 		buffers.push_back(subBuf);
 	}
-	return std::shared_ptr<SwapBuffer> {new SwapBuffer {context, std::move(buffers)}};
+	return std::shared_ptr<SwapBuffer> {new SwapBuffer {context, std::move(buffers), true}};
 }
 
 std::shared_ptr<prosper::SwapBuffer> prosper::SwapBuffer::Create(IPrContext &context, IDynamicResizableBuffer &buffer, DeviceSize size, uint32_t instanceCount)
@@ -31,13 +31,15 @@ std::shared_ptr<prosper::SwapBuffer> prosper::SwapBuffer::Create(IPrContext &con
 	buffers.reserve(numBuffers);
 	for(auto i = decltype(numBuffers) {0u}; i < numBuffers; ++i)
 		buffers.push_back(buffer.AllocateBuffer(alignedSize * instanceCount));
-	return std::shared_ptr<SwapBuffer> {new SwapBuffer {context, std::move(buffers)}};
+	return std::shared_ptr<SwapBuffer> {new SwapBuffer {context, std::move(buffers), false}};
 }
-std::shared_ptr<prosper::SwapBuffer> prosper::SwapBuffer::Create(IPrContext &context, std::vector<std::shared_ptr<IBuffer>> &&buffers) { return std::shared_ptr<SwapBuffer> {new SwapBuffer {context, std::move(buffers)}}; }
+std::shared_ptr<prosper::SwapBuffer> prosper::SwapBuffer::Create(IPrContext &context, std::vector<std::shared_ptr<IBuffer>> &&buffers) { return std::shared_ptr<SwapBuffer> {new SwapBuffer {context, std::move(buffers), false}}; }
 
-prosper::SwapBuffer::SwapBuffer(IPrContext &context, std::vector<std::shared_ptr<IBuffer>> &&buffers) : ContextObject{context}, m_buffers {std::move(buffers)}
+prosper::SwapBuffer::SwapBuffer(IPrContext &context, std::vector<std::shared_ptr<IBuffer>> &&buffers, bool useShadowCopy) : ContextObject{context}, m_buffers {std::move(buffers)}, m_useShadowCopy {useShadowCopy}
 {
 	assert(!m_buffers.empty());
+	if(m_useShadowCopy)
+		m_dirtyRanges.resize(m_buffers.size());
 	assert(window.GetSwapchainImageCount() == m_buffers.size());
 }
 prosper::IBuffer *prosper::SwapBuffer::operator->()
@@ -54,21 +56,173 @@ prosper::IBuffer &prosper::SwapBuffer::GetBuffer(SubBufferIndex idx)
 	return *m_buffers[idx];
 }
 prosper::IBuffer &prosper::SwapBuffer::GetCurrentBuffer() const { return *m_buffers[GetCurrentBufferIndex()]; }
+void prosper::SwapBuffer::AddRange(RangeSet &ranges, DeviceSize start, DeviceSize end)
+{
+	if(start >= end)
+		return;
+	// Merge with all overlapping or adjacent ranges
+	auto it = ranges.upper_bound(start);
+	if(it != ranges.begin() && std::prev(it)->second >= start)
+		--it;
+	while(it != ranges.end() && it->first <= end) {
+		start = pragma::math::min(start, it->first);
+		end = pragma::math::max(end, it->second);
+		it = ranges.erase(it);
+	}
+	ranges[start] = end;
+}
+void prosper::SwapBuffer::RemoveRange(RangeSet &ranges, DeviceSize start, DeviceSize end)
+{
+	if(start >= end)
+		return;
+	auto it = ranges.upper_bound(start);
+	if(it != ranges.begin() && std::prev(it)->second > start)
+		--it;
+	while(it != ranges.end() && it->first < end) {
+		auto rangeStart = it->first;
+		auto rangeEnd = it->second;
+		it = ranges.erase(it);
+		if(rangeStart < start)
+			ranges[rangeStart] = start;
+		if(rangeEnd > end)
+			ranges[end] = rangeEnd;
+	}
+}
+void prosper::SwapBuffer::MarkRangeAsDirty(DeviceSize start, DeviceSize end)
+{
+	for(auto &ranges : m_dirtyRanges)
+		AddRange(ranges, start, end);
+}
+void prosper::SwapBuffer::UpdateShadowData(IBuffer::Offset offset, IBuffer::Size size, const uint8_t *data, bool flagChangesAsDirty)
+{
+	auto end = offset + size;
+	if(m_shadowData.size() < end)
+		m_shadowData.resize(pragma::math::max<DeviceSize>(end, m_buffers.front()->GetSize()));
+	if(flagChangesAsDirty) {
+		// Compare the new data against the shadow copy in blocks, only blocks that have actually changed are flagged.
+		// Bytes that have never been written before are always considered to be changed.
+		constexpr DeviceSize blockSize = 16;
+		auto fDiff = [this, offset, data](DeviceSize start, DeviceSize end) {
+			auto dirtyStart = end;
+			for(auto blockStart = start; blockStart < end; blockStart += blockSize) {
+				auto blockEnd = pragma::math::min(blockStart + blockSize, end);
+				auto changed = std::memcmp(m_shadowData.data() + blockStart, data + (blockStart - offset), blockEnd - blockStart) != 0;
+				if(changed) {
+					if(dirtyStart == end)
+						dirtyStart = blockStart;
+					continue;
+				}
+				if(dirtyStart != end) {
+					MarkRangeAsDirty(dirtyStart, blockStart);
+					dirtyStart = end;
+				}
+			}
+			if(dirtyStart != end)
+				MarkRangeAsDirty(dirtyStart, end);
+		};
+		auto pos = offset;
+		auto it = m_shadowValidRanges.upper_bound(offset);
+		if(it != m_shadowValidRanges.begin() && std::prev(it)->second > offset)
+			--it;
+		for(; it != m_shadowValidRanges.end() && it->first < end; ++it) {
+			auto validStart = pragma::math::max(it->first, offset);
+			auto validEnd = pragma::math::min(it->second, end);
+			if(pos < validStart)
+				MarkRangeAsDirty(pos, validStart);
+			fDiff(validStart, validEnd);
+			pos = validEnd;
+		}
+		if(pos < end)
+			MarkRangeAsDirty(pos, end);
+	}
+	std::memcpy(m_shadowData.data() + offset, data, size);
+	if(flagChangesAsDirty)
+		AddRange(m_shadowValidRanges, offset, end);
+	else {
+		// The other buffers still contain the previous data, so the shadow copy can't be used to detect changes
+		// in this range anymore. Dirty ranges of other buffers that overlap it will receive the new data.
+		RemoveRange(m_shadowValidRanges, offset, end);
+	}
+}
+void prosper::SwapBuffer::ReplayDirtyRanges(IBuffer &buf, RangeSet &dirtyRanges)
+{
+	for(auto &[start, end] : dirtyRanges)
+		buf.Write(start, end - start, m_shadowData.data() + start);
+	dirtyRanges.clear();
+}
 prosper::IBuffer &prosper::SwapBuffer::Write(IBuffer::Offset offset, IBuffer::Size size, const void *data, bool flagAsDirty)
 {
-	if(flagAsDirty) {
-		auto &buffers = m_buffers;
-		for(auto i = decltype(buffers.size()) {0u}; i < buffers.size(); ++i)
-			m_buffersDirty |= 1 << i;
+	auto &buf = GetCurrentBuffer();
+	if(!m_useShadowCopy) {
+		if(flagAsDirty) {
+			for(auto i = decltype(m_buffers.size()) {0u}; i < m_buffers.size(); ++i)
+				m_buffersDirty |= 1 << i;
+		}
+
+		auto flag = GetCurrentBufferFlag();
+		if((m_buffersDirty & flag) != 0) {
+			m_buffersDirty &= ~flag;
+			// Data will only be updated if necessary
+			buf.Write(offset, size, data);
+		}
+		return buf;
 	}
 
-	auto flag = GetCurrentBufferFlag();
-	auto &buf = GetCurrentBuffer();
-	if((m_buffersDirty & flag) != 0) {
-		m_buffersDirty &= ~flag;
+	auto &dirtyRanges = m_dirtyRanges[GetCurrentBufferIndex()];
+	if(flagAsDirty)
+		UpdateShadowData(offset, size, static_cast<const uint8_t *>(data), true);
+	else {
 		// Data will only be updated if necessary
+		if(dirtyRanges.empty())
+			return buf;
+		UpdateShadowData(offset, size, static_cast<const uint8_t *>(data), false);
+		AddRange(dirtyRanges, offset, offset + size);
+	}
+	// Replay all changes since this buffer was last written
+	ReplayDirtyRanges(buf, dirtyRanges);
+	return buf;
+}
+prosper::IBuffer &prosper::SwapBuffer::WriteCurrentBuffer(IBuffer::Offset offset, IBuffer::Size size, const void *data)
+{
+	auto &buf = GetCurrentBuffer();
+	if(!m_useShadowCopy) {
 		buf.Write(offset, size, data);
+		return buf;
 	}
+	// The write has to go through the shadow copy, otherwise it would be overwritten with stale data by the next replay
+	UpdateShadowData(offset, size, static_cast<const uint8_t *>(data), false);
+	auto &dirtyRanges = m_dirtyRanges[GetCurrentBufferIndex()];
+	AddRange(dirtyRanges, offset, offset + size);
+	ReplayDirtyRanges(buf, dirtyRanges);
 	return buf;
 }
-bool prosper::SwapBuffer::IsDirty() const { return m_buffersDirty != 0; }
+bool prosper::SwapBuffer::IsDirty() const
+{
+	if(!m_useShadowCopy)
+		return m_buffersDirty != 0;
+	return std::any_of(m_dirtyRanges.begin(), m_dirtyRanges.end(), [](const RangeSet &ranges) { return !ranges.empty(); });
+}
+
+void prosper::SwapBufferUpdateArena::Add(SwapBuffer &buffer, IBuffer::Offset offset, IBuffer::Size size, const void *data)
+{
+	auto dataOffset = m_data.size();
+	dataOffset += (PAYLOAD_ALIGNMENT - (dataOffset % PAYLOAD_ALIGNMENT)) % PAYLOAD_ALIGNMENT;
+	m_data.resize(dataOffset + size);
+	std::memcpy(m_data.data() + dataOffset, data, size);
+	m_updates.push_back({buffer.weak_from_this(), offset, size, dataOffset});
+}
+void prosper::SwapBufferUpdateArena::Replay()
+{
+	for(auto &update : m_updates) {
+		auto buffer = update.buffer.lock();
+		if(!buffer)
+			continue; // Buffer has been destroyed before the update could be applied
+		buffer->WriteCurrentBuffer(update.offset, update.size, m_data.data() + update.dataOffset);
+	}
+	Clear();
+}
+void prosper::SwapBufferUpdateArena::Clear()
+{
+	m_updates.clear();
+	m_data.clear();
+}
@@ -11,7 +11,59 @@ import :buffer.uniform_resizable_buffer;
 
 using namespace prosper;
 
-IUniformResizableBuffer::IUniformResizableBuffer(IPrContext &context, IBuffer &buffer, uint64_t bufferInstanceSize, uint64_t alignedBufferBaseSize, uint32_t alignment) : IResizableBuffer {buffer}, m_bufferInstanceSize {bufferInstanceSize}, m_alignment {alignment}
+// Every running thread that uses thread-cached allocations is assigned a slot, which indexes the thread caches of each buffer.
+// Slots are returned when their thread exits and are re-used by the next thread, which also takes over the cached instances.
+namespace {
+	constexpr uint32_t THREAD_SLOT_UNASSIGNED = std::numeric_limits<uint32_t>::max();
+	constexpr uint32_t THREAD_SLOT_NONE = THREAD_SLOT_UNASSIGNED - 1;
+	struct ThreadSlotRegistry {
+		std::mutex mutex;
+		std::vector<uint32_t> freeSlots;
+		uint32_t nextSlot = 0;
+		uint32_t Acquire()
+		{
+			std::scoped_lock lock {mutex};
+			if(!freeSlots.empty()) {
+				auto slot = freeSlots.back();
+				freeSlots.pop_back();
+				return slot;
+			}
+			return (nextSlot < IUniformResizableBuffer::MAX_THREAD_CACHES) ? nextSlot++ : THREAD_SLOT_NONE;
+		}
+		void Release(uint32_t slot)
+		{
+			if(slot >= IUniformResizableBuffer::MAX_THREAD_CACHES)
+				return;
+			std::scoped_lock lock {mutex};
+			freeSlots.push_back(slot);
+		}
+	};
+	ThreadSlotRegistry &get_thread_slot_registry()
+	{
+		static ThreadSlotRegistry registry;
+		return registry;
+	}
+	// Trivially destructible, so it can still be read by thread-local destructors that run after the slot has been released
+	thread_local uint32_t g_threadSlot = THREAD_SLOT_UNASSIGNED;
+	struct ThreadSlotReleaser {
+		~ThreadSlotReleaser()
+		{
+			get_thread_slot_registry().Release(g_threadSlot);
+			g_threadSlot = THREAD_SLOT_NONE;
+		}
+	};
+	uint32_t get_thread_slot()
+	{
+		if(g_threadSlot == THREAD_SLOT_UNASSIGNED) {
+			thread_local ThreadSlotReleaser releaser;
+			g_threadSlot = get_thread_slot_registry().Acquire();
+		}
+		return g_threadSlot;
+	}
+};
+
+IUniformResizableBuffer::IUniformResizableBuffer(IPrContext &context, IBuffer &buffer, uint64_t bufferInstanceSize, uint64_t alignedBufferBaseSize, uint32_t alignment)
+    : IResizableBuffer {buffer}, m_bufferInstanceSize {bufferInstanceSize}, m_alignment {alignment}
 {
 	m_createInfo.size = alignedBufferBaseSize;
 
@@ -19,22 +71,10 @@ IUniformResizableBuffer::IUniformResizableBuffer(IPrContext &context, IBuffer &b
 	m_allocatedSubBuffers.resize(numMaxBuffers, nullptr);
 }
 
-uint64_t IUniformResizableBuffer::GetInstanceSize() const
-{
-	std::unique_lock lock {m_bufferMutex}; // TODO: Why do we need this lock?
-	return m_bufferInstanceSize;
-}
-
-uint32_t IUniformResizableBuffer::GetAlignment() const
-{
-	std::unique_lock lock {m_bufferMutex}; // TODO: Why do we need this lock?
-	return m_alignment;
-}
-uint64_t IUniformResizableBuffer::GetStride() const
-{
-	std::unique_lock lock {m_bufferMutex}; // TODO: Why do we need this lock?
-	return util::get_aligned_size(m_bufferInstanceSize, m_alignment);
-}
+// The instance size and alignment never change after construction, so no lock is required
+uint64_t IUniformResizableBuffer::GetInstanceSize() const { return m_bufferInstanceSize; }
+uint32_t IUniformResizableBuffer::GetAlignment() const { return m_alignment; }
+uint64_t IUniformResizableBuffer::GetStride() const { return util::get_aligned_size(m_bufferInstanceSize, m_alignment); }
 
 const std::vector<IBuffer *> &IUniformResizableBuffer::GetAllocatedSubBuffers() const { return m_allocatedSubBuffers; }
 uint64_t IUniformResizableBuffer::GetAssignedMemory() const
@@ -47,30 +87,154 @@ uint32_t IUniformResizableBuffer::GetTotalInstanceCount() const { return m_alloc
 bool IUniformResizableBuffer::EnsureCapacity(uint32_t instanceCount)
 {
 	std::scoped_lock lock {m_bufferMutex};
-	auto baseAlignedInstanceSize = util::get_aligned_size(m_bufferInstanceSize, m_alignment);
+	auto baseAlignedInstanceSize = GetStride();
 	auto alignedInstanceSize = baseAlignedInstanceSize * instanceCount;
 	auto requiredSize = m_assignedMemory + alignedInstanceSize;
 	/*if(requiredSize > m_maxTotalSize) {
 		GetContext().Log("Unable to allocate prosper buffer of size " + pragma::util::get_pretty_bytes(requiredSize) + " as it would exceed size of parent buffer '" + GetDebugName() + "' of size " + pragma::util::get_pretty_bytes(GetSize()), pragma::util::LogSeverity::Warning);
 		return false; // Total capacity has been reached
 	}*/
-	if(!ReallocateMemory(requiredSize))
+	// Wait for all thread-cached accesses to complete. New accesses will wait until the reallocation is done.
+	// m_bufferMutex is held, so there can only be one reallocation at a time.
+	m_reallocating.store(true);
+	for(auto n = m_numActiveAccesses.load(); n != 0; n = m_numActiveAccesses.load())
+		m_numActiveAccesses.wait(n);
+	auto success = ReallocateMemory(requiredSize);
+	if(success) {
+		auto numMaxBuffers = m_baseSize / baseAlignedInstanceSize;
+		m_allocatedSubBuffers.resize(numMaxBuffers, nullptr);
+	}
+	m_reallocating.store(false);
+	m_reallocating.notify_all();
+	if(!success)
 		return false;
 
-	auto numMaxBuffers = m_baseSize / baseAlignedInstanceSize;
-	m_allocatedSubBuffers.resize(numMaxBuffers, nullptr);
-
 	RunReallocationCallbacks();
 	return true;
 }
 
+void IUniformResizableBuffer::BeginAccess()
+{
+	for(;;) {
+		m_numActiveAccesses.fetch_add(1);
+		if(!m_reallocating.load())
+			return;
+		EndAccess();
+		m_reallocating.wait(true);
+	}
+}
+
+void IUniformResizableBuffer::EndAccess()
+{
+	if(m_numActiveAccesses.fetch_sub(1) == 1)
+		m_numActiveAccesses.notify_all();
+}
+
+std::shared_ptr<IBuffer> IUniformResizableBuffer::CreateInstanceSubBuffer(uint64_t offset, const void *data)
+{
+	auto idx = offset / GetStride();
+	auto pThis = std::dynamic_pointer_cast<IUniformResizableBuffer>(shared_from_this());
+	auto subBuffer = CreateSubBuffer(offset, m_bufferInstanceSize, [pThis, idx](IBuffer &subBuffer) { pThis->FreeInstance(subBuffer.GetStartOffset(), idx); });
+	assert(subBuffer);
+	subBuffer->SetParent(*this, idx);
+	if(data != nullptr)
+		subBuffer->Write(0ull, m_bufferInstanceSize, data);
+	m_allocatedSubBuffers.at(idx) = subBuffer.get();
+	return subBuffer;
+}
+
+void IUniformResizableBuffer::FreeInstance(uint64_t offset, uint64_t idx)
+{
+	auto *cache = (m_allocationMode == AllocationMode::ThreadCached) ? GetThreadCache() : nullptr;
+	if(!cache) {
+		std::unique_lock lock {m_bufferMutex};
+		m_freeOffsets.push(offset);
+		m_allocatedSubBuffers.at(idx) = nullptr;
+		return;
+	}
+	BeginAccess();
+	m_allocatedSubBuffers.at(idx) = nullptr;
+	EndAccess();
+	cache->freeOffsets.push_back(offset);
+	if(cache->freeOffsets.size() < THREAD_CACHE_BATCH_SIZE * 2)
+		return;
+	// Too many free instances in this thread's cache, return a batch to the shared pool
+	std::unique_lock lock {m_bufferMutex};
+	for(auto i = decltype(THREAD_CACHE_BATCH_SIZE) {0u}; i < THREAD_CACHE_BATCH_SIZE; ++i) {
+		m_freeOffsets.push(cache->freeOffsets.back());
+		cache->freeOffsets.pop_back();
+	}
+}
+
+IUniformResizableBuffer::ThreadCache *IUniformResizableBuffer::GetThreadCache()
+{
+	auto slot = get_thread_slot();
+	if(slot >= MAX_THREAD_CACHES)
+		return nullptr;
+	auto *cache = m_threadCaches[slot].load(std::memory_order_acquire);
+	if(cache)
+		return cache;
+	// Only the thread owning the slot can create its cache, so there is no race here
+	std::unique_lock lock {m_bufferMutex};
+	m_threadCacheStorage.push_back(std::make_unique<ThreadCache>());
+	cache = m_threadCacheStorage.back().get();
+	cache->freeOffsets.reserve(THREAD_CACHE_BATCH_SIZE * 2);
+	m_threadCaches[slot].store(cache, std::memory_order_release);
+	return cache;
+}
+
+bool IUniformResizableBuffer::RefillThreadCache(ThreadCache &cache)
+{
+	std::unique_lock lock {m_bufferMutex};
+	while(cache.freeOffsets.size() < THREAD_CACHE_BATCH_SIZE && m_freeOffsets.empty() == false) {
+		cache.freeOffsets.push_back(m_freeOffsets.front());
+		m_freeOffsets.pop();
+	}
+	uint32_t numNewInstances = THREAD_CACHE_BATCH_SIZE - cache.freeOffsets.size();
+	if(numNewInstances == 0)
+		return true;
+	auto stride = GetStride();
+	if(m_assignedMemory + stride * numNewInstances > m_baseSize && EnsureCapacity(numNewInstances) == false)
+		return cache.freeOffsets.empty() == false;
+	for(auto i = decltype(numNewInstances) {0u}; i < numNewInstances; ++i) {
+		cache.freeOffsets.push_back(m_assignedMemory);
+		m_assignedMemory += stride;
+	}
+	return true;
+}
+
+void IUniformResizableBuffer::FlushThreadCache()
+{
+	if(m_allocationMode != AllocationMode::ThreadCached)
+		return;
+	auto *cache = GetThreadCache();
+	if(!cache)
+		return;
+	std::unique_lock lock {m_bufferMutex};
+	for(auto offset : cache->freeOffsets)
+		m_freeOffsets.push(offset);
+	cache->freeOffsets.clear();
+}
+
 std::shared_ptr<IBuffer> IUniformResizableBuffer::AllocateBuffer(const void *data)
 {
+	auto *cache = (m_allocationMode == AllocationMode::ThreadCached) ? GetThreadCache() : nullptr;
+	if(cache) {
+		if(cache->freeOffsets.empty() && RefillThreadCache(*cache) == false)
+			return nullptr;
+		auto offset = cache->freeOffsets.back();
+		cache->freeOffsets.pop_back();
+		// Only reallocations have to be excluded, other threads can allocate concurrently
+		BeginAccess();
+		auto subBuffer = CreateInstanceSubBuffer(offset, data);
+		EndAccess();
+		return subBuffer;
+	}
+
 	std::unique_lock lock {m_bufferMutex};
 	auto offset = 0ull;
 	auto bUseExistingSlot = false;
-	auto baseAlignedInstanceSize = util::get_aligned_size(m_bufferInstanceSize, m_alignment);
-	auto alignedInstanceSize = baseAlignedInstanceSize; // *numInstances;
+	auto alignedInstanceSize = GetStride();
 	if(m_freeOffsets.empty() == false) {
 		offset = m_freeOffsets.front();
 		m_freeOffsets.pop();
@@ -82,18 +246,7 @@ std::shared_ptr<IBuffer> IUniformResizableBuffer::AllocateBuffer(const void *dat
 		offset = m_assignedMemory;
 	}
 
-	auto idx = offset / baseAlignedInstanceSize;
-	auto pThis = std::dynamic_pointer_cast<IUniformResizableBuffer>(shared_from_this());
-	auto subBuffer = CreateSubBuffer(offset, m_bufferInstanceSize, [pThis, idx](IBuffer &subBuffer) {
-		std::unique_lock lock {pThis->m_bufferMutex};
-		pThis->m_freeOffsets.push(subBuffer.GetStartOffset());
-		pThis->m_allocatedSubBuffers.at(idx) = nullptr;
-	});
-	assert(subBuffer);
-	subBuffer->SetParent(*this, idx);
-	if(data != nullptr)
-		subBuffer->Write(0ull, m_bufferInstanceSize, data);
-	m_allocatedSubBuffers.at(idx) = subBuffer.get();
+	auto subBuffer = CreateInstanceSubBuffer(offset, data);
 	if(bUseExistingSlot == false)
 		m_assignedMemory += alignedInstanceSize;
 	return subBuffer;
@@ -7,6 +7,7 @@ module;
 
 module pragma.prosper;
 
+import :barrier_accumulator;
 import :command_buffer;
 
 prosper::ICommandBuffer::ICommandBuffer(IPrContext &context, QueueFamilyType queueFamilyType)
@@ -27,19 +28,37 @@ const prosper::IPrimaryCommandBuffer *prosper::ICommandBuffer::GetPrimaryCommand
 prosper::ISecondaryCommandBuffer *prosper::ICommandBuffer::GetSecondaryCommandBufferPtr() { return !IsPrimary() ? static_cast<ISecondaryCommandBuffer *>(m_cmdBufSpecializationPtr) : nullptr; }
 const prosper::ISecondaryCommandBuffer *prosper::ICommandBuffer::GetSecondaryCommandBufferPtr() const { return const_cast<ICommandBuffer *>(this)->GetSecondaryCommandBufferPtr(); }
 
+void prosper::ICommandBuffer::SetBarrierBatchingEnabled(bool enabled)
+{
+	if(enabled == IsBarrierBatchingEnabled())
+		return;
+	if(enabled) {
+		m_barrierAccumulator = std::make_unique<BarrierAccumulator>();
+		return;
+	}
+	FlushBarriers();
+	m_barrierAccumulator = nullptr;
+}
+bool prosper::ICommandBuffer::FlushBarriers() { return !m_barrierAccumulator || m_barrierAccumulator->Flush(*this); }
+
 bool prosper::ICommandBuffer::IsPrimary() const { return false; }
 bool prosper::ICommandBuffer::IsSecondary() const { return false; }
 prosper::QueueFamilyType prosper::ICommandBuffer::GetQueueFamilyType() const { return m_queueFamilyType; }
 
 void prosper::ICommandBuffer::UpdateLastUsageTimes(IDescriptorSet &ds) { GetContext().UpdateLastUsageTimes(ds); }
 
-bool prosper::ICommandBuffer::RecordPresentImage(IImage &img, uint32_t swapchainImgIndex) { return RecordPresentImage(img, *GetContext().GetSwapchainImage(swapchainImgIndex), *GetContext().GetSwapchainFramebuffer(swapchainImgIndex)); }
+bool prosper::ICommandBuffer::RecordPresentImage(IImage &img, uint32_t swapchainImgIndex)
+{
+	FlushBarriers();
+	return RecordPresentImage(img, *GetContext().GetSwapchainImage(swapchainImgIndex), *GetContext().GetSwapchainFramebuffer(swapchainImgIndex));
+}
 bool prosper::ICommandBuffer::RecordPresentImage(IImage &img, Window &window, uint32_t swapchainImgIndex)
 {
 	auto *imgSc = window.GetSwapchainImage(swapchainImgIndex);
 	auto *fbSc = window.GetSwapchainFramebuffer(swapchainImgIndex);
 	if(!imgSc || !fbSc)
 		return false;
+	FlushBarriers();
 	return RecordPresentImage(img, *imgSc, *fbSc);
 }
 bool prosper::ICommandBuffer::RecordPresentImage(IImage &img, Window &window) { return RecordPresentImage(img, window, window.GetLastAcquiredSwapchainImageIndex()); }
@@ -48,11 +67,14 @@ bool prosper::IPrimaryCommandBuffer::StartRecording(bool oneTimeSubmit, bool sim
 {
 	assert(!m_recording);
 	SetRecording(true);
+	if(m_barrierAccumulator)
+		m_barrierAccumulator->Reset();
 	return true;
 }
 bool prosper::IPrimaryCommandBuffer::StopRecording() const
 {
 	assert(m_recording);
+	const_cast<IPrimaryCommandBuffer *>(this)->FlushBarriers();
 	SetRecording(false);
 	return true;
 }
@@ -61,12 +83,16 @@ bool prosper::ISecondaryCommandBuffer::StartRecording(bool oneTimeSubmit, bool s
 {
 	assert(!m_recording);
 	SetRecording(true);
+	if(m_barrierAccumulator)
+		m_barrierAccumulator->Reset();
 	return true;
 }
 bool prosper::ISecondaryCommandBuffer::StartRecording(IRenderPass &rp, IFramebuffer &fb, bool oneTimeSubmit, bool simultaneousUseAllowed) const
 {
 	assert(!m_recording);
 	SetRecording(true);
+	if(m_barrierAccumulator)
+		m_barrierAccumulator->Reset();
 	m_currentRenderPass = &rp;
 	m_currentFramebuffer = &fb;
 	return true;
@@ -74,6 +100,7 @@ bool prosper::ISecondaryCommandBuffer::StartRecording(IRenderPass &rp, IFramebuf
 bool prosper::ISecondaryCommandBuffer::StopRecording() const
 {
 	assert(m_recording);
+	const_cast<ISecondaryCommandBuffer *>(this)->FlushBarriers();
 	SetRecording(false);
 	m_currentRenderPass = nullptr;
 	m_currentFramebuffer = nullptr;
@@ -12,9 +12,23 @@ bool prosper::ICommandBuffer::RecordCopyBuffer(const util::BufferCopy &copyInfo,
 	auto ci = copyInfo;
 	ci.srcOffset += bufferSrc.GetStartOffset();
 	ci.dstOffset += bufferDst.GetStartOffset();
+	FlushBarriers();
 	return DoRecordCopyBuffer(ci, bufferSrc, bufferDst);
 }
 bool prosper::ICommandBuffer::RecordClearAttachment(IImage &img, const std::array<float, 4> &clearColor, uint32_t attId) { return RecordClearAttachment(img, clearColor, attId, 0u, img.GetLayerCount()); }
+bool prosper::ICommandBuffer::RecordClearAttachment(IImage &img, const std::array<float, 4> &clearColor, uint32_t attId, uint32_t layerId, uint32_t layerCount) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordClearAttachment(IImage &img, std::optional<float> clearDepth, std::optional<uint32_t> clearStencil, uint32_t layerId) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordClearImage(IImage &img, ImageLayout layout, const std::array<float, 4> &clearColor, const util::ClearImageInfo &clearImageInfo) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordClearImage(IImage &img, ImageLayout layout, std::optional<float> clearDepth, std::optional<uint32_t> clearStencil, const util::ClearImageInfo &clearImageInfo) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordUpdateBuffer(IBuffer &buffer, uint64_t offset, uint64_t size, const void *data) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordFillBuffer(IBuffer &buf, DeviceSize offset, DeviceSize size, uint32_t data) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordDispatchIndirect(IBuffer &buffer, DeviceSize size) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordDispatch(uint32_t x, uint32_t y, uint32_t z) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordDraw(uint32_t vertCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordDrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t firstInstance) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordDrawIndexedIndirect(IBuffer &buf, DeviceSize offset, uint32_t drawCount, uint32_t stride) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordDrawIndirect(IBuffer &buf, DeviceSize offset, uint32_t count, uint32_t stride) { return FlushBarriers(); }
+bool prosper::ICommandBuffer::RecordPipelineBarrier(const util::PipelineBarrierInfo &barrierInfo) { return FlushBarriers(); }
 bool prosper::ICommandBuffer::RecordCopyImage(const util::CopyInfo &copyInfo, IImage &imgSrc, IImage &imgDst)
 {
 	// TODO
@@ -27,10 +41,19 @@ bool prosper::ICommandBuffer::RecordCopyImage(const util::CopyInfo &copyInfo, II
 	auto height = copyInfo.height;
 	if(height == std::numeric_limits<decltype(height)>::max())
 		height = imgSrc.GetHeight();
+	FlushBarriers();
 	return DoRecordCopyImage(copyInfo, imgSrc, imgDst, width, height);
 }
-bool prosper::ICommandBuffer::RecordCopyBufferToImage(const util::BufferImageCopyInfo &copyInfo, IBuffer &bufferSrc, IImage &imgDst) { return DoRecordCopyBufferToImage(copyInfo, bufferSrc, imgDst); }
-bool prosper::ICommandBuffer::RecordCopyImageToBuffer(const util::BufferImageCopyInfo &copyInfo, IImage &imgSrc, ImageLayout srcImageLayout, IBuffer &bufferDst) { return DoRecordCopyImageToBuffer(copyInfo, imgSrc, srcImageLayout, bufferDst); }
+bool prosper::ICommandBuffer::RecordCopyBufferToImage(const util::BufferImageCopyInfo &copyInfo, IBuffer &bufferSrc, IImage &imgDst)
+{
+	FlushBarriers();
+	return DoRecordCopyBufferToImage(copyInfo, bufferSrc, imgDst);
+}
+bool prosper::ICommandBuffer::RecordCopyImageToBuffer(const util::BufferImageCopyInfo &copyInfo, IImage &imgSrc, ImageLayout srcImageLayout, IBuffer &bufferDst)
+{
+	FlushBarriers();
+	return DoRecordCopyImageToBuffer(copyInfo, imgSrc, srcImageLayout, bufferDst);
+}
 
 bool prosper::ICommandBuffer::RecordUpdateGenericShaderReadBuffer(IBuffer &buffer, uint64_t offset, uint64_t size, const void *data)
 {
@@ -74,6 +97,7 @@ bool prosper::ICommandBuffer::RecordBlitImage(const util::BlitInfo &blitInfo, II
 		dstOffsets.at(1).x = blitInfo.extentsDst->width;
 		dstOffsets.at(1).y = blitInfo.extentsDst->height;
 	}
+	FlushBarriers();
 	return DoRecordBlitImage(blitInfo, imgSrc, imgDst, srcOffsets, dstOffsets);
 }
 bool prosper::ICommandBuffer::RecordResolveImage(IImage &imgSrc, IImage &imgDst)
@@ -96,6 +120,7 @@ bool prosper::ICommandBuffer::RecordResolveImage(IImage &imgSrc, IImage &imgDst)
 	util::ImageSubresourceLayers srcLayer {srcAspectMask, 0, 0, 1};
 	util::ImageSubresourceLayers destLayer {dstAspectMask, 0, 0, 1};
 	util::ImageResolve resolve {srcLayer, Offset3D {0, 0, 0}, destLayer, Offset3D {0, 0, 0}, Extent3D {srcExtents.width, srcExtents.height, 1}};
+	FlushBarriers();
 	return DoRecordResolveImage(imgSrc, imgDst, resolve);
 }
 bool prosper::ICommandBuffer::RecordBlitTexture(Texture &texSrc, IImage &imgDst)
@@ -124,7 +149,7 @@ bool prosper::ICommandBuffer::RecordGenerateMipmaps(IImage &img, ImageLayout cur
 	imgBarrierInfo.subresourceRange.baseMipLevel = 0u;
 
 	barrierInfo.imageBarriers = decltype(barrierInfo.imageBarriers) {util::create_image_barrier(img, imgBarrierInfo)};
-	if(RecordPipelineBarrier(barrierInfo) == false) // Move first mipmap into transfer-src layout
+	if(FlushBarriers() == false || RecordPipelineBarrier(barrierInfo) == false) // Move first mipmap into transfer-src layout
 		return false;
 
 	imgBarrierInfo.subresourceRange.baseMipLevel = 1u;
@@ -7,8 +7,19 @@ module;
 
 module pragma.prosper;
 
+import :buffer.buffer_update_queue;
+import :buffer.device_image_buffer_defragmenter;
+import :buffer.frame_ring_allocator;
+import :buffer.image_readback;
+import :buffer.staging_uploader;
 import :context;
+import :descriptor_set_cache;
+import :descriptor_write_batcher;
+import :glsl;
+import :swap_command_buffer;
 import :shader_system.pipeline_loader;
+import :shader_system.shader_cache;
+import :shader_system.shader_hot_reloader;
 import :shader_system.shader;
 import :shader_system.shaders.blur;
 import :shader_system.shaders.copy_image;
@@ -22,7 +33,7 @@ import pragma.platform;
 prosper::ShaderPipeline::ShaderPipeline(Shader &shader, uint32_t pipeline) : shader {shader.GetHandle()}, pipeline {pipeline} {}
 
 prosper::IPrContext::IPrContext(const std::string &appName, bool bEnableValidation)
-    : m_appName(appName), m_commonBufferCache {*this}, m_mainThreadId {std::this_thread::get_id()}
+    : m_appName(appName), m_bufferUpdateQueue {std::make_unique<BufferUpdateQueue>()}, m_swapBufferUpdateArena {std::make_unique<SwapBufferUpdateArena>()}, m_commonBufferCache {*this}, m_mainThreadId {std::this_thread::get_id()}
 #ifdef PR_DEBUG_API_DUMP
       ,
       m_apiDumpRecorder {std::make_unique<debug::ApiDumpRecorder>()}
@@ -123,18 +134,29 @@ void prosper::IPrContext::OnClose()
 void prosper::IPrContext::Release()
 {
 	m_commonBufferCache.Release();
+	m_stagingUploader = nullptr;
+	m_descriptorSetCache = nullptr;
+	m_descriptorWriteBatcher = nullptr;
+	m_commandRecordThreadPool = nullptr;
+	m_imageReadback = nullptr;
+	m_shaderHotReloader = nullptr;
+	SetShaderCacheEnabled(false);
 	m_shaderManager = nullptr;
 	m_dummyTexture = nullptr;
 	m_dummyCubemapTexture = nullptr;
 	m_dummyBuffer = nullptr;
 
 	m_tmpBuffer = nullptr;
+	m_frameRingAllocator = nullptr;
+	m_deviceImgBufferDefragmenter = nullptr;
 	m_deviceImgBuffers.clear();
 
 	m_setupCmdBuffer = nullptr;
 	m_keepAliveResources.clear();
 	while(m_scheduledBufferUpdates.empty() == false)
 		m_scheduledBufferUpdates.pop();
+	m_bufferUpdateQueue->Clear();
+	m_swapBufferUpdateArena->Clear();
 
 	m_window = nullptr;
 	m_windows.clear();
@@ -153,7 +175,33 @@ void prosper::IPrContext::EndFrame()
 
 void prosper::IPrContext::DrawFrameCore()
 {
+	if(m_frameRingAllocator) {
+		// The transient data of the previous frame with this resource index can only be discarded once the GPU is done with it.
+		// This has to happen before any of the per-frame hooks below get a chance to allocate from the segment.
+		std::string errMsg;
+		if(WaitForCurrentSwapchainCommandBuffer(errMsg))
+			m_frameRingAllocator->BeginFrame(GetFrameResourceIndex());
+		else
+			Log("Failed to wait for frame resources: " + errMsg + "! Frame ring allocations will fall back to temporary buffers for this frame.", pragma::util::LogSeverity::Warning);
+	}
+	if(m_shaderHotReloader)
+		m_shaderHotReloader->Poll();
+	if(m_stagingUploader)
+		m_stagingUploader->Flush();
+	if(m_descriptorSetCache)
+		m_descriptorSetCache->Update();
+	if(m_imageReadback) {
+		m_imageReadback->Poll();
+		m_imageReadback->Flush();
+	}
+	if(m_deviceImgBufferDefragmenter && m_deviceImgBufferDefragmentationEnabled)
+		m_deviceImgBufferDefragmenter->Step();
+	// Descriptor sets can't be written once they're in use by a command buffer that is being recorded
+	if(m_descriptorWriteBatcher)
+		m_descriptorWriteBatcher->Flush();
 	DrawFrame([this]() { Draw(); });
+	if(m_frameRingAllocator)
+		m_frameRingAllocator->EndFrame();
 	EndFrame();
 
 	CloseWindowsScheduledForClosing();
@@ -187,9 +235,10 @@ std::shared_ptr<prosper::IBuffer> prosper::IPrContext::AllocateDeviceImageBuffer
 		return nullptr;
 	static uint64_t totalAllocated = 0;
 	totalAllocated += size;
-	auto fAllocateImgBuf = [this, size, alignment, data](IDynamicResizableBuffer &deviceImgBuf) -> std::shared_ptr<IBuffer> { return deviceImgBuf.AllocateBuffer(size, alignment, data); };
+	// Buffers that images are already bound to must not be reallocated, the images can't be moved to different memory
+	auto fAllocateImgBuf = [this, size, alignment, data](IDynamicResizableBuffer &deviceImgBuf, bool reallocateIfNoSpaceAvailable) -> std::shared_ptr<IBuffer> { return deviceImgBuf.AllocateBuffer(size, alignment, data, reallocateIfNoSpaceAvailable); };
 	for(auto &deviceImgBuf : m_deviceImgBuffers) {
-		auto buf = fAllocateImgBuf(*deviceImgBuf);
+		auto buf = fAllocateImgBuf(*deviceImgBuf, false);
 		if(buf)
 			return buf;
 	}
@@ -220,7 +269,7 @@ std::shared_ptr<prosper::IBuffer> prosper::IPrContext::AllocateDeviceImageBuffer
 	if(deviceImgBuffer == nullptr)
 		return nullptr;
 	m_deviceImgBuffers.push_back(deviceImgBuffer);
-	auto buf = fAllocateImgBuf(*deviceImgBuffer);
+	auto buf = fAllocateImgBuf(*deviceImgBuffer, true);
 	return buf;
 }
 
@@ -247,6 +296,15 @@ void prosper::IPrContext::AllocateTemporaryBuffer(IImage &img, const void *data)
 	auto buf = AllocateTemporaryBuffer(req.size, req.alignment, data);
 	img.SetMemoryBuffer(*buf);
 }
+std::shared_ptr<prosper::IBuffer> prosper::IPrContext::AllocateFrameTemporaryBuffer(DeviceSize size, uint32_t alignment, const void *data)
+{
+	if(m_frameRingAllocator) {
+		auto buf = m_frameRingAllocator->AllocateBuffer(size, alignment, data);
+		if(buf)
+			return buf;
+	}
+	return AllocateTemporaryBuffer(size, alignment, data);
+}
 
 void prosper::IPrContext::ChangeResolution(uint32_t width, uint32_t height)
 {
@@ -541,6 +599,29 @@ void prosper::IPrContext::ReloadPipelineLoader()
 	m_pipelineLoader = nullptr;
 	m_pipelineLoader = std::make_unique<ShaderPipelineLoader>(*this);
 }
+void prosper::IPrContext::SetShaderHotReloadEnabled(bool enabled)
+{
+	if(!enabled) {
+		m_shaderHotReloader = nullptr;
+		return;
+	}
+	if(m_shaderHotReloader)
+		return;
+	m_shaderHotReloader = std::make_unique<ShaderHotReloader>(*this);
+	std::error_code ec;
+	auto &rootLocation = Shader::GetRootShaderLocation();
+	m_shaderHotReloader->AddWatchDirectory(std::filesystem::absolute(rootLocation, ec).string(), rootLocation);
+}
+void prosper::IPrContext::SetShaderCacheEnabled(bool enabled, const std::string &rootPath)
+{
+	std::scoped_lock lock {m_shaderCacheMutex};
+	m_shaderCache = enabled ? std::make_shared<ShaderCache>(rootPath) : nullptr;
+}
+std::shared_ptr<prosper::ShaderCache> prosper::IPrContext::GetShaderCache() const
+{
+	std::scoped_lock lock {m_shaderCacheMutex};
+	return m_shaderCache;
+}
 void prosper::IPrContext::CheckDeviceLimits()
 {
 	auto limits = GetPhysicalDeviceLimits();
@@ -584,6 +665,12 @@ std::expected<void, std::string> prosper::IPrContext::Initialize(const CreateInf
 		Log("Initializing dummy resources...", pragma::util::LogSeverity::Debug);
 	InitDummyTextures();
 	InitDummyBuffer();
+	m_stagingUploader = std::make_unique<StagingUploader>(*this);
+	m_descriptorSetCache = std::make_shared<DescriptorSetCache>(*this);
+	m_descriptorWriteBatcher = std::make_unique<DescriptorWriteBatcher>(*this);
+	m_commandRecordThreadPool = std::make_unique<CommandRecordThreadPool>(std::thread::hardware_concurrency());
+	m_imageReadback = std::make_unique<ImageReadback>(*this);
+	m_deviceImgBufferDefragmenter = std::make_unique<DeviceImageBufferDefragmenter>(*this, m_deviceImgBuffers);
 	pragma::math::set_flag(m_stateFlags, StateFlags::Initialized);
 
 	if(ShouldLog(pragma::util::LogSeverity::Debug))
@@ -725,37 +812,26 @@ bool prosper::IPrContext::ScheduleRecordUpdateBuffer(IBuffer &buffer, uint64_t o
 			return true;
 		}
 	}
-	// We'll have to make a copy of the data for later
-	auto ptrData = std::make_shared<std::vector<uint8_t>>(size);
-	memcpy(ptrData->data(), data, size);
-	m_scheduledBufferUpdates.push([&buffer, fRecordSrcBarrier, fUpdateBuffer, offset, size, ptrData, updateInfo](ICommandBuffer &cmdBuffer) {
-		fRecordSrcBarrier(cmdBuffer);
-		fUpdateBuffer(cmdBuffer, buffer, ptrData->data(), offset, size);
-
-		if(updateInfo.postUpdateBarrierStageMask.has_value() && updateInfo.postUpdateBarrierAccessMask.has_value()) {
-			cmdBuffer.RecordBufferBarrier(buffer, PipelineStageFlags::TransferBit, *updateInfo.postUpdateBarrierStageMask, AccessFlags::TransferWriteBit, *updateInfo.postUpdateBarrierAccessMask, offset, size);
-		}
-	});
+	// Deferred updates are accumulated and recorded all at once, the queue is only scheduled for the first update
+	if(m_bufferUpdateQueue->IsEmpty())
+		m_scheduledBufferUpdates.push([this](ICommandBuffer &cmdBuffer) { m_bufferUpdateQueue->Record(cmdBuffer); });
+	m_bufferUpdateQueue->Add(buffer, offset, size, data, updateInfo);
 	return true;
 }
 bool prosper::IPrContext::ScheduleRecordUpdateBuffer(SwapBuffer &buffer, uint64_t offset, uint64_t size, const void *data, const BufferUpdateInfo &updateInfo)
 {
 	if(size == 0u)
 		return true;
-	const auto fUpdateBuffer = [](IBuffer &buffer, const uint8_t *data, uint64_t offset, uint64_t size) {
-		return buffer.Write(offset, size, data);
-	};
-
 	if(IsRecording()) {
-		// We're mid-frame already and can just update the buffer
-		return fUpdateBuffer(buffer.GetCurrentBuffer(), static_cast<const uint8_t *>(data), offset, size);
+		// We're mid-frame already and can just update the buffer. The update has to go through the swap buffer,
+		// otherwise its shadow copy would overwrite it with stale data later on.
+		buffer.WriteCurrentBuffer(offset, size, data);
+		return true;
 	}
-	// We'll have to make a copy of the data for later
-	auto ptrData = std::make_shared<std::vector<uint8_t>>(size);
-	memcpy(ptrData->data(), data, size);
-	m_scheduledBufferUpdates.push([&buffer, fUpdateBuffer, offset, size, ptrData, updateInfo](ICommandBuffer &cmdBuffer) {
-		fUpdateBuffer(buffer.GetCurrentBuffer(), ptrData->data(), offset, size);
-	});
+	// The update will be applied at the start of the next frame, the arena is only scheduled for the first update
+	if(m_swapBufferUpdateArena->IsEmpty())
+		m_scheduledBufferUpdates.push([this](ICommandBuffer &cmdBuffer) { m_swapBufferUpdateArena->Replay(); });
+	m_swapBufferUpdateArena->Add(buffer, offset, size, data);
 	return true;
 }
 
@@ -772,6 +848,9 @@ void prosper::IPrContext::InitTemporaryBuffer()
 	assert(m_tmpBuffer);
 	m_tmpBuffer->SetPermanentlyMapped(true, IBuffer::MapFlags::ReadBit | IBuffer::MapFlags::WriteBit);
 	m_tmpBuffer->SetResizable(false);
+
+	constexpr size_t frameSegmentSize = 4ull * 1'024ull * 1'024ull; // 4 MiB per frame in flight
+	m_frameRingAllocator = std::make_unique<FrameRingAllocator>(*this, frameSegmentSize);
 }
 
 void prosper::IPrContext::Draw()
@@ -839,6 +918,12 @@ void prosper::IPrContext::Draw()
 	}
 }
 
+void prosper::IPrContext::UpdateDescriptorSets(const std::vector<IDescriptorSet *> &descSets)
+{
+	for(auto *descSet : descSets)
+		descSet->UpdateDirtyBindings();
+}
+
 void prosper::IPrContext::InitGfxPipelines() {}
 
 void prosper::IPrContext::UpdateLastUsageTime(IImage &img)
@@ -978,19 +1063,70 @@ void prosper::IPrContext::Run()
 
 bool prosper::IPrContext::InitializeShaderSources(Shader &shader, bool bReload, std::string &outInfoLog, std::string &outDebugInfoLog, ShaderStage &outErrStage, const std::string &prefixCode, const std::unordered_map<std::string, std::string> &definitions) const
 {
+	// The stages are compiled in parallel on the pipeline loader
+	struct StageCompileResult {
+		std::shared_future<bool> future;
+		std::string infoLog;
+		std::string debugInfoLog;
+	};
+	auto &loader = const_cast<IPrContext *>(this)->GetPipelineLoader();
 	auto &stages = shader.GetStages();
+	std::array<StageCompileResult, pragma::math::to_integral(ShaderStage::Count)> results {};
 	for(auto i = decltype(stages.size()) {0}; i < stages.size(); ++i) {
 		auto &stage = stages.at(i);
 		if(stage == nullptr || stage->path.empty())
 			continue;
 		auto stagePrefixCode = shader.GetGlslPrefixCode(static_cast<ShaderStage>(i));
-		stage->program = const_cast<IPrContext *>(this)->CompileShader(static_cast<ShaderStage>(i), stage->path, outInfoLog, outDebugInfoLog, bReload, stagePrefixCode ? (*stagePrefixCode + prefixCode) : prefixCode, definitions);
-		if(stage->program == nullptr) {
-			outErrStage = stage->stage;
-			return false;
-		}
+		auto &result = results[i];
+		result.future = loader.AddTask(shader.GetIndex(), [this, &stage, &result, &definitions, i, bReload, stagePrefixCode = stagePrefixCode ? (*stagePrefixCode + prefixCode) : prefixCode]() -> bool {
+			stage->program = const_cast<IPrContext *>(this)->CompileShaderCached(static_cast<ShaderStage>(i), stage->path, result.infoLog, result.debugInfoLog, bReload, stagePrefixCode, definitions);
+			return stage->program != nullptr;
+		});
 	}
-	return true;
+	// All tasks have to be waited for, since they reference local data
+	auto success = true;
+	for(auto i = decltype(results.size()) {0}; i < results.size(); ++i) {
+		auto &result = results[i];
+		if(!result.future.valid() || loader.Wait(result.future, shader.GetIndex()) || !success)
+			continue;
+		outErrStage = static_cast<ShaderStage>(i);
+		outInfoLog = std::move(result.infoLog);
+		outDebugInfoLog = std::move(result.debugInfoLog);
+		success = false;
+	}
+	return success;
+}
+
+std::shared_ptr<prosper::ShaderStageProgram> prosper::IPrContext::CompileShaderCached(ShaderStage stage, const std::string &shaderPath, std::string &outInfoLog, std::string &outDebugInfoLog, bool reload, const std::string &prefixCode,
+  const std::unordered_map<std::string, std::string> &definitions)
+{
+	auto cache = GetShaderCache();
+	auto compilerVersion = cache ? GetShaderCompilerVersion() : std::string {};
+	if(compilerVersion.empty())
+		return CompileShader(stage, shaderPath, outInfoLog, outDebugInfoLog, reload, prefixCode, definitions);
+
+	// The key is calculated from the preprocessed code, so that changes to any of the included files invalidate the entry.
+	// Errors are reported by the backend compiler below.
+	std::vector<glsl::IncludeLine> includeLines;
+	uint32_t lineOffset = 0;
+	auto preprocessedSource = glsl::load_glsl(*this, stage, shaderPath, nullptr, nullptr, includeLines, lineOffset, prefixCode, definitions);
+	if(!preprocessedSource)
+		return CompileShader(stage, shaderPath, outInfoLog, outDebugInfoLog, reload, prefixCode, definitions);
+	auto key = ShaderCache::CalcKey(*preprocessedSource, definitions, prefixCode, stage, GetAPIIdentifier() + ":" + compilerVersion);
+	auto entry = cache->Load(key);
+	if(entry) {
+		auto program = DeserializeShaderStageProgram(stage, entry->spirv);
+		if(program)
+			return program;
+	}
+
+	auto program = CompileShader(stage, shaderPath, outInfoLog, outDebugInfoLog, reload, prefixCode, definitions);
+	if(!program)
+		return nullptr;
+	auto spirv = SerializeShaderStageProgram(*program);
+	if(!spirv.empty())
+		cache->Store(key, {std::move(*preprocessedSource), lineOffset, std::move(spirv)});
+	return program;
 }
 
 void prosper::IPrContext::Crash()
@@ -0,0 +1,301 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :descriptor_set_cache;
+
+using namespace prosper;
+
+// Reference held by the users of a cached descriptor set group, notifies the cache once the last user is gone
+struct DescriptorSetCache::Lease {
+	std::shared_ptr<IDescriptorSetGroup> descriptorSetGroup;
+	std::weak_ptr<DescriptorSetCache> cache;
+	uint64_t entryId = 0;
+	uint64_t generation = 0;
+	~Lease()
+	{
+		if(auto ptrCache = cache.lock())
+			ptrCache->OnLeaseReleased(entryId, generation);
+	}
+};
+
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::AddTexture(DescriptorSetBinding::Type type, uint32_t bindingIdx, uint32_t arrayIndex, Texture &texture, std::optional<uint32_t> layerId)
+{
+	Resource resource {type, bindingIdx, arrayIndex, layerId};
+	resource.texture = texture.shared_from_this();
+	m_resources.push_back(std::move(resource));
+	return *this;
+}
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::AddBuffer(DescriptorSetBinding::Type type, uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset, uint64_t size)
+{
+	Resource resource {type, bindingIdx, 0, {}, startOffset, size};
+	resource.buffer = buffer.shared_from_this();
+	m_resources.push_back(std::move(resource));
+	return *this;
+}
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetStorageImage(uint32_t bindingIdx, Texture &texture, std::optional<uint32_t> layerId) { return AddTexture(DescriptorSetBinding::Type::StorageImage, bindingIdx, 0, texture, layerId); }
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetTexture(uint32_t bindingIdx, Texture &texture, std::optional<uint32_t> layerId) { return AddTexture(DescriptorSetBinding::Type::Texture, bindingIdx, 0, texture, layerId); }
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetArrayTexture(uint32_t bindingIdx, uint32_t arrayIndex, Texture &texture, std::optional<uint32_t> layerId) { return AddTexture(DescriptorSetBinding::Type::ArrayTexture, bindingIdx, arrayIndex, texture, layerId); }
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetUniformBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset, uint64_t size) { return AddBuffer(DescriptorSetBinding::Type::UniformBuffer, bindingIdx, buffer, startOffset, size); }
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetDynamicUniformBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset, uint64_t size) { return AddBuffer(DescriptorSetBinding::Type::DynamicUniformBuffer, bindingIdx, buffer, startOffset, size); }
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetStorageBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset, uint64_t size) { return AddBuffer(DescriptorSetBinding::Type::StorageBuffer, bindingIdx, buffer, startOffset, size); }
+DescriptorSetCache::Resources &DescriptorSetCache::Resources::SetDynamicStorageBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset, uint64_t size) { return AddBuffer(DescriptorSetBinding::Type::DynamicStorageBuffer, bindingIdx, buffer, startOffset, size); }
+
+///////////////////////////
+
+static void hash_combine(size_t &seed, uint64_t value) { seed ^= std::hash<uint64_t> {}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2); }
+
+static void bind_resource(IDescriptorSet &ds, DescriptorSetBinding::Type type, uint32_t bindingIdx, uint32_t arrayIndex, Texture *texture, IBuffer *buffer, const std::optional<uint32_t> &layerId, uint64_t startOffset, uint64_t size)
+{
+	switch(type) {
+	case DescriptorSetBinding::Type::StorageImage:
+		layerId ? ds.SetBindingStorageImage(*texture, bindingIdx, *layerId) : ds.SetBindingStorageImage(*texture, bindingIdx);
+		break;
+	case DescriptorSetBinding::Type::Texture:
+		layerId ? ds.SetBindingTexture(*texture, bindingIdx, *layerId) : ds.SetBindingTexture(*texture, bindingIdx);
+		break;
+	case DescriptorSetBinding::Type::ArrayTexture:
+		layerId ? ds.SetBindingArrayTexture(*texture, bindingIdx, arrayIndex, *layerId) : ds.SetBindingArrayTexture(*texture, bindingIdx, arrayIndex);
+		break;
+	case DescriptorSetBinding::Type::UniformBuffer:
+		ds.SetBindingUniformBuffer(*buffer, bindingIdx, startOffset, size);
+		break;
+	case DescriptorSetBinding::Type::DynamicUniformBuffer:
+		ds.SetBindingDynamicUniformBuffer(*buffer, bindingIdx, startOffset, size);
+		break;
+	case DescriptorSetBinding::Type::StorageBuffer:
+		ds.SetBindingStorageBuffer(*buffer, bindingIdx, startOffset, size);
+		break;
+	case DescriptorSetBinding::Type::DynamicStorageBuffer:
+		ds.SetBindingDynamicStorageBuffer(*buffer, bindingIdx, startOffset, size);
+		break;
+	}
+}
+
+DescriptorSetCache::DescriptorSetCache(IPrContext &context, uint32_t maxFreeSetsPerLayout) : m_context {context}, m_maxFreeSetsPerLayout {maxFreeSetsPerLayout} {}
+DescriptorSetCache::~DescriptorSetCache() = default;
+
+uint32_t DescriptorSetCache::FindLayout(const DescriptorSetCreateInfo &createInfo)
+{
+	auto &ci = const_cast<DescriptorSetCreateInfo &>(createInfo);
+	std::vector<LayoutBinding> bindings;
+	auto numBindings = ci.GetBindingCount();
+	bindings.reserve(numBindings);
+	for(auto i = decltype(numBindings) {0u}; i < numBindings; ++i) {
+		LayoutBinding binding {};
+		ci.GetBindingPropertiesByIndexNumber(i, &binding.bindingIndex, &binding.descriptorType, &binding.descriptorArraySize, &binding.stageFlags, &binding.immutableSamplers, &binding.flags, &binding.prFlags);
+		bindings.push_back(binding);
+	}
+	auto it = std::find_if(m_layouts.begin(), m_layouts.end(), [&bindings](const Layout &layout) { return layout.bindings == bindings; });
+	if(it != m_layouts.end())
+		return static_cast<uint32_t>(it - m_layouts.begin());
+	m_layouts.push_back({std::move(bindings)});
+	return static_cast<uint32_t>(m_layouts.size() - 1);
+}
+
+std::shared_ptr<IDescriptorSetGroup> DescriptorSetCache::CreateLease(uint64_t entryId, Entry &entry)
+{
+	auto lease = std::make_shared<Lease>();
+	lease->descriptorSetGroup = entry.descriptorSetGroup;
+	lease->cache = weak_from_this();
+	lease->entryId = entryId;
+	lease->generation = ++entry.leaseGeneration;
+	entry.lease = lease;
+	// If the entry is still live, its previous lease has expired, but has not been released yet (and never will be, since
+	// its generation is outdated now), so it's still counted as live
+	if(entry.state != Entry::State::Live)
+		++m_stats.numLiveSets;
+	entry.state = Entry::State::Live;
+	// The lease shares ownership of the descriptor set group, so the group stays valid even if the cache is destroyed first
+	return std::shared_ptr<IDescriptorSetGroup> {lease, lease->descriptorSetGroup.get()};
+}
+
+void DescriptorSetCache::OnLeaseReleased(uint64_t entryId, uint64_t generation)
+{
+	auto frameId = m_context.GetLastFrameId();
+	std::scoped_lock lock {m_mutex};
+	auto it = m_entries.find(entryId);
+	if(it == m_entries.end())
+		return;
+	auto &entry = it->second;
+	// The lease may have expired before its destructor acquired the lock, in which case a concurrent Acquire
+	// may already have handed out a new lease for this entry
+	if(entry.leaseGeneration != generation || entry.state != Entry::State::Live)
+		return;
+	entry.state = Entry::State::Pending;
+	entry.releaseFrame = frameId;
+	m_pendingEntries.insert(entryId);
+	--m_stats.numLiveSets;
+}
+
+void DescriptorSetCache::DetachKey(uint64_t entryId, Entry &entry)
+{
+	if(!entry.key)
+		return;
+	auto it = m_keyToEntry.find(*entry.key);
+	if(it != m_keyToEntry.end() && it->second == entryId)
+		m_keyToEntry.erase(it);
+	entry.key = {};
+}
+
+std::optional<uint64_t> DescriptorSetCache::PopFreeEntry(Layout &layout)
+{
+	if(layout.freeEntries.empty())
+		return {};
+	auto entryId = layout.freeEntries.front();
+	layout.freeEntries.pop_front();
+	return entryId;
+}
+
+std::optional<uint64_t> DescriptorSetCache::AllocateEntry(const DescriptorSetCreateInfo &createInfo, uint32_t layoutIndex, const Resources &resources)
+{
+	auto &layout = m_layouts[layoutIndex];
+	uint64_t entryId;
+	auto freeEntryId = PopFreeEntry(layout);
+	if(freeEntryId) {
+		entryId = *freeEntryId;
+		DetachKey(entryId, m_entries[entryId]);
+		--m_stats.numFreeSets;
+		++m_stats.numRecycled;
+	}
+	else {
+		auto ci = createInfo;
+		auto dsg = m_context.CreateDescriptorSetGroup(ci);
+		if(!dsg)
+			return {};
+		entryId = m_nextEntryId++;
+		m_entries[entryId].descriptorSetGroup = std::move(dsg);
+		++m_stats.numCreated;
+	}
+	auto &entry = m_entries[entryId];
+	entry.layoutIndex = layoutIndex;
+	auto &ds = *entry.descriptorSetGroup->GetDescriptorSet();
+	entry.resources.clear();
+	entry.resources.reserve(resources.m_resources.size());
+	for(auto &res : resources.m_resources) {
+		bind_resource(ds, res.type, res.bindingIndex, res.arrayIndex, res.texture.get(), res.buffer.get(), res.layerId, res.startOffset, res.size);
+		if(res.texture)
+			entry.resources.push_back(res.texture);
+		else
+			entry.resources.push_back(res.buffer);
+	}
+	return entryId;
+}
+
+std::shared_ptr<IDescriptorSetGroup> DescriptorSetCache::Acquire(const DescriptorSetCreateInfo &createInfo, const Resources &resources)
+{
+	std::scoped_lock lock {m_mutex};
+	++m_stats.numRequests;
+	Key key {};
+	key.layoutIndex = FindLayout(createInfo);
+	key.resources.reserve(resources.m_resources.size());
+	key.hash = std::hash<uint32_t> {}(key.layoutIndex);
+	for(auto &res : resources.m_resources) {
+		const void *ptr = res.texture ? static_cast<const void *>(res.texture.get()) : static_cast<const void *>(res.buffer.get());
+		key.resources.push_back({res.type, res.bindingIndex, res.arrayIndex, res.layerId, res.startOffset, res.size, ptr});
+		hash_combine(key.hash, reinterpret_cast<uintptr_t>(ptr));
+		hash_combine(key.hash, (static_cast<uint64_t>(res.bindingIndex) << 32) | res.arrayIndex);
+		hash_combine(key.hash, res.layerId ? (*res.layerId + 1ull) : 0ull);
+		hash_combine(key.hash, res.startOffset ^ (res.size << 1));
+	}
+
+	auto itKey = m_keyToEntry.find(key);
+	if(itKey != m_keyToEntry.end()) {
+		auto entryId = itKey->second;
+		auto &entry = m_entries[entryId];
+		auto valid = std::none_of(entry.resources.begin(), entry.resources.end(), [](const std::weak_ptr<void> &res) { return res.expired(); });
+		if(valid) {
+			++m_stats.numHits;
+			if(auto lease = entry.lease.lock())
+				return std::shared_ptr<IDescriptorSetGroup> {lease, lease->descriptorSetGroup.get()};
+			if(entry.state == Entry::State::Free) {
+				auto &freeEntries = m_layouts[entry.layoutIndex].freeEntries;
+				freeEntries.erase(std::find(freeEntries.begin(), freeEntries.end(), entryId));
+				--m_stats.numFreeSets;
+			}
+			else
+				m_pendingEntries.erase(entryId);
+			return CreateLease(entryId, entry);
+		}
+		// One of the resources has been destroyed and its address may have been reused by the resources of this request
+		DetachKey(entryId, entry);
+	}
+
+	auto entryId = AllocateEntry(createInfo, key.layoutIndex, resources);
+	if(!entryId)
+		return nullptr;
+	auto &entry = m_entries[*entryId];
+	m_keyToEntry[key] = *entryId;
+	entry.key = std::move(key);
+	return CreateLease(*entryId, entry);
+}
+
+std::shared_ptr<IDescriptorSetGroup> DescriptorSetCache::AcquireExclusive(const DescriptorSetCreateInfo &createInfo, const Resources &resources)
+{
+	std::scoped_lock lock {m_mutex};
+	++m_stats.numRequests;
+	// The entry has no key, so it can't be found by other requests
+	auto entryId = AllocateEntry(createInfo, FindLayout(createInfo), resources);
+	if(!entryId)
+		return nullptr;
+	return CreateLease(*entryId, m_entries[*entryId]);
+}
+
+void DescriptorSetCache::Update()
+{
+	auto frameId = m_context.GetLastFrameId();
+	auto numFramesInFlight = m_context.GetMaxNumberOfFramesInFlight();
+	std::scoped_lock lock {m_mutex};
+	for(auto it = m_pendingEntries.begin(); it != m_pendingEntries.end();) {
+		auto itEntry = m_entries.find(*it);
+		if(itEntry == m_entries.end() || itEntry->second.state != Entry::State::Pending) {
+			it = m_pendingEntries.erase(it);
+			continue;
+		}
+		auto &entry = itEntry->second;
+		if(frameId < entry.releaseFrame + numFramesInFlight) {
+			++it;
+			continue;
+		}
+		auto &freeEntries = m_layouts[entry.layoutIndex].freeEntries;
+		if(freeEntries.size() >= m_maxFreeSetsPerLayout) {
+			// The free list is full, the group is no longer in use and can be destroyed
+			DetachKey(itEntry->first, entry);
+			m_entries.erase(itEntry);
+			it = m_pendingEntries.erase(it);
+			continue;
+		}
+		// The entry stays in the key map, so it can still be re-acquired for the same resources until it is recycled
+		entry.state = Entry::State::Free;
+		freeEntries.push_back(itEntry->first);
+		++m_stats.numFreeSets;
+		it = m_pendingEntries.erase(it);
+	}
+}
+
+void DescriptorSetCache::Clear()
+{
+	std::scoped_lock lock {m_mutex};
+	for(auto &layout : m_layouts)
+		layout.freeEntries.clear();
+	for(auto it = m_entries.begin(); it != m_entries.end();) {
+		if(it->second.state != Entry::State::Free) {
+			++it;
+			continue;
+		}
+		DetachKey(it->first, it->second);
+		it = m_entries.erase(it);
+	}
+	m_stats.numFreeSets = 0;
+}
+
+DescriptorSetCache::Stats DescriptorSetCache::GetStats() const
+{
+	std::scoped_lock lock {m_mutex};
+	auto stats = m_stats;
+	stats.numPendingSets = static_cast<uint32_t>(m_pendingEntries.size());
+	return stats;
+}
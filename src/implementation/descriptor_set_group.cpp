@@ -8,6 +8,7 @@ module;
 module pragma.prosper;
 
 import :descriptor_set_group;
+import :descriptor_write_batcher;
 
 using namespace prosper;
 
@@ -228,7 +229,7 @@ bool IDescriptorSet::SetBindingStorageImage(Texture &texture, uint32_t bindingId
 	if(imgView == nullptr)
 		return false;
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingStorageImage>(*this, bindingIdx, texture, layerId));
-	return DoSetBindingStorageImage(texture, bindingIdx, layerId);
+	return MarkBindingDirty(bindingIdx, DoSetBindingStorageImage(texture, bindingIdx, layerId));
 }
 bool IDescriptorSet::SetBindingStorageImage(Texture &texture, uint32_t bindingIdx)
 {
@@ -236,7 +237,7 @@ bool IDescriptorSet::SetBindingStorageImage(Texture &texture, uint32_t bindingId
 	if(imgView == nullptr)
 		return false;
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingStorageImage>(*this, bindingIdx, texture));
-	return DoSetBindingStorageImage(texture, bindingIdx, {});
+	return MarkBindingDirty(bindingIdx, DoSetBindingStorageImage(texture, bindingIdx, {}));
 }
 bool IDescriptorSet::SetBindingTexture(Texture &texture, uint32_t bindingIdx, uint32_t layerId)
 {
@@ -247,7 +248,7 @@ bool IDescriptorSet::SetBindingTexture(Texture &texture, uint32_t bindingIdx, ui
 	if(imgView == nullptr || sampler == nullptr)
 		return false;
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingTexture>(*this, bindingIdx, texture, layerId));
-	return DoSetBindingTexture(texture, bindingIdx, layerId);
+	return MarkBindingDirty(bindingIdx, DoSetBindingTexture(texture, bindingIdx, layerId));
 }
 bool IDescriptorSet::SetBindingTexture(Texture &texture, uint32_t bindingIdx)
 {
@@ -256,7 +257,7 @@ bool IDescriptorSet::SetBindingTexture(Texture &texture, uint32_t bindingIdx)
 	if(imgView == nullptr || sampler == nullptr)
 		return false;
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingTexture>(*this, bindingIdx, texture));
-	return DoSetBindingTexture(texture, bindingIdx, {});
+	return MarkBindingDirty(bindingIdx, DoSetBindingTexture(texture, bindingIdx, {}));
 }
 bool IDescriptorSet::SetBindingArrayTexture(Texture &texture, uint32_t bindingIdx, uint32_t arrayIndex, uint32_t layerId)
 {
@@ -265,7 +266,7 @@ bool IDescriptorSet::SetBindingArrayTexture(Texture &texture, uint32_t bindingId
 		binding = &SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingArrayTexture>(*this, bindingIdx));
 	if(binding && binding->GetType() == DescriptorSetBinding::Type::ArrayTexture)
 		static_cast<DescriptorSetBindingArrayTexture *>(binding)->SetArrayBinding(arrayIndex, std::make_unique<DescriptorSetBindingTexture>(*this, bindingIdx, texture, layerId));
-	return DoSetBindingArrayTexture(texture, bindingIdx, arrayIndex, layerId);
+	return MarkBindingDirty(bindingIdx, DoSetBindingArrayTexture(texture, bindingIdx, arrayIndex, layerId));
 }
 bool IDescriptorSet::SetBindingArrayTexture(Texture &texture, uint32_t bindingIdx, uint32_t arrayIndex)
 {
@@ -274,31 +275,91 @@ bool IDescriptorSet::SetBindingArrayTexture(Texture &texture, uint32_t bindingId
 		binding = &SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingArrayTexture>(*this, bindingIdx));
 	if(binding && binding->GetType() == DescriptorSetBinding::Type::ArrayTexture)
 		static_cast<DescriptorSetBindingArrayTexture *>(binding)->SetArrayBinding(arrayIndex, std::make_unique<DescriptorSetBindingTexture>(*this, bindingIdx, texture));
-	return DoSetBindingArrayTexture(texture, bindingIdx, arrayIndex, {});
+	return MarkBindingDirty(bindingIdx, DoSetBindingArrayTexture(texture, bindingIdx, arrayIndex, {}));
 }
 bool IDescriptorSet::SetBindingUniformBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size)
 {
 	size = (size != std::numeric_limits<decltype(size)>::max()) ? size : buffer.GetSize();
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingUniformBuffer>(*this, bindingIdx, buffer, startOffset, size));
-	return DoSetBindingUniformBuffer(buffer, bindingIdx, startOffset, size);
+	return MarkBindingDirty(bindingIdx, DoSetBindingUniformBuffer(buffer, bindingIdx, startOffset, size));
 }
 bool IDescriptorSet::SetBindingDynamicUniformBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size)
 {
 	size = (size != std::numeric_limits<decltype(size)>::max()) ? size : buffer.GetSize();
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingDynamicUniformBuffer>(*this, bindingIdx, buffer, startOffset, size));
-	return DoSetBindingDynamicUniformBuffer(buffer, bindingIdx, startOffset, size);
+	return MarkBindingDirty(bindingIdx, DoSetBindingDynamicUniformBuffer(buffer, bindingIdx, startOffset, size));
 }
 bool IDescriptorSet::SetBindingStorageBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size)
 {
 	size = (size != std::numeric_limits<decltype(size)>::max()) ? size : buffer.GetSize();
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingStorageBuffer>(*this, bindingIdx, buffer, startOffset, size));
-	return DoSetBindingStorageBuffer(buffer, bindingIdx, startOffset, size);
+	return MarkBindingDirty(bindingIdx, DoSetBindingStorageBuffer(buffer, bindingIdx, startOffset, size));
 }
 bool IDescriptorSet::SetBindingDynamicStorageBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size)
 {
 	size = (size != std::numeric_limits<decltype(size)>::max()) ? size : buffer.GetSize();
 	SetBinding(bindingIdx, std::make_unique<DescriptorSetBindingDynamicStorageBuffer>(*this, bindingIdx, buffer, startOffset, size));
-	return DoSetBindingDynamicStorageBuffer(buffer, bindingIdx, startOffset, size);
+	return MarkBindingDirty(bindingIdx, DoSetBindingDynamicStorageBuffer(buffer, bindingIdx, startOffset, size));
+}
+
+bool IDescriptorSet::MarkBindingDirty(uint32_t bindingIdx, bool result)
+{
+	if(!result)
+		return result;
+	{
+		std::scoped_lock lock {m_dirtyBindingsMutex};
+		if(std::find(m_dirtyBindings.begin(), m_dirtyBindings.end(), bindingIdx) != m_dirtyBindings.end())
+			return result;
+		m_dirtyBindings.push_back(bindingIdx);
+		// The set stays queued until the next flush, so it only has to be enqueued when it becomes dirty
+		if(m_dirtyBindings.size() > 1)
+			return result;
+	}
+	auto *batcher = GetDescriptorSetGroup().GetContext().GetDescriptorWriteBatcher();
+	if(batcher)
+		batcher->Enqueue(*this);
+	return result;
+}
+
+bool IDescriptorSet::Update()
+{
+	ClearDirtyBindings();
+	return true;
+}
+
+bool IDescriptorSet::HasDirtyBindings() const
+{
+	std::scoped_lock lock {m_dirtyBindingsMutex};
+	return !m_dirtyBindings.empty();
+}
+size_t IDescriptorSet::GetDirtyBindingCount() const
+{
+	std::scoped_lock lock {m_dirtyBindingsMutex};
+	return m_dirtyBindings.size();
+}
+std::vector<uint32_t> IDescriptorSet::GetDirtyBindings() const
+{
+	std::scoped_lock lock {m_dirtyBindingsMutex};
+	return m_dirtyBindings;
+}
+void IDescriptorSet::ClearDirtyBindings()
+{
+	std::scoped_lock lock {m_dirtyBindingsMutex};
+	m_dirtyBindings.clear();
+}
+
+bool IDescriptorSet::UpdateDirtyBindings()
+{
+	std::vector<uint32_t> dirtyBindings;
+	{
+		std::scoped_lock lock {m_dirtyBindingsMutex};
+		if(m_dirtyBindings.empty())
+			return true;
+		dirtyBindings = std::move(m_dirtyBindings);
+		m_dirtyBindings.clear();
+	}
+	// The lock can't be held here, since the default implementation calls Update, which clears the dirty bindings
+	return DoUpdateBindings(dirtyBindings);
 }
 
 void IDescriptorSet::ReloadBinding(uint32_t bindingIdx)
@@ -382,7 +443,8 @@ void IDescriptorSet::ReloadBinding(uint32_t bindingIdx)
 	// It would be better to have one descriptor set per swapchain image, flag them as dirty
 	// and update them the next time they're used.
 	GetDescriptorSetGroup().GetContext().WaitIdle(false);
-	Update();
+	MarkBindingDirty(bindingIdx, true);
+	UpdateDirtyBindings();
 }
 
 IBuffer *IDescriptorSet::GetBoundBuffer(uint32_t bindingIndex, uint64_t *outStartOffset, uint64_t *outSize)
@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :descriptor_write_batcher;
+
+using namespace prosper;
+
+DescriptorWriteBatcher::DescriptorWriteBatcher(IPrContext &context) : m_context {context} {}
+
+void DescriptorWriteBatcher::Enqueue(IDescriptorSet &descSet)
+{
+	std::scoped_lock lock {m_mutex};
+	if(!m_queuedSets.insert(&descSet).second)
+		return;
+	m_pendingSets.push_back({descSet.GetDescriptorSetGroup().weak_from_this(), &descSet});
+}
+
+void DescriptorWriteBatcher::Flush()
+{
+	std::vector<PendingSet> pendingSets;
+	{
+		std::scoped_lock lock {m_mutex};
+		if(m_pendingSets.empty())
+			return;
+		pendingSets = std::move(m_pendingSets);
+		m_pendingSets.clear();
+		m_queuedSets.clear();
+	}
+	// Keep the groups alive until the writes have been completed
+	std::vector<std::shared_ptr<IDescriptorSetGroup>> descSetGroups;
+	descSetGroups.reserve(pendingSets.size());
+	m_flushSets.clear();
+	for(auto &pendingSet : pendingSets) {
+		auto dsg = pendingSet.descriptorSetGroup.lock();
+		if(!dsg)
+			continue;
+		// The bindings may have been written by an explicit Update in the meantime
+		auto numDirtyBindings = pendingSet.descriptorSet->GetDirtyBindingCount();
+		if(numDirtyBindings == 0)
+			continue;
+		m_stats.numBindingWrites += numDirtyBindings;
+		m_flushSets.push_back(pendingSet.descriptorSet);
+		descSetGroups.push_back(std::move(dsg));
+	}
+	if(m_flushSets.empty())
+		return;
+	m_context.UpdateDescriptorSets(m_flushSets);
+	++m_stats.numFlushes;
+	m_stats.numDescriptorSets += m_flushSets.size();
+}
+
+void DescriptorWriteBatcher::Clear()
+{
+	std::scoped_lock lock {m_mutex};
+	m_pendingSets.clear();
+	m_queuedSets.clear();
+}
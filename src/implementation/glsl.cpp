@@ -13,17 +13,11 @@ module;
 module pragma.prosper;
 
 import :glsl;
+import :glsl_expression;
+import :shader_system.shader_hot_reloader;
 import :shader_system.shader;
 
 #ifdef VK_ENABLE_GLSLANG
-static unsigned int get_line_break(std::string &str, int pos = 0)
-{
-	auto len = str.length();
-	while(pos < len && str[pos] != '\n')
-		pos++;
-	return pos;
-}
-
 static void print_available_shader_descriptor_set_bindings(const std::unordered_map<std::string, std::string> &definitions, std::stringstream &ss)
 {
 	std::unordered_map<std::string, std::vector<std::string>> descSetInfos;
@@ -95,110 +89,196 @@ static bool translate_layout_ids(std::string &shader, const std::unordered_map<s
 	return true;
 }
 
-// Including shader files can be expensive, so we cache all included files for the future
-static std::unordered_map<std::string, std::string> g_globalIncludeFileCache;
-static std::mutex g_globalIncludeFileCacheMutex;
+namespace {
+	// Immutable contents of a shader file, split into lines. #include directives are resolved up front, so the file never has to be scanned again.
+	struct ShaderFile {
+		struct Include {
+			std::string directive; // Without surrounding whitespace
+			std::string path;
+		};
+		struct Line {
+			size_t offset = 0;
+			size_t length = 0;
+			std::optional<size_t> includeIndex {};
+		};
+		std::string contents;
+		std::vector<Line> lines;
+		std::vector<Include> includes;
+		std::string_view GetLine(const Line &line) const { return std::string_view {contents}.substr(line.offset, line.length); }
+	};
+
+	// Including shader files can be expensive, so we cache all included files for the future.
+	// Entries are never modified after insertion, and the map is split into shards to keep lock contention between loader threads low.
+	class ShaderFileCache {
+	  public:
+		std::shared_ptr<const ShaderFile> Find(const std::string &path)
+		{
+			auto &shard = GetShard(path);
+			std::shared_lock lock {shard.mutex};
+			auto it = shard.files.find(path);
+			return (it != shard.files.end()) ? it->second : nullptr;
+		}
+		// If the file has already been added by another thread in the meantime, the existing entry is returned
+		std::shared_ptr<const ShaderFile> Insert(const std::string &path, std::shared_ptr<const ShaderFile> file)
+		{
+			auto &shard = GetShard(path);
+			std::unique_lock lock {shard.mutex};
+			return shard.files.try_emplace(path, std::move(file)).first->second;
+		}
+		void Clear()
+		{
+			for(auto &shard : m_shards) {
+				std::unique_lock lock {shard.mutex};
+				shard.files.clear();
+			}
+		}
+	  private:
+		static constexpr size_t NUM_SHARDS = 16;
+		struct Shard {
+			std::shared_mutex mutex;
+			std::unordered_map<std::string, std::shared_ptr<const ShaderFile>> files;
+		};
+		Shard &GetShard(const std::string &path) { return m_shards[std::hash<std::string> {}(path) % NUM_SHARDS]; }
+		std::array<Shard, NUM_SHARDS> m_shards;
+	};
+};
+static ShaderFileCache g_globalIncludeFileCache;
 static std::atomic<bool> g_globalIncludeFileCacheEnabled = true;
 
-static bool glsl_preprocessing(const std::string &path, std::string &shader, const std::unordered_map<std::string, std::string> &definitions, std::string &outErr, std::unordered_set<std::string> &includeCache, std::vector<prosper::glsl::IncludeLine> &includeLines, unsigned int &lineId,
-  std::stack<std::string> &includeStack, bool = false)
+static std::string resolve_include_path(const std::string &inc, const std::string &sub)
+{
+	pragma::util::Path includePath {};
+	if(inc.empty() == false && inc.front() == '/')
+		includePath = inc;
+	else
+		includePath = sub.substr(sub.find_first_of("/\\") + 1) + inc;
+	includePath = pragma::util::Path::CreatePath(prosper::Shader::GetRootShaderLocation()) + includePath;
+	auto ext = ufile::get_file_extension(includePath.GetString(), prosper::glsl::get_glsl_file_extensions());
+	if(!ext) {
+		if(includePath.GetString().substr(includePath.GetString().length() - 5) != ".glsl")
+			includePath += ".glsl";
+	}
+	return includePath.GetString();
+}
+
+static bool tokenize_shader_file(const std::string &path, std::string contents, const std::unordered_map<std::string, std::string> &definitions, ShaderFile &outFile, std::string &outErr)
 {
-	if(!translate_layout_ids(shader, definitions, outErr))
+	if(!translate_layout_ids(contents, definitions, outErr))
 		return false;
+	outFile.contents = std::move(contents);
+	auto &str = outFile.contents;
+	std::string sub = pragma::fs::get_path(const_cast<std::string &>(path));
+	size_t pos = 0;
+	size_t br;
+	do {
+		br = str.find('\n', pos);
+		if(br == std::string::npos)
+			br = str.length();
+		ShaderFile::Line line {pos, br - pos};
+		auto *begin = str.data() + pos;
+		auto *end = str.data() + br;
+		while(begin < end && std::isspace(static_cast<unsigned char>(*begin)))
+			++begin;
+		if(end - begin >= 8 && std::string_view {begin, 8} == "#include") {
+			std::string l {begin, end};
+			pragma::string::remove_whitespace(l);
+			std::string inc = l.substr(8, l.length());
+			pragma::string::remove_whitespace(inc);
+			pragma::string::remove_quotes(inc);
+			line.includeIndex = outFile.includes.size();
+			outFile.includes.push_back({std::move(l), resolve_include_path(inc, sub)});
+		}
+		outFile.lines.push_back(line);
+		pos = br + 1;
+	} while(br < str.length());
+	return true;
+}
+
+static std::shared_ptr<const ShaderFile> load_include_file(const std::string &path, const std::unordered_map<std::string, std::string> &definitions, std::string &outErr)
+{
+	auto useGlobalCache = g_globalIncludeFileCacheEnabled.load();
+	if(useGlobalCache) {
+		auto file = g_globalIncludeFileCache.Find(path);
+		if(file)
+			return file;
+	}
+	auto f = pragma::fs::open_file(path, pragma::fs::FileMode::Read | pragma::fs::FileMode::Binary);
+	if(f == nullptr)
+		return nullptr;
+	unsigned long long flen = f->GetSize();
+	std::vector<char> data(flen + 1);
+	f->Read(data.data(), flen);
+	data[flen] = '\0';
+	auto file = std::make_shared<ShaderFile>();
+	if(!tokenize_shader_file(path, data.data(), definitions, *file, outErr))
+		return nullptr;
+	if(useGlobalCache)
+		return g_globalIncludeFileCache.Insert(path, std::move(file));
+	return file;
+}
 
+// Appends the contents of the file to the output in a single forward pass, included files are expanded recursively.
+// Every #include directive is replaced with a comment, followed by the contents of the included file.
+static bool expand_includes(const std::string &path, const ShaderFile &file, std::string &out, const std::unordered_map<std::string, std::string> &definitions, std::string &outErr, std::unordered_set<std::string> &includeCache,
+  std::vector<prosper::glsl::IncludeLine> &includeLines, unsigned int &lineId, std::stack<std::string> &includeStack, prosper::ShaderDependencyGraph *dependencyGraph)
+{
+	if(dependencyGraph && !path.empty()) {
+		std::vector<std::string> includes;
+		includes.reserve(file.includes.size());
+		for(auto &include : file.includes)
+			includes.push_back(include.path);
+		dependencyGraph->SetIncludes(path, includes);
+	}
 	auto depth = includeStack.size();
 	if(!includeLines.empty() && includeLines.back().lineId == lineId)
 		includeLines.back() = prosper::glsl::IncludeLine(lineId, path, depth);
 	else
 		includeLines.push_back(prosper::glsl::IncludeLine(lineId, path, depth));
 	includeLines.back().includeStack = includeStack;
-	//auto incIdx = includeLines.size() -1;
-	std::string sub = pragma::fs::get_path(const_cast<std::string &>(path));
-	auto len = shader.length();
-	unsigned int br;
-	unsigned int brLast = 0;
-	do {
-		//std::cout<<"Length: "<<len<<"("<<shader.length()<<")"<<std::endl;
-		br = get_line_break(shader, brLast);
-		std::string l = shader.substr(brLast, br - brLast);
-		pragma::string::remove_whitespace(l);
-		if(l.length() >= 8) {
-			if(l.substr(0, 8) == "#include") {
-				std::string inc = l.substr(8, l.length());
-				pragma::string::remove_whitespace(inc);
-				pragma::string::remove_quotes(inc);
-				pragma::util::Path includePath {};
-				if(inc.empty() == false && inc.front() == '/')
-					includePath = inc;
-				else
-					includePath = sub.substr(sub.find_first_of("/\\") + 1) + inc;
-				includePath = pragma::util::Path::CreatePath(prosper::Shader::GetRootShaderLocation()) + includePath;
-				auto ext = ufile::get_file_extension(includePath.GetString(), prosper::glsl::get_glsl_file_extensions());
-				if(!ext) {
-					if(includePath.GetString().substr(includePath.GetString().length() - 5) != ".glsl")
-						includePath += ".glsl";
-				}
-				auto &strPath = includePath.GetString();
-				constexpr auto useIncludeCache = false;
-				if(!useIncludeCache || includeCache.find(strPath) == includeCache.end()) {
-					includeCache.insert(strPath);
-
-					if(g_globalIncludeFileCacheEnabled) {
-						g_globalIncludeFileCacheMutex.lock();
-						auto it = g_globalIncludeFileCache.find(strPath);
-						auto isInCache = it != g_globalIncludeFileCache.end();
-						g_globalIncludeFileCacheMutex.unlock();
-						if(isInCache) {
-							shader = shader.substr(0, brLast) + it->second + shader.substr(br);
-							br = brLast + it->second.length();
-							len = shader.length();
-							continue;
-						}
-					}
-					auto f = pragma::fs::open_file(includePath.GetString(), pragma::fs::FileMode::Read | pragma::fs::FileMode::Binary);
-					if(f != NULL) {
-						unsigned long long flen = f->GetSize();
-						std::vector<char> data(flen + 1);
-						f->Read(data.data(), flen);
-						data[flen] = '\0';
-						std::string subShader = data.data();
-						lineId++; // #include-directive
-						includeStack.push(includePath.GetString());
-						if(glsl_preprocessing(includePath.GetString(), subShader, definitions, outErr, includeCache, includeLines, lineId, includeStack) == false)
-							return false;
-						includeLines.push_back(prosper::glsl::IncludeLine(lineId, path, depth, true));
-						includeLines.back().includeStack = includeStack;
-						includeStack.pop();
-						lineId--; // Why?
-						          //subShader = std::string("\n#line 1\n") +subShader +std::string("\n#line ") +util::to_string(lineId) +std::string("\n");
-						if(g_globalIncludeFileCacheEnabled) {
-							g_globalIncludeFileCacheMutex.lock();
-							g_globalIncludeFileCache[strPath] = subShader;
-							g_globalIncludeFileCacheMutex.unlock();
-						}
-						shader = shader.substr(0, brLast) + std::string("//") + l + std::string("\n") + subShader + shader.substr(br);
-						br = static_cast<uint32_t>(brLast) + static_cast<uint32_t>(l.length()) + 3 + static_cast<uint32_t>(subShader.length());
-					}
-					else {
-						outErr = "Unable to include file '" + includePath.GetString() + "' (In: '" + path + "'): File not found!";
-						shader = shader.substr(0, brLast) + shader.substr(br);
-						br = brLast;
-						return false;
-					}
-				}
-				else {
-					shader = shader.substr(0, brLast) + shader.substr(br);
-					br = brLast;
-				}
-				len = shader.length();
-			}
+	for(auto i = decltype(file.lines.size()) {0u}; i < file.lines.size(); ++i) {
+		if(i > 0)
+			out += '\n';
+		auto &line = file.lines[i];
+		if(!line.includeIndex.has_value()) {
+			out += file.GetLine(line);
+			lineId++;
+			continue;
 		}
-		lineId++;
-		brLast = br + 1;
-	} while(br < len);
+		auto &include = file.includes[*line.includeIndex];
+		includeCache.insert(include.path);
+		auto subFile = load_include_file(include.path, definitions, outErr);
+		if(!subFile) {
+			if(outErr.empty())
+				outErr = "Unable to include file '" + include.path + "' (In: '" + path + "'): File not found!";
+			return false;
+		}
+		out += "//";
+		out += include.directive;
+		out += '\n';
+		lineId++; // #include-directive
+		includeStack.push(include.path);
+		if(!expand_includes(include.path, *subFile, out, definitions, outErr, includeCache, includeLines, lineId, includeStack, dependencyGraph))
+			return false;
+		includeLines.push_back(prosper::glsl::IncludeLine(lineId, path, depth, true));
+		includeLines.back().includeStack = includeStack;
+		includeStack.pop();
+	}
 	return true;
 }
 
+static bool glsl_preprocessing(const std::string &path, std::string &shader, const std::unordered_map<std::string, std::string> &definitions, std::string &outErr, std::unordered_set<std::string> &includeCache, std::vector<prosper::glsl::IncludeLine> &includeLines, unsigned int &lineId,
+  std::stack<std::string> &includeStack, prosper::ShaderDependencyGraph *dependencyGraph = nullptr)
+{
+	ShaderFile file {};
+	if(!tokenize_shader_file(path, std::move(shader), definitions, file, outErr))
+		return false;
+	std::string out;
+	out.reserve(file.contents.size());
+	auto res = expand_includes(path, file, out, definitions, outErr, includeCache, includeLines, lineId, includeStack, dependencyGraph);
+	shader = std::move(out);
+	return res;
+}
+
 static bool glsl_preprocessing(prosper::IPrContext &context, prosper::ShaderStage stage, const std::string &path, std::string &shader, std::string &err, std::unordered_set<std::string> &includeCache, std::vector<prosper::glsl::IncludeLine> &includeLines, unsigned int &lineId,
   std::stack<std::string> &includeStack, const std::string &prefixCode = {}, std::unordered_map<std::string, std::string> definitions = {}, bool bHlsl = false)
 {
@@ -212,7 +292,9 @@ static bool glsl_preprocessing(prosper::IPrContext &context, prosper::ShaderStag
 		lineId = numPrefixLines;
 		includeLines.push_back({});
 	}
-	auto r = glsl_preprocessing(path, shader, definitions, err, includeCache, includeLines, lineId, includeStack, true);
+	auto *hotReloader = context.GetShaderHotReloader();
+	auto *dependencyGraph = hotReloader ? &hotReloader->GetDependencyGraph() : nullptr;
+	auto r = glsl_preprocessing(path, shader, definitions, err, includeCache, includeLines, lineId, includeStack, dependencyGraph);
 	if(r == false)
 		return false;
 	// Custom definitions
@@ -269,7 +351,7 @@ static bool glsl_preprocessing(prosper::IPrContext &context, prosper::ShaderStag
 	// This is additional code that should be inserted to the top of the glsl file.
 	auto prefixCodeTranslated = STANDARD_PREFIX_CODE + prefixCode;
 	includeCache.clear();
-	if(!glsl_preprocessing("", prefixCodeTranslated, definitions, err, includeCache, includeLines, lineId, includeStack, true))
+	if(!glsl_preprocessing("", prefixCodeTranslated, definitions, err, includeCache, includeLines, lineId, includeStack, dependencyGraph))
 		return false;
 	def += prefixCodeTranslated;
 	//def += "\n#line 1\n";
@@ -333,8 +415,10 @@ static void parse_definitions(const std::string &glslShader, std::unordered_map<
 
 	struct Expression {
 		std::string expression;
-		mup::ParserX parser {};
+		std::shared_ptr<const prosper::glsl::ConstantExpression> program {};
+		std::unique_ptr<mup::ParserX> parser {}; // Fallback for expressions not supported by the constant expression evaluator
 		std::optional<int> value {};
+		bool evaluating = false;
 
 		std::vector<std::string> variables {};
 	};
@@ -343,36 +427,65 @@ static void parse_definitions(const std::string &glslShader, std::unordered_map<
 	for(auto &pair : definitions) {
 		Expression expr {};
 		expr.expression = pair.second;
-		expr.parser.SetExpr(pair.second);
-		try {
-			for(auto &a : expr.parser.GetExprVar())
-				expr.variables.push_back(a.first);
-		}
-		catch(const mup::ParserError &err) {
-			continue;
+		expr.program = prosper::glsl::ConstantExpression::Get(pair.second);
+		if(expr.program)
+			expr.variables = expr.program->GetVariables();
+		else {
+			expr.parser = std::make_unique<mup::ParserX>();
+			expr.parser->SetExpr(pair.second);
+			try {
+				for(auto &a : expr.parser->GetExprVar())
+					expr.variables.push_back(a.first);
+			}
+			catch(const mup::ParserError &err) {
+				continue;
+			}
 		}
-		expressions.insert(std::make_pair(pair.first, expr));
+		expressions.insert(std::make_pair(pair.first, std::move(expr)));
 	}
 	std::function<bool(Expression &)> fParseExpression = nullptr;
 	fParseExpression = [&fParseExpression, &expressions](Expression &expr) {
-		for(auto &var : expr.variables) {
-			auto it = expressions.find(var);
-			if(it == expressions.end())
-				return false;
-			if(it->second.value.has_value() == false && fParseExpression(it->second) == false)
+		// Guard against definitions referencing each other
+		if(expr.evaluating)
+			return false;
+		expr.evaluating = true;
+		std::vector<double> variableValues;
+		variableValues.reserve(expr.variables.size());
+		auto res = [&]() {
+			for(auto &var : expr.variables) {
+				auto it = expressions.find(var);
+				if(it == expressions.end())
+					return false;
+				if(it->second.value.has_value() == false && fParseExpression(it->second) == false)
+					return false;
+				variableValues.push_back(*it->second.value);
+			}
+			return true;
+		}();
+		expr.evaluating = false;
+		if(!res)
+			return false;
+		if(expr.program) {
+			auto val = expr.program->Evaluate(variableValues);
+			if(!val.has_value() || *val < std::numeric_limits<int>::lowest() || *val > std::numeric_limits<int>::max())
 				return false;
-			if(expr.parser.IsConstDefined(var))
+			expr.value = static_cast<int>(*val);
+			return true;
+		}
+		for(auto i = decltype(expr.variables.size()) {0u}; i < expr.variables.size(); ++i) {
+			auto &var = expr.variables[i];
+			if(expr.parser->IsConstDefined(var))
 				continue;
 			try {
-				expr.parser.DefineConst(var, mup::int_type {*it->second.value});
+				expr.parser->DefineConst(var, mup::int_type {static_cast<int>(variableValues[i])});
 			}
 			catch(const mup::ParserError &err) {
 				return false;
 			}
 		}
 		try {
-			expr.parser.SetExpr(expr.expression);
-			auto &val = expr.parser.Eval();
+			expr.parser->SetExpr(expr.expression);
+			auto &val = expr.parser->Eval();
 			expr.value = val.GetFloat();
 		}
 		catch(const mup::ParserError &err) {
@@ -382,7 +495,8 @@ static void parse_definitions(const std::string &glslShader, std::unordered_map<
 	};
 	for(auto &pair : expressions) {
 		auto &expr = pair.second;
-		fParseExpression(expr);
+		if(expr.value.has_value() == false)
+			fParseExpression(expr);
 		if(pair.second.value.has_value() == false)
 			continue;
 		outDefinitions.insert(std::make_pair(pair.first, *pair.second.value));
@@ -684,6 +798,7 @@ void prosper::glsl::dump_parsed_shader(IPrContext &context, uint32_t stage, cons
 
 void prosper::glsl::set_global_include_file_cache_enabled(bool enabled) { g_globalIncludeFileCacheEnabled = enabled; }
 bool prosper::glsl::is_global_include_file_cache_enabled() { return g_globalIncludeFileCacheEnabled; }
+void prosper::glsl::clear_global_include_file_cache() { g_globalIncludeFileCache.Clear(); }
 
 const std::vector<std::string> &prosper::glsl::get_glsl_file_extensions()
 {
@@ -0,0 +1,345 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :glsl_expression;
+
+using namespace prosper::glsl;
+
+// Recursive descent parser, which emits the instructions in postfix order
+class ConstantExpression::Compiler {
+  public:
+	Compiler(const std::string &expression, ConstantExpression &program) : m_expression {expression}, m_program {program} {}
+	bool Compile()
+	{
+		if(!ParseTernary())
+			return false;
+		SkipWhitespace();
+		return m_pos == m_expression.length() && m_stackSize == 1;
+	}
+  private:
+	struct BinaryOperator {
+		std::string_view token;
+		OpCode opCode;
+	};
+	void SkipWhitespace()
+	{
+		while(m_pos < m_expression.length() && std::isspace(static_cast<unsigned char>(m_expression[m_pos])))
+			++m_pos;
+	}
+	bool Match(std::string_view token)
+	{
+		SkipWhitespace();
+		if(m_expression.compare(m_pos, token.length(), token) != 0)
+			return false;
+		m_pos += token.length();
+		return true;
+	}
+	void Emit(Instruction instruction, int32_t stackDelta)
+	{
+		m_program.m_program.push_back(instruction);
+		m_stackSize += stackDelta;
+		m_program.m_maxStackSize = pragma::math::max(m_program.m_maxStackSize, static_cast<uint32_t>(m_stackSize));
+	}
+	bool ParseTernary()
+	{
+		if(!ParseBinary(0))
+			return false;
+		if(!Match("?"))
+			return true;
+		if(!ParseTernary() || !Match(":") || !ParseTernary())
+			return false;
+		Emit({OpCode::Select}, -2);
+		return true;
+	}
+	// Operators are grouped by precedence, from lowest to highest
+	bool ParseBinary(size_t level)
+	{
+		static const std::array<std::vector<BinaryOperator>, 9> operators {{
+		  {{"||", OpCode::LogicalOr}},
+		  {{"&&", OpCode::LogicalAnd}},
+		  {{"|", OpCode::BitwiseOr}},
+		  {{"&", OpCode::BitwiseAnd}},
+		  {{"==", OpCode::Equal}, {"!=", OpCode::NotEqual}},
+		  {{"<=", OpCode::LessEqual}, {">=", OpCode::GreaterEqual}, {"<", OpCode::Less}, {">", OpCode::Greater}},
+		  {{"<<", OpCode::ShiftLeft}, {">>", OpCode::ShiftRight}},
+		  {{"+", OpCode::Add}, {"-", OpCode::Subtract}},
+		  {{"*", OpCode::Multiply}, {"/", OpCode::Divide}, {"%", OpCode::Modulo}},
+		}};
+		if(level == operators.size())
+			return ParseUnary();
+		if(!ParseBinary(level + 1))
+			return false;
+		for(;;) {
+			auto *op = MatchOperator(operators[level]);
+			if(!op)
+				return true;
+			if(!ParseBinary(level + 1))
+				return false;
+			Emit({op->opCode}, -1);
+		}
+	}
+	const BinaryOperator *MatchOperator(const std::vector<BinaryOperator> &operators)
+	{
+		SkipWhitespace();
+		for(auto &op : operators) {
+			if(m_expression.compare(m_pos, op.token.length(), op.token) != 0)
+				continue;
+			// Don't match the first character of a two character operator, e.g. "&" in "&&" or "<" in "<<"
+			auto next = m_pos + op.token.length();
+			if(op.token.length() == 1 && next < m_expression.length()) {
+				auto c = m_expression[next];
+				if((c == op.token[0] && (c == '&' || c == '|' || c == '<' || c == '>')) || (c == '=' && op.token[0] != '='))
+					continue;
+			}
+			m_pos = next;
+			return &op;
+		}
+		return nullptr;
+	}
+	bool ParseUnary()
+	{
+		SkipWhitespace();
+		if(m_pos >= m_expression.length())
+			return false;
+		std::optional<OpCode> opCode {};
+		switch(m_expression[m_pos]) {
+		case '-':
+			opCode = OpCode::Negate;
+			break;
+		case '!':
+			opCode = OpCode::LogicalNot;
+			break;
+		case '~':
+			opCode = OpCode::BitwiseNot;
+			break;
+		case '+':
+			++m_pos;
+			return ParseUnary();
+		}
+		if(opCode) {
+			++m_pos;
+			if(!ParseUnary())
+				return false;
+			Emit({*opCode}, 0);
+			return true;
+		}
+		return ParsePower();
+	}
+	// "^" is the power operator (as it was with the previous muparserx-based evaluator), not a bitwise xor.
+	// It binds tighter than unary operators and is right-associative, i.e. -2^2 == -4 and 2^3^2 == 2^9.
+	bool ParsePower()
+	{
+		if(!ParsePrimary())
+			return false;
+		if(!Match("^"))
+			return true;
+		if(!ParseUnary())
+			return false;
+		Emit({OpCode::Power}, -1);
+		return true;
+	}
+	bool ParsePrimary()
+	{
+		if(Match("(")) {
+			if(!ParseTernary())
+				return false;
+			return Match(")");
+		}
+		auto c = m_expression[m_pos];
+		if(std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+			return ParseNumber();
+		if(!std::isalpha(static_cast<unsigned char>(c)) && c != '_')
+			return false;
+		auto start = m_pos;
+		while(m_pos < m_expression.length() && (std::isalnum(static_cast<unsigned char>(m_expression[m_pos])) || m_expression[m_pos] == '_'))
+			++m_pos;
+		auto name = m_expression.substr(start, m_pos - start);
+		SkipWhitespace();
+		if(m_pos < m_expression.length() && m_expression[m_pos] == '(')
+			return false; // Function calls and constructors aren't supported
+		if(name == "true" || name == "false") {
+			Emit({OpCode::Constant, (name == "true") ? 1.0 : 0.0}, 1);
+			return true;
+		}
+		// Built-in constants of muparserx, they take precedence over definitions of the same name
+		if(name == "pi" || name == "e") {
+			Emit({OpCode::Constant, (name == "pi") ? std::numbers::pi : std::numbers::e}, 1);
+			return true;
+		}
+		auto &variables = m_program.m_variables;
+		auto it = std::find(variables.begin(), variables.end(), name);
+		if(it == variables.end())
+			it = variables.insert(variables.end(), name);
+		Emit({OpCode::Variable, 0.0, static_cast<uint32_t>(it - variables.begin())}, 1);
+		return true;
+	}
+	bool ParseNumber()
+	{
+		auto *start = m_expression.c_str() + m_pos;
+		char *end = nullptr;
+		double value;
+		if(start[0] == '0' && (start[1] == 'x' || start[1] == 'X')) {
+			// strtoull would accept a sign or whitespace, and "0x" without any digits isn't a valid literal
+			if(!std::isxdigit(static_cast<unsigned char>(start[2])))
+				return false;
+			value = static_cast<double>(std::strtoull(start + 2, &end, 16));
+		}
+		else
+			value = std::strtod(start, &end);
+		if(end == start)
+			return false;
+		m_pos += end - start;
+		// Type suffixes
+		while(m_pos < m_expression.length() && std::strchr("uUlLfF", m_expression[m_pos]) != nullptr && m_expression[m_pos] != '\0')
+			++m_pos;
+		if(m_pos < m_expression.length() && (std::isalnum(static_cast<unsigned char>(m_expression[m_pos])) || m_expression[m_pos] == '_'))
+			return false;
+		Emit({OpCode::Constant, value}, 1);
+		return true;
+	}
+
+	const std::string &m_expression;
+	ConstantExpression &m_program;
+	size_t m_pos = 0;
+	int32_t m_stackSize = 0;
+};
+
+std::shared_ptr<const ConstantExpression> ConstantExpression::Compile(const std::string &expression)
+{
+	std::shared_ptr<ConstantExpression> program {new ConstantExpression {}};
+	Compiler compiler {expression, *program};
+	if(!compiler.Compile())
+		return nullptr;
+	return program;
+}
+
+std::shared_ptr<const ConstantExpression> ConstantExpression::Get(const std::string &expression)
+{
+	// The same definitions are included by most shaders, so the number of unique expressions is small
+	static std::unordered_map<std::string, std::shared_ptr<const ConstantExpression>> cache;
+	static std::shared_mutex cacheMutex;
+	{
+		std::shared_lock lock {cacheMutex};
+		auto it = cache.find(expression);
+		if(it != cache.end())
+			return it->second;
+	}
+	auto program = Compile(expression);
+	std::unique_lock lock {cacheMutex};
+	return cache.try_emplace(expression, std::move(program)).first->second;
+}
+
+std::optional<double> ConstantExpression::Evaluate(const std::vector<double> &variableValues) const
+{
+	if(variableValues.size() != m_variables.size())
+		return {};
+	constexpr uint32_t maxLocalStackSize = 32;
+	std::array<double, maxLocalStackSize> localStack;
+	std::vector<double> heapStack;
+	auto *stack = localStack.data();
+	if(m_maxStackSize > maxLocalStackSize) {
+		heapStack.resize(m_maxStackSize);
+		stack = heapStack.data();
+	}
+	size_t top = 0;
+	auto toInt = [](double v) { return static_cast<int64_t>(v); };
+	for(auto &instruction : m_program) {
+		switch(instruction.opCode) {
+		case OpCode::Constant:
+			stack[top++] = instruction.value;
+			continue;
+		case OpCode::Variable:
+			stack[top++] = variableValues[instruction.variable];
+			continue;
+		case OpCode::Negate:
+			stack[top - 1] = -stack[top - 1];
+			continue;
+		case OpCode::LogicalNot:
+			stack[top - 1] = (stack[top - 1] == 0.0) ? 1.0 : 0.0;
+			continue;
+		case OpCode::BitwiseNot:
+			stack[top - 1] = static_cast<double>(~toInt(stack[top - 1]));
+			continue;
+		case OpCode::Select:
+			top -= 2;
+			stack[top - 1] = (stack[top - 1] != 0.0) ? stack[top] : stack[top + 1];
+			continue;
+		default:
+			break;
+		}
+		auto b = stack[--top];
+		auto &a = stack[top - 1];
+		switch(instruction.opCode) {
+		case OpCode::Power:
+			a = std::pow(a, b);
+			break;
+		case OpCode::Multiply:
+			a *= b;
+			break;
+		case OpCode::Divide:
+			if(b == 0.0)
+				return {};
+			a /= b;
+			break;
+		case OpCode::Modulo:
+			if(b == 0.0)
+				return {};
+			a = std::fmod(a, b);
+			break;
+		case OpCode::Add:
+			a += b;
+			break;
+		case OpCode::Subtract:
+			a -= b;
+			break;
+		case OpCode::ShiftLeft:
+		case OpCode::ShiftRight:
+			{
+				auto shift = toInt(b);
+				if(shift < 0 || shift >= 64)
+					return {};
+				a = static_cast<double>((instruction.opCode == OpCode::ShiftLeft) ? (toInt(a) << shift) : (toInt(a) >> shift));
+				break;
+			}
+		case OpCode::Less:
+			a = (a < b) ? 1.0 : 0.0;
+			break;
+		case OpCode::LessEqual:
+			a = (a <= b) ? 1.0 : 0.0;
+			break;
+		case OpCode::Greater:
+			a = (a > b) ? 1.0 : 0.0;
+			break;
+		case OpCode::GreaterEqual:
+			a = (a >= b) ? 1.0 : 0.0;
+			break;
+		case OpCode::Equal:
+			a = (a == b) ? 1.0 : 0.0;
+			break;
+		case OpCode::NotEqual:
+			a = (a != b) ? 1.0 : 0.0;
+			break;
+		case OpCode::BitwiseAnd:
+			a = static_cast<double>(toInt(a) & toInt(b));
+			break;
+		case OpCode::BitwiseOr:
+			a = static_cast<double>(toInt(a) | toInt(b));
+			break;
+		case OpCode::LogicalAnd:
+			a = (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
+			break;
+		case OpCode::LogicalOr:
+			a = (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
+			break;
+		default:
+			return {};
+		}
+	}
+	if(top != 1 || !std::isfinite(stack[0]))
+		return {};
+	return stack[0];
+}
@@ -7,7 +7,9 @@ module;
 
 module pragma.prosper;
 
+import :buffer.image_readback;
 import :image.image;
+import :pixel_conversion;
 import pragma.image;
 
 using namespace prosper;
@@ -129,6 +131,115 @@ static std::optional<pragma::image::TextureInfo::OutputFormat> get_texture_info_
 	return {};
 }
 
+// Encodes all layers and mipmaps of the image into the block-compressed format. Missing mipmaps are generated with a box filter.
+static bool compress_image_blocks(IImage &image, Format format, uint32_t numDstMipmaps, const util::BlockCompressionInfo &compressionInfo, std::vector<std::vector<std::vector<uint8_t>>> &outData)
+{
+	auto numLayers = image.GetLayerCount();
+	auto numSrcMipmaps = image.GetMipmapCount();
+	auto fGetData = util::image_to_data(image, image.IsSrgb() ? Format::R8G8B8A8_SRGB : Format::R8G8B8A8_UNorm);
+	if(!fGetData)
+		return false;
+	// Uncompressed RGBA8 data for every layer and mipmap
+	std::vector<std::vector<std::vector<uint8_t>>> rgbaData;
+	rgbaData.resize(numLayers, std::vector<std::vector<uint8_t>>(numDstMipmaps));
+	for(auto iLayer = decltype(numLayers) {0u}; iLayer < numLayers; ++iLayer) {
+		for(auto iMipmap = decltype(numDstMipmaps) {0u}; iMipmap < numDstMipmaps; ++iMipmap) {
+			auto extents = image.GetExtents(iMipmap);
+			auto &mipData = rgbaData[iLayer][iMipmap];
+			mipData.resize(static_cast<size_t>(extents.width) * extents.height * 4);
+			if(iMipmap < numSrcMipmaps) {
+				std::function<void(void)> deleter = nullptr;
+				auto *data = fGetData(iLayer, iMipmap, deleter);
+				if(!data)
+					return false;
+				memcpy(mipData.data(), data, mipData.size());
+				if(deleter)
+					deleter();
+				continue;
+			}
+			auto &parentData = rgbaData[iLayer][iMipmap - 1];
+			auto parentExtents = image.GetExtents(iMipmap - 1);
+			for(auto y = 0u; y < extents.height; ++y) {
+				auto y0 = pragma::math::min(y * 2, parentExtents.height - 1);
+				auto y1 = pragma::math::min(y * 2 + 1, parentExtents.height - 1);
+				for(auto x = 0u; x < extents.width; ++x) {
+					auto x0 = pragma::math::min(x * 2, parentExtents.width - 1);
+					auto x1 = pragma::math::min(x * 2 + 1, parentExtents.width - 1);
+					for(auto c = 0u; c < 4; ++c) {
+						auto sum = parentData[(y0 * parentExtents.width + x0) * 4 + c] + parentData[(y0 * parentExtents.width + x1) * 4 + c] + parentData[(y1 * parentExtents.width + x0) * 4 + c]
+						  + parentData[(y1 * parentExtents.width + x1) * 4 + c];
+						mipData[(y * extents.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+
+	// Split the work into tiles of block rows, which are processed by all threads
+	constexpr uint32_t blockRowsPerTile = 16;
+	auto blockSize = util::get_format_info(format).blockSize;
+	struct Tile {
+		uint32_t layer;
+		uint32_t mipmap;
+		uint32_t firstBlockRow;
+	};
+	std::vector<Tile> tiles;
+	outData.clear();
+	outData.resize(numLayers, std::vector<std::vector<uint8_t>>(numDstMipmaps));
+	for(auto iLayer = decltype(numLayers) {0u}; iLayer < numLayers; ++iLayer) {
+		for(auto iMipmap = decltype(numDstMipmaps) {0u}; iMipmap < numDstMipmaps; ++iMipmap) {
+			auto extents = image.GetExtents(iMipmap);
+			auto numBlocksX = (extents.width + 3) / 4;
+			auto numBlocksY = (extents.height + 3) / 4;
+			outData[iLayer][iMipmap].resize(static_cast<size_t>(numBlocksX) * numBlocksY * blockSize);
+			for(auto row = 0u; row < numBlocksY; row += blockRowsPerTile)
+				tiles.push_back({iLayer, iMipmap, row});
+		}
+	}
+	std::atomic<uint32_t> nextTile = 0;
+	auto fProcessTiles = [&]() {
+		for(auto i = nextTile++; i < tiles.size(); i = nextTile++) {
+			auto &tile = tiles[i];
+			auto extents = image.GetExtents(tile.mipmap);
+			util::compress_blocks(format, rgbaData[tile.layer][tile.mipmap].data(), extents.width, extents.height, tile.firstBlockRow, blockRowsPerTile, outData[tile.layer][tile.mipmap].data(), compressionInfo.quality);
+		}
+	};
+	// Dedicated threads are used instead of the shared worker pools, since the caller may itself be running on one of them
+	auto numThreads = (compressionInfo.numThreads > 0) ? compressionInfo.numThreads : pragma::math::max(std::thread::hardware_concurrency(), 1u);
+	numThreads = pragma::math::min(numThreads, static_cast<uint32_t>(tiles.size()));
+	std::vector<std::thread> threads;
+	if(numThreads > 1) {
+		threads.reserve(numThreads - 1);
+		for(auto i = 1u; i < numThreads; ++i)
+			threads.push_back(std::thread {fProcessTiles});
+	}
+	fProcessTiles();
+	for(auto &thread : threads)
+		thread.join();
+	return true;
+}
+
+// Copies the first layer and mipmap of the image into the buffer, in the format of the image
+static bool record_copy_to_host_buffer(ICommandBuffer &cmd, IImage &img, ImageLayout curImgLayout, IBuffer &buf)
+{
+	cmd.RecordImageBarrier(img, curImgLayout, ImageLayout::TransferSrcOptimal);
+	util::BufferImageCopyInfo bufImgCopyInfo {};
+	bufImgCopyInfo.dstImageLayout = ImageLayout::TransferSrcOptimal;
+	auto result = cmd.RecordCopyImageToBuffer(bufImgCopyInfo, img, ImageLayout::TransferSrcOptimal, buf);
+	cmd.RecordImageBarrier(img, ImageLayout::TransferSrcOptimal, curImgLayout);
+	return result;
+}
+static bool convert_host_buffer(IBuffer &buf, Format srcFormat, pragma::image::ImageBuffer &imgBuf, Format dstFormat)
+{
+	auto numPixels = static_cast<size_t>(imgBuf.GetWidth()) * imgBuf.GetHeight();
+	void *data = nullptr;
+	if(!buf.Map(0, numPixels * util::get_byte_size(srcFormat), IBuffer::MapFlags::ReadBit, &data))
+		return false;
+	auto result = util::convert_pixels(data, srcFormat, imgBuf.GetData(), dstFormat, numPixels);
+	buf.Unmap();
+	return result;
+}
+
 std::shared_ptr<pragma::image::ImageBuffer> IImage::ToHostImageBuffer(pragma::image::Format format, ImageLayout curImgLayout) const
 {
 	if(!pragma::math::is_flag_set(m_createInfo.usage, ImageUsageFlags::TransferSrcBit))
@@ -137,6 +248,24 @@ std::shared_ptr<pragma::image::ImageBuffer> IImage::ToHostImageBuffer(pragma::im
 	auto cmd = context.GetSetupCommandBuffer();
 	auto imgBuf = pragma::image::ImageBuffer::Create(GetWidth(), GetHeight(), format);
 
+	auto dstFormat = util::get_vk_format(format);
+	if(util::is_pixel_conversion_supported(GetFormat(), dstFormat)) {
+		// Read the image back in its own format and convert it on the CPU, which avoids the intermediate image and blit
+		util::BufferCreateInfo bufCreateInfo {};
+		bufCreateInfo.size = static_cast<DeviceSize>(GetWidth()) * GetHeight() * util::get_byte_size(GetFormat());
+		bufCreateInfo.memoryFeatures = MemoryFeatureFlags::GPUToCPU;
+		bufCreateInfo.usageFlags = BufferUsageFlags::TransferDstBit;
+		auto tmpBuf = context.CreateBuffer(bufCreateInfo);
+		if(!tmpBuf)
+			return nullptr;
+		record_copy_to_host_buffer(*cmd, const_cast<IImage &>(*this), curImgLayout, *tmpBuf);
+		cmd->RecordBufferBarrier(*tmpBuf, PipelineStageFlags::TransferBit, PipelineStageFlags::HostBit, AccessFlags::TransferWriteBit, AccessFlags::HostReadBit);
+		context.FlushSetupCommandBuffer();
+		if(!convert_host_buffer(*tmpBuf, GetFormat(), *imgBuf, dstFormat))
+			return nullptr;
+		return imgBuf;
+	}
+
 	auto imgCreateInfo = util::get_image_create_info(*imgBuf);
 	imgCreateInfo.usage = ImageUsageFlags::ColorAttachmentBit | ImageUsageFlags::TransferSrcBit;
 	imgCreateInfo.postCreateLayout = ImageLayout::TransferDstOptimal;
@@ -166,6 +295,66 @@ std::shared_ptr<pragma::image::ImageBuffer> IImage::ToHostImageBuffer(pragma::im
 	return imgBuf;
 }
 
+void IImage::ToHostImageBufferAsync(pragma::image::Format format, ImageLayout curImgLayout, const std::function<void(std::shared_ptr<pragma::image::ImageBuffer>)> &callback) const
+{
+	auto &context = GetContext();
+	auto *readback = context.GetImageReadback();
+	if(!readback || !pragma::math::is_flag_set(m_createInfo.usage, ImageUsageFlags::TransferSrcBit)) {
+		callback(nullptr);
+		return;
+	}
+	auto imgBuf = pragma::image::ImageBuffer::Create(GetWidth(), GetHeight(), format);
+	auto img = std::const_pointer_cast<IImage>(shared_from_this());
+	auto srcFormat = GetFormat();
+	auto dstFormat = util::get_vk_format(format);
+	if(util::is_pixel_conversion_supported(srcFormat, dstFormat)) {
+		// See ToHostImageBuffer
+		ImageReadback::Request request {};
+		request.size = static_cast<DeviceSize>(GetWidth()) * GetHeight() * util::get_byte_size(srcFormat);
+		request.record = [img, curImgLayout](ICommandBuffer &cmd, IBuffer &buf) -> bool { return record_copy_to_host_buffer(cmd, *img, curImgLayout, buf); };
+		request.onComplete = [img, imgBuf, srcFormat, dstFormat, callback](IBuffer *buf) { callback((buf && convert_host_buffer(*buf, srcFormat, *imgBuf, dstFormat)) ? imgBuf : nullptr); };
+		readback->Enqueue(std::move(request));
+		return;
+	}
+	// The intermediate image is created when the readback is recorded and has to stay alive until it has completed
+	auto tmpImg = std::make_shared<std::shared_ptr<IImage>>();
+	ImageReadback::Request request {};
+	request.size = imgBuf->GetSize();
+	request.record = [img, imgBuf, tmpImg, curImgLayout](ICommandBuffer &cmd, IBuffer &buf) -> bool {
+		auto imgCreateInfo = util::get_image_create_info(*imgBuf);
+		imgCreateInfo.usage = ImageUsageFlags::ColorAttachmentBit | ImageUsageFlags::TransferSrcBit;
+		imgCreateInfo.postCreateLayout = ImageLayout::TransferDstOptimal;
+		*tmpImg = img->GetContext().CreateImage(imgCreateInfo);
+		if(!*tmpImg)
+			return false;
+		cmd.RecordImageBarrier(*img, curImgLayout, ImageLayout::TransferSrcOptimal);
+		cmd.RecordBlitImage({}, *img, **tmpImg);
+		cmd.RecordImageBarrier(*img, ImageLayout::TransferSrcOptimal, curImgLayout);
+
+		cmd.RecordImageBarrier(**tmpImg, ImageLayout::TransferDstOptimal, ImageLayout::TransferSrcOptimal);
+		util::BufferImageCopyInfo bufImgCopyInfo {};
+		bufImgCopyInfo.layerCount = 1;
+		bufImgCopyInfo.mipLevel = 0;
+		return cmd.RecordCopyImageToBuffer(bufImgCopyInfo, **tmpImg, ImageLayout::TransferSrcOptimal, buf);
+	};
+	request.onComplete = [imgBuf, tmpImg, callback](IBuffer *buf) {
+		if(!buf || !buf->Read(0, imgBuf->GetSize(), imgBuf->GetData())) {
+			callback(nullptr);
+			return;
+		}
+		callback(imgBuf);
+	};
+	readback->Enqueue(std::move(request));
+}
+
+std::future<std::shared_ptr<pragma::image::ImageBuffer>> IImage::ToHostImageBufferAsync(pragma::image::Format format, ImageLayout curImgLayout) const
+{
+	auto promise = std::make_shared<std::promise<std::shared_ptr<pragma::image::ImageBuffer>>>();
+	auto future = promise->get_future();
+	ToHostImageBufferAsync(format, curImgLayout, [promise](std::shared_ptr<pragma::image::ImageBuffer> imgBuf) { promise->set_value(std::move(imgBuf)); });
+	return future;
+}
+
 bool IImage::Copy(ICommandBuffer &cmd, IImage &imgDst)
 {
 	util::BlitInfo blitInfo {};
@@ -191,53 +380,62 @@ std::shared_ptr<IImage> IImage::Copy(ICommandBuffer &cmd, const util::ImageCreat
 
 	if(util::is_compressed_format(createInfo.format) && (!util::is_compressed_format(GetFormat()) || createInfo.format != GetFormat())) {
 		// We can't blit into a compressed image, so we'll have to compress the image data ourselves.
-		// This is going to be *very* slow.
 
 		using ImageMipmapData = std::vector<uint8_t>;
 		using ImageLayerData = std::vector<ImageMipmapData>;
 		using ImageData = std::vector<ImageLayerData>;
 
-		auto texInputFormat = get_texture_info_input_format(GetFormat());
-		auto texOutputFormat = get_texture_info_output_format(copyCreateInfo.format);
-		if(!texInputFormat.has_value() || !texOutputFormat.has_value())
-			return nullptr;
-		pragma::image::TextureInfo texInfo {};
-		if(IsSrgb())
-			texInfo.flags |= pragma::image::TextureInfo::Flags::SRGB;
-		if(IsNormalMap())
-			texInfo.SetNormalMap();
-		auto numSrcMipmaps = GetMipmapCount();
+		ImageData compressedData;
 		auto numDstMipmaps = pragma::math::is_flag_set(copyCreateInfo.flags, util::ImageCreateInfo::Flags::FullMipmapChain) ? util::calculate_mipmap_count(copyCreateInfo.width, copyCreateInfo.height) : 1;
-		auto generateMipmaps = (numSrcMipmaps == 1 && numDstMipmaps > 1);
-		texInfo.inputFormat = *texInputFormat;
-		texInfo.outputFormat = *texOutputFormat;
-		if(generateMipmaps)
-			texInfo.flags |= pragma::image::TextureInfo::Flags::GenerateMipmaps;
+		auto extents = GetExtents();
+		// Normal maps are left to the image library for BC1 and BC3, since it applies normal map specific encoding
+		auto useNativeCompression = util::is_block_compression_supported(createInfo.format) && (!IsNormalMap() || createInfo.format == Format::BC5_UNorm_Block) && extents.width == createInfo.width && extents.height == createInfo.height;
+		if(useNativeCompression) {
+			if(!compress_image_blocks(*this, createInfo.format, numDstMipmaps, compressionInfo, compressedData))
+				return nullptr;
+		}
+		else {
+			// This is going to be *very* slow.
+			auto texInputFormat = get_texture_info_input_format(GetFormat());
+			auto texOutputFormat = get_texture_info_output_format(copyCreateInfo.format);
+			if(!texInputFormat.has_value() || !texOutputFormat.has_value())
+				return nullptr;
+			pragma::image::TextureInfo texInfo {};
+			if(IsSrgb())
+				texInfo.flags |= pragma::image::TextureInfo::Flags::SRGB;
+			if(IsNormalMap())
+				texInfo.SetNormalMap();
+			auto numSrcMipmaps = GetMipmapCount();
+			auto generateMipmaps = (numSrcMipmaps == 1 && numDstMipmaps > 1);
+			texInfo.inputFormat = *texInputFormat;
+			texInfo.outputFormat = *texOutputFormat;
+			if(generateMipmaps)
+				texInfo.flags |= pragma::image::TextureInfo::Flags::GenerateMipmaps;
 
-		ImageData compressedData;
-		auto numLayers = GetLayerCount();
-		compressedData.resize(numLayers, ImageLayerData(numDstMipmaps));
-		auto iLevel = std::numeric_limits<uint32_t>::max();
-		auto iMipmap = std::numeric_limits<uint32_t>::max();
-		pragma::image::TextureOutputHandler outputHandler {};
-		outputHandler.beginImage = [&compressedData, &iLevel, &iMipmap](int size, int width, int height, int depth, int face, int miplevel) {
-			iLevel = face;
-			iMipmap = miplevel;
-			compressedData[face][miplevel].resize(size);
-		};
-		outputHandler.writeData = [&compressedData, &iLevel, &iMipmap](const void *data, int size) -> bool {
-			if(iLevel == std::numeric_limits<uint32_t>::max() || iMipmap == std::numeric_limits<uint32_t>::max())
+			auto numLayers = GetLayerCount();
+			compressedData.resize(numLayers, ImageLayerData(numDstMipmaps));
+			auto iLevel = std::numeric_limits<uint32_t>::max();
+			auto iMipmap = std::numeric_limits<uint32_t>::max();
+			pragma::image::TextureOutputHandler outputHandler {};
+			outputHandler.beginImage = [&compressedData, &iLevel, &iMipmap](int size, int width, int height, int depth, int face, int miplevel) {
+				iLevel = face;
+				iMipmap = miplevel;
+				compressedData[face][miplevel].resize(size);
+			};
+			outputHandler.writeData = [&compressedData, &iLevel, &iMipmap](const void *data, int size) -> bool {
+				if(iLevel == std::numeric_limits<uint32_t>::max() || iMipmap == std::numeric_limits<uint32_t>::max())
+					return true;
+				memcpy(compressedData[iLevel][iMipmap].data(), data, size);
 				return true;
-			memcpy(compressedData[iLevel][iMipmap].data(), data, size);
-			return true;
-		};
-		outputHandler.endImage = [&iLevel, &iMipmap]() {
-			iLevel = std::numeric_limits<uint32_t>::max();
-			iMipmap = std::numeric_limits<uint32_t>::max();
-		};
-		auto result = util::compress_image(*this, texInfo, outputHandler);
-		if(result == false)
-			return nullptr;
+			};
+			outputHandler.endImage = [&iLevel, &iMipmap]() {
+				iLevel = std::numeric_limits<uint32_t>::max();
+				iMipmap = std::numeric_limits<uint32_t>::max();
+			};
+			auto result = util::compress_image(*this, texInfo, outputHandler);
+			if(result == false)
+				return nullptr;
+		}
 		return GetContext().CreateImage(createInfo, [&compressedData, &createInfo](uint32_t layerId, uint32_t mipmapId, uint32_t &dataSize, uint32_t &rowSize) -> const uint8_t * {
 			auto &mipData = compressedData[layerId][mipmapId];
 			dataSize = mipData.size();
@@ -0,0 +1,738 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PR_PROSPER_PIXEL_CONVERSION_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PR_PROSPER_PIXEL_CONVERSION_NEON
+#include <arm_neon.h>
+#endif
+
+// MSVC allows intrinsics of any instruction set without target flags, gcc and clang need them per function
+#if defined(_MSC_VER) && !defined(__clang__)
+#define PR_PROSPER_TARGET(isa)
+#else
+#define PR_PROSPER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+module pragma.prosper;
+
+import :pixel_conversion;
+
+using namespace prosper;
+
+namespace {
+	enum class ComponentType : uint8_t { UNorm8 = 0, Float16, Float32 };
+	struct PixelLayout {
+		ComponentType type;
+		uint8_t numChannels;
+		bool bgr;  // Red and blue are swapped in memory
+		bool srgb; // Color channels are sRGB-encoded
+		uint32_t GetPixelSize() const
+		{
+			switch(type) {
+			case ComponentType::UNorm8:
+				return numChannels;
+			case ComponentType::Float16:
+				return numChannels * 2;
+			default:
+				return numChannels * 4;
+			}
+		}
+	};
+	std::optional<PixelLayout> get_pixel_layout(Format format)
+	{
+		switch(format) {
+		case Format::R8_UNorm:
+			return PixelLayout {ComponentType::UNorm8, 1, false, false};
+		case Format::R8_SRGB:
+			return PixelLayout {ComponentType::UNorm8, 1, false, true};
+		case Format::R8G8_UNorm:
+			return PixelLayout {ComponentType::UNorm8, 2, false, false};
+		case Format::R8G8_SRGB_PoorCoverage:
+			return PixelLayout {ComponentType::UNorm8, 2, false, true};
+		case Format::R8G8B8_UNorm_PoorCoverage:
+			return PixelLayout {ComponentType::UNorm8, 3, false, false};
+		case Format::R8G8B8_SRGB_PoorCoverage:
+			return PixelLayout {ComponentType::UNorm8, 3, false, true};
+		case Format::B8G8R8_UNorm_PoorCoverage:
+			return PixelLayout {ComponentType::UNorm8, 3, true, false};
+		case Format::B8G8R8_SRGB_PoorCoverage:
+			return PixelLayout {ComponentType::UNorm8, 3, true, true};
+		case Format::R8G8B8A8_UNorm:
+			return PixelLayout {ComponentType::UNorm8, 4, false, false};
+		case Format::R8G8B8A8_SRGB:
+			return PixelLayout {ComponentType::UNorm8, 4, false, true};
+		case Format::B8G8R8A8_UNorm:
+			return PixelLayout {ComponentType::UNorm8, 4, true, false};
+		case Format::B8G8R8A8_SRGB:
+			return PixelLayout {ComponentType::UNorm8, 4, true, true};
+		case Format::R16_SFloat:
+			return PixelLayout {ComponentType::Float16, 1, false, false};
+		case Format::R16G16_SFloat:
+			return PixelLayout {ComponentType::Float16, 2, false, false};
+		case Format::R16G16B16_SFloat_PoorCoverage:
+			return PixelLayout {ComponentType::Float16, 3, false, false};
+		case Format::R16G16B16A16_SFloat:
+			return PixelLayout {ComponentType::Float16, 4, false, false};
+		case Format::R32_SFloat:
+			return PixelLayout {ComponentType::Float32, 1, false, false};
+		case Format::R32G32_SFloat:
+			return PixelLayout {ComponentType::Float32, 2, false, false};
+		case Format::R32G32B32_SFloat:
+			return PixelLayout {ComponentType::Float32, 3, false, false};
+		case Format::R32G32B32A32_SFloat:
+			return PixelLayout {ComponentType::Float32, 4, false, false};
+		default:
+			break;
+		}
+		return {};
+	}
+
+	///////////// Scalar reference path /////////////
+	// All SIMD kernels have to produce exactly the same results as these functions (assuming the default rounding mode).
+
+	float decode_unorm8(uint8_t v) { return static_cast<float>(v) / 255.f; }
+	uint8_t encode_unorm8(float v)
+	{
+		// Same operand order as minps/maxps, so NaN is mapped to 1
+		v = (v < 1.f) ? v : 1.f;
+		v = (v > 0.f) ? v : 0.f;
+		return static_cast<uint8_t>(std::nearbyint(v * 255.f));
+	}
+	const std::array<float, 256> &get_srgb_decode_table()
+	{
+		static auto table = [] {
+			std::array<float, 256> table;
+			for(auto i = 0u; i < table.size(); ++i) {
+				auto c = i / 255.0;
+				table[i] = static_cast<float>((c <= 0.04045) ? (c / 12.92) : std::pow((c + 0.055) / 1.055, 2.4));
+			}
+			return table;
+		}();
+		return table;
+	}
+	float linear_to_srgb(float v) { return (v <= 0.0031308f) ? (v * 12.92f) : (1.055f * std::pow(v, 1.f / 2.4f) - 0.055f); }
+
+	// Round-to-nearest-even, same as F16C and the NEON conversion instructions
+	uint16_t float_to_half(float f)
+	{
+		auto bits = std::bit_cast<uint32_t>(f);
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t exp = (bits >> 23) & 0xFF;
+		uint32_t mant = bits & 0x7FFFFF;
+		if(exp == 0xFF)
+			return sign | 0x7C00 | (mant ? (0x200 | (mant >> 13)) : 0); // Inf or quiet NaN
+		auto e = static_cast<int32_t>(exp) - 127 + 15;
+		if(e >= 31)
+			return sign | 0x7C00;
+		if(e <= 0) {
+			// Denormal half
+			if(e < -10)
+				return sign;
+			mant |= 0x800000;
+			auto shift = static_cast<uint32_t>(14 - e);
+			auto half = mant >> shift;
+			auto rem = mant & ((1u << shift) - 1);
+			auto halfway = 1u << (shift - 1);
+			if(rem > halfway || (rem == halfway && (half & 1)))
+				++half;
+			return sign | half;
+		}
+		auto half = (static_cast<uint32_t>(e) << 10) | (mant >> 13);
+		auto rem = mant & 0x1FFF;
+		if(rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+			++half; // May carry into the exponent, which is the correct result
+		return static_cast<uint16_t>(sign | half);
+	}
+	float half_to_float(uint16_t h)
+	{
+		uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+		uint32_t exp = (h >> 10) & 0x1F;
+		uint32_t mant = h & 0x3FF;
+		uint32_t bits;
+		if(exp == 0) {
+			if(mant == 0)
+				bits = sign;
+			else {
+				uint32_t e = 0;
+				while(!(mant & 0x400)) {
+					mant <<= 1;
+					++e;
+				}
+				bits = sign | ((113 - e) << 23) | ((mant & 0x3FF) << 13);
+			}
+		}
+		else if(exp == 31)
+			bits = sign | 0x7F800000 | (mant << 13) | (mant ? 0x400000 : 0); // NaNs are quieted
+		else
+			bits = sign | ((exp + 112) << 23) | (mant << 13);
+		return std::bit_cast<float>(bits);
+	}
+
+	constexpr std::array<uint8_t, 4> RGBA_ORDER {0, 1, 2, 3};
+	constexpr std::array<uint8_t, 4> BGRA_ORDER {2, 1, 0, 3};
+	void convert_pixels_scalar(const uint8_t *src, const PixelLayout &srcLayout, uint8_t *dst, const PixelLayout &dstLayout, size_t numPixels)
+	{
+		auto &srcOrder = srcLayout.bgr ? BGRA_ORDER : RGBA_ORDER;
+		auto &dstOrder = dstLayout.bgr ? BGRA_ORDER : RGBA_ORDER;
+		auto srcPixelSize = srcLayout.GetPixelSize();
+		auto dstPixelSize = dstLayout.GetPixelSize();
+		if(srcLayout.type == ComponentType::UNorm8 && dstLayout.type == ComponentType::UNorm8 && srcLayout.srgb == dstLayout.srgb) {
+			// Only the channels are moved around
+			for(auto i = decltype(numPixels) {0u}; i < numPixels; ++i) {
+				std::array<uint8_t, 4> rgba {0, 0, 0, 255};
+				for(auto c = 0u; c < srcLayout.numChannels; ++c)
+					rgba[srcOrder[c]] = src[c];
+				for(auto c = 0u; c < dstLayout.numChannels; ++c)
+					dst[c] = rgba[dstOrder[c]];
+				src += srcPixelSize;
+				dst += dstPixelSize;
+			}
+			return;
+		}
+		auto &srgbDecodeTable = get_srgb_decode_table();
+		for(auto i = decltype(numPixels) {0u}; i < numPixels; ++i) {
+			std::array<float, 4> rgba {0.f, 0.f, 0.f, 1.f};
+			for(auto c = 0u; c < srcLayout.numChannels; ++c) {
+				auto channel = srcOrder[c];
+				switch(srcLayout.type) {
+				case ComponentType::UNorm8:
+					rgba[channel] = (srcLayout.srgb && channel < 3) ? srgbDecodeTable[src[c]] : decode_unorm8(src[c]);
+					break;
+				case ComponentType::Float16:
+					{
+						uint16_t h;
+						std::memcpy(&h, src + c * sizeof(h), sizeof(h));
+						rgba[channel] = half_to_float(h);
+						break;
+					}
+				case ComponentType::Float32:
+					std::memcpy(&rgba[channel], src + c * sizeof(float), sizeof(float));
+					break;
+				}
+			}
+			for(auto c = 0u; c < dstLayout.numChannels; ++c) {
+				auto channel = dstOrder[c];
+				auto v = rgba[channel];
+				switch(dstLayout.type) {
+				case ComponentType::UNorm8:
+					dst[c] = encode_unorm8((dstLayout.srgb && channel < 3) ? linear_to_srgb(v) : v);
+					break;
+				case ComponentType::Float16:
+					{
+						auto h = float_to_half(v);
+						std::memcpy(dst + c * sizeof(h), &h, sizeof(h));
+						break;
+					}
+				case ComponentType::Float32:
+					std::memcpy(dst + c * sizeof(float), &v, sizeof(float));
+					break;
+				}
+			}
+			src += srcPixelSize;
+			dst += dstPixelSize;
+		}
+	}
+
+	///////////// SIMD kernels /////////////
+	// Kernels process as many pixels as they can in full vectors and return the number of processed pixels, the rest is left to the scalar path.
+	// 8-bit sides of the float kernels are always linear (UNorm), sRGB conversions only exist in the scalar path.
+	using Kernel = size_t (*)(const uint8_t *, uint8_t *, size_t);
+	struct Kernels {
+		Kernel swapRb = nullptr;            // RGBA8 <-> BGRA8
+		Kernel u8x4ToU8x3[2] {};            // Index: Swap red and blue
+		Kernel u8x3ToU8x4[2] {};            // Index: Swap red and blue
+		Kernel unorm8x4ToF32x4[2] {};       // Index: Source is BGRA
+		Kernel f32x4ToUnorm8x4[2] {};       // Index: Destination is BGRA
+		Kernel unorm8x4ToF16x4[2] {};       // Index: Source is BGRA
+		Kernel f16x4ToUnorm8x4[2] {};       // Index: Destination is BGRA
+		Kernel f16x4ToF32x4 = nullptr;
+		Kernel f32x4ToF16x4 = nullptr;
+	};
+
+#ifdef PR_PROSPER_PIXEL_CONVERSION_X86
+	struct CpuFeatures {
+		bool sse41 = false;
+		bool avx2 = false; // Includes F16C and OS support for the AVX state
+	};
+	CpuFeatures detect_cpu_features()
+	{
+		auto cpuid = [](uint32_t leaf, uint32_t subLeaf, std::array<uint32_t, 4> &outRegs) {
+#ifdef _MSC_VER
+			int regs[4];
+			__cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subLeaf));
+			for(auto i = 0u; i < 4; ++i)
+				outRegs[i] = static_cast<uint32_t>(regs[i]);
+#else
+			__cpuid_count(leaf, subLeaf, outRegs[0], outRegs[1], outRegs[2], outRegs[3]);
+#endif
+		};
+		CpuFeatures features {};
+		std::array<uint32_t, 4> regs {};
+		cpuid(0, 0, regs);
+		auto maxLeaf = regs[0];
+		if(maxLeaf < 1)
+			return features;
+		cpuid(1, 0, regs);
+		auto ssse3 = (regs[2] & (1u << 9)) != 0;
+		features.sse41 = ssse3 && (regs[2] & (1u << 19)) != 0;
+		auto osxsave = (regs[2] & (1u << 27)) != 0;
+		auto avx = (regs[2] & (1u << 28)) != 0;
+		auto f16c = (regs[2] & (1u << 29)) != 0;
+		if(!features.sse41 || !osxsave || !avx || !f16c || maxLeaf < 7)
+			return features;
+#ifdef _MSC_VER
+		auto xcr0 = _xgetbv(0);
+#else
+		uint32_t xcr0Lo, xcr0Hi;
+		__asm__ volatile("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+		uint64_t xcr0 = (static_cast<uint64_t>(xcr0Hi) << 32) | xcr0Lo;
+#endif
+		if((xcr0 & 0x6) != 0x6)
+			return features; // The OS doesn't save the YMM registers
+		cpuid(7, 0, regs);
+		features.avx2 = (regs[1] & (1u << 5)) != 0;
+		return features;
+	}
+
+	PR_PROSPER_TARGET("sse4.1") inline __m128i swap_rb_mask_sse41() { return _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15); }
+	PR_PROSPER_TARGET("sse4.1") inline __m128i quantize_unorm8_sse41(__m128 v)
+	{
+		v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(1.f)), _mm_setzero_ps());
+		return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.f)));
+	}
+
+	PR_PROSPER_TARGET("sse4.1") size_t swap_rb_sse41(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto mask = swap_rb_mask_sse41();
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)), mask));
+		return i;
+	}
+	template<bool SWAP>
+	PR_PROSPER_TARGET("sse4.1")
+	size_t u8x4_to_u8x3_sse41(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto mask = SWAP ? _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1) : _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)), mask);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i * 3), v);
+			auto last = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+			std::memcpy(dst + i * 3 + 8, &last, sizeof(last));
+		}
+		return i;
+	}
+	template<bool SWAP>
+	PR_PROSPER_TARGET("sse4.1")
+	size_t u8x3_to_u8x4_sse41(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto mask = SWAP ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		auto alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+		size_t i = 0;
+		// Each load reads 16 bytes, but only 12 are used
+		for(; i + 6 <= numPixels; i += 4) {
+			auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3)), mask);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(v, alpha));
+		}
+		return i;
+	}
+	template<bool BGRA>
+	PR_PROSPER_TARGET("sse4.1")
+	size_t unorm8x4_to_f32x4_sse41(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto scale = _mm_set1_ps(255.f);
+		auto *fdst = reinterpret_cast<float *>(dst);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+			if constexpr(BGRA)
+				v = _mm_shuffle_epi8(v, swap_rb_mask_sse41());
+			_mm_storeu_ps(fdst + i * 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)), scale));
+			_mm_storeu_ps(fdst + i * 4 + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4))), scale));
+			_mm_storeu_ps(fdst + i * 4 + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 8))), scale));
+			_mm_storeu_ps(fdst + i * 4 + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 12))), scale));
+		}
+		return i;
+	}
+	template<bool BGRA>
+	PR_PROSPER_TARGET("sse4.1")
+	size_t f32x4_to_unorm8x4_sse41(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fsrc = reinterpret_cast<const float *>(src);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			auto q0 = quantize_unorm8_sse41(_mm_loadu_ps(fsrc + i * 4));
+			auto q1 = quantize_unorm8_sse41(_mm_loadu_ps(fsrc + i * 4 + 4));
+			auto q2 = quantize_unorm8_sse41(_mm_loadu_ps(fsrc + i * 4 + 8));
+			auto q3 = quantize_unorm8_sse41(_mm_loadu_ps(fsrc + i * 4 + 12));
+			auto v = _mm_packus_epi16(_mm_packs_epi32(q0, q1), _mm_packs_epi32(q2, q3));
+			if constexpr(BGRA)
+				v = _mm_shuffle_epi8(v, swap_rb_mask_sse41());
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), v);
+		}
+		return i;
+	}
+
+	PR_PROSPER_TARGET("avx2,f16c") size_t swap_rb_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		size_t i = 0;
+		for(; i + 8 <= numPixels; i += 8)
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4)), mask));
+		return i;
+	}
+	// Two RGBA8 pixels to eight floats in [0,1]
+	template<bool BGRA>
+	PR_PROSPER_TARGET("avx2,f16c")
+	inline __m256 load_unorm8x4x2_avx2(const uint8_t *src)
+	{
+		auto v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+		if constexpr(BGRA)
+			v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+		return _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)), _mm256_set1_ps(255.f));
+	}
+	// Eight floats to two RGBA8 pixels
+	template<bool BGRA>
+	PR_PROSPER_TARGET("avx2,f16c")
+	inline void store_unorm8x4x2_avx2(__m256 v, uint8_t *dst)
+	{
+		v = _mm256_max_ps(_mm256_min_ps(v, _mm256_set1_ps(1.f)), _mm256_setzero_ps());
+		auto q = _mm256_cvtps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(255.f)));
+		auto q16 = _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+		auto q8 = _mm_packus_epi16(q16, q16);
+		if constexpr(BGRA)
+			q8 = _mm_shuffle_epi8(q8, _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), q8);
+	}
+	template<bool BGRA>
+	PR_PROSPER_TARGET("avx2,f16c")
+	size_t unorm8x4_to_f32x4_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fdst = reinterpret_cast<float *>(dst);
+		size_t i = 0;
+		for(; i + 2 <= numPixels; i += 2)
+			_mm256_storeu_ps(fdst + i * 4, load_unorm8x4x2_avx2<BGRA>(src + i * 4));
+		return i;
+	}
+	template<bool BGRA>
+	PR_PROSPER_TARGET("avx2,f16c")
+	size_t f32x4_to_unorm8x4_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fsrc = reinterpret_cast<const float *>(src);
+		size_t i = 0;
+		for(; i + 2 <= numPixels; i += 2)
+			store_unorm8x4x2_avx2<BGRA>(_mm256_loadu_ps(fsrc + i * 4), dst + i * 4);
+		return i;
+	}
+	template<bool BGRA>
+	PR_PROSPER_TARGET("avx2,f16c")
+	size_t unorm8x4_to_f16x4_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		size_t i = 0;
+		for(; i + 2 <= numPixels; i += 2)
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 8), _mm256_cvtps_ph(load_unorm8x4x2_avx2<BGRA>(src + i * 4), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+		return i;
+	}
+	template<bool BGRA>
+	PR_PROSPER_TARGET("avx2,f16c")
+	size_t f16x4_to_unorm8x4_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		size_t i = 0;
+		for(; i + 2 <= numPixels; i += 2)
+			store_unorm8x4x2_avx2<BGRA>(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 8))), dst + i * 4);
+		return i;
+	}
+	PR_PROSPER_TARGET("avx2,f16c") size_t f16x4_to_f32x4_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fdst = reinterpret_cast<float *>(dst);
+		size_t i = 0;
+		for(; i + 2 <= numPixels; i += 2)
+			_mm256_storeu_ps(fdst + i * 4, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 8))));
+		return i;
+	}
+	PR_PROSPER_TARGET("avx2,f16c") size_t f32x4_to_f16x4_avx2(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fsrc = reinterpret_cast<const float *>(src);
+		size_t i = 0;
+		for(; i + 2 <= numPixels; i += 2)
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 8), _mm256_cvtps_ph(_mm256_loadu_ps(fsrc + i * 4), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+		return i;
+	}
+
+	const Kernels SSE41_KERNELS {
+	  swap_rb_sse41,
+	  {u8x4_to_u8x3_sse41<false>, u8x4_to_u8x3_sse41<true>},
+	  {u8x3_to_u8x4_sse41<false>, u8x3_to_u8x4_sse41<true>},
+	  {unorm8x4_to_f32x4_sse41<false>, unorm8x4_to_f32x4_sse41<true>},
+	  {f32x4_to_unorm8x4_sse41<false>, f32x4_to_unorm8x4_sse41<true>},
+	};
+	// Kernels that don't benefit from wider registers are shared with SSE4.1
+	const Kernels AVX2_KERNELS {
+	  swap_rb_avx2,
+	  {u8x4_to_u8x3_sse41<false>, u8x4_to_u8x3_sse41<true>},
+	  {u8x3_to_u8x4_sse41<false>, u8x3_to_u8x4_sse41<true>},
+	  {unorm8x4_to_f32x4_avx2<false>, unorm8x4_to_f32x4_avx2<true>},
+	  {f32x4_to_unorm8x4_avx2<false>, f32x4_to_unorm8x4_avx2<true>},
+	  {unorm8x4_to_f16x4_avx2<false>, unorm8x4_to_f16x4_avx2<true>},
+	  {f16x4_to_unorm8x4_avx2<false>, f16x4_to_unorm8x4_avx2<true>},
+	  f16x4_to_f32x4_avx2,
+	  f32x4_to_f16x4_avx2,
+	};
+#endif
+
+#ifdef PR_PROSPER_PIXEL_CONVERSION_NEON
+	// Four pixels to sixteen floats in [0,1]
+	inline float32x4x4_t load_unorm8x4x4_neon(const uint8_t *src, bool bgra)
+	{
+		auto v = vld1q_u8(src);
+		if(bgra) {
+			static const uint8_t swapMask[16] = {2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15};
+			v = vqtbl1q_u8(v, vld1q_u8(swapMask));
+		}
+		auto lo = vmovl_u8(vget_low_u8(v));
+		auto hi = vmovl_u8(vget_high_u8(v));
+		auto scale = vdupq_n_f32(255.f);
+		float32x4x4_t result;
+		result.val[0] = vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), scale);
+		result.val[1] = vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), scale);
+		result.val[2] = vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), scale);
+		result.val[3] = vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), scale);
+		return result;
+	}
+	inline uint32x4_t quantize_unorm8_neon(float32x4_t v)
+	{
+		// vminnm/vmaxnm return the number if one operand is NaN, which matches the scalar path
+		v = vmaxnmq_f32(vminnmq_f32(v, vdupq_n_f32(1.f)), vdupq_n_f32(0.f));
+		return vcvtnq_u32_f32(vmulq_f32(v, vdupq_n_f32(255.f)));
+	}
+	inline void store_unorm8x4x4_neon(const float32x4x4_t &v, uint8_t *dst, bool bgra)
+	{
+		auto lo = vcombine_u16(vmovn_u32(quantize_unorm8_neon(v.val[0])), vmovn_u32(quantize_unorm8_neon(v.val[1])));
+		auto hi = vcombine_u16(vmovn_u32(quantize_unorm8_neon(v.val[2])), vmovn_u32(quantize_unorm8_neon(v.val[3])));
+		auto result = vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+		if(bgra) {
+			static const uint8_t swapMask[16] = {2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15};
+			result = vqtbl1q_u8(result, vld1q_u8(swapMask));
+		}
+		vst1q_u8(dst, result);
+	}
+
+	size_t swap_rb_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		size_t i = 0;
+		for(; i + 16 <= numPixels; i += 16) {
+			auto v = vld4q_u8(src + i * 4);
+			std::swap(v.val[0], v.val[2]);
+			vst4q_u8(dst + i * 4, v);
+		}
+		return i;
+	}
+	template<bool SWAP>
+	size_t u8x4_to_u8x3_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		size_t i = 0;
+		for(; i + 16 <= numPixels; i += 16) {
+			auto v = vld4q_u8(src + i * 4);
+			uint8x16x3_t result {{SWAP ? v.val[2] : v.val[0], v.val[1], SWAP ? v.val[0] : v.val[2]}};
+			vst3q_u8(dst + i * 3, result);
+		}
+		return i;
+	}
+	template<bool SWAP>
+	size_t u8x3_to_u8x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		size_t i = 0;
+		for(; i + 16 <= numPixels; i += 16) {
+			auto v = vld3q_u8(src + i * 3);
+			uint8x16x4_t result {{SWAP ? v.val[2] : v.val[0], v.val[1], SWAP ? v.val[0] : v.val[2], vdupq_n_u8(255)}};
+			vst4q_u8(dst + i * 4, result);
+		}
+		return i;
+	}
+	template<bool BGRA>
+	size_t unorm8x4_to_f32x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fdst = reinterpret_cast<float *>(dst);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			auto v = load_unorm8x4x4_neon(src + i * 4, BGRA);
+			for(auto j = 0u; j < 4; ++j)
+				vst1q_f32(fdst + (i + j) * 4, v.val[j]);
+		}
+		return i;
+	}
+	template<bool BGRA>
+	size_t f32x4_to_unorm8x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fsrc = reinterpret_cast<const float *>(src);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			float32x4x4_t v {{vld1q_f32(fsrc + i * 4), vld1q_f32(fsrc + i * 4 + 4), vld1q_f32(fsrc + i * 4 + 8), vld1q_f32(fsrc + i * 4 + 12)}};
+			store_unorm8x4x4_neon(v, dst + i * 4, BGRA);
+		}
+		return i;
+	}
+	template<bool BGRA>
+	size_t unorm8x4_to_f16x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *hdst = reinterpret_cast<uint16_t *>(dst);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			auto v = load_unorm8x4x4_neon(src + i * 4, BGRA);
+			for(auto j = 0u; j < 4; ++j)
+				vst1_u16(hdst + (i + j) * 4, vreinterpret_u16_f16(vcvt_f16_f32(v.val[j])));
+		}
+		return i;
+	}
+	template<bool BGRA>
+	size_t f16x4_to_unorm8x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *hsrc = reinterpret_cast<const uint16_t *>(src);
+		size_t i = 0;
+		for(; i + 4 <= numPixels; i += 4) {
+			float32x4x4_t v;
+			for(auto j = 0u; j < 4; ++j)
+				v.val[j] = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(hsrc + (i + j) * 4)));
+			store_unorm8x4x4_neon(v, dst + i * 4, BGRA);
+		}
+		return i;
+	}
+	size_t f16x4_to_f32x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *hsrc = reinterpret_cast<const uint16_t *>(src);
+		auto *fdst = reinterpret_cast<float *>(dst);
+		for(auto i = decltype(numPixels) {0u}; i < numPixels; ++i)
+			vst1q_f32(fdst + i * 4, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(hsrc + i * 4))));
+		return numPixels;
+	}
+	size_t f32x4_to_f16x4_neon(const uint8_t *src, uint8_t *dst, size_t numPixels)
+	{
+		auto *fsrc = reinterpret_cast<const float *>(src);
+		auto *hdst = reinterpret_cast<uint16_t *>(dst);
+		for(auto i = decltype(numPixels) {0u}; i < numPixels; ++i)
+			vst1_u16(hdst + i * 4, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(fsrc + i * 4))));
+		return numPixels;
+	}
+
+	const Kernels NEON_KERNELS {
+	  swap_rb_neon,
+	  {u8x4_to_u8x3_neon<false>, u8x4_to_u8x3_neon<true>},
+	  {u8x3_to_u8x4_neon<false>, u8x3_to_u8x4_neon<true>},
+	  {unorm8x4_to_f32x4_neon<false>, unorm8x4_to_f32x4_neon<true>},
+	  {f32x4_to_unorm8x4_neon<false>, f32x4_to_unorm8x4_neon<true>},
+	  {unorm8x4_to_f16x4_neon<false>, unorm8x4_to_f16x4_neon<true>},
+	  {f16x4_to_unorm8x4_neon<false>, f16x4_to_unorm8x4_neon<true>},
+	  f16x4_to_f32x4_neon,
+	  f32x4_to_f16x4_neon,
+	};
+#endif
+
+	const Kernels *get_kernels(util::PixelConversionIsa isa)
+	{
+		switch(isa) {
+#ifdef PR_PROSPER_PIXEL_CONVERSION_X86
+		case util::PixelConversionIsa::SSE41:
+			return &SSE41_KERNELS;
+		case util::PixelConversionIsa::AVX2:
+			return &AVX2_KERNELS;
+#endif
+#ifdef PR_PROSPER_PIXEL_CONVERSION_NEON
+		case util::PixelConversionIsa::NEON:
+			return &NEON_KERNELS;
+#endif
+		default:
+			break;
+		}
+		return nullptr;
+	}
+
+	Kernel find_kernel(const Kernels &kernels, const PixelLayout &src, const PixelLayout &dst)
+	{
+		auto isUnorm8 = [](const PixelLayout &layout, uint32_t numChannels) { return layout.type == ComponentType::UNorm8 && layout.numChannels == numChannels; };
+		auto isLinearUnorm8x4 = [&isUnorm8](const PixelLayout &layout) { return isUnorm8(layout, 4) && !layout.srgb; };
+		auto isFloat16x4 = [](const PixelLayout &layout) { return layout.type == ComponentType::Float16 && layout.numChannels == 4; };
+		auto isFloat32x4 = [](const PixelLayout &layout) { return layout.type == ComponentType::Float32 && layout.numChannels == 4; };
+		auto swap = (src.bgr != dst.bgr) ? 1 : 0;
+		if(src.type == ComponentType::UNorm8 && dst.type == ComponentType::UNorm8) {
+			if(src.srgb != dst.srgb)
+				return nullptr;
+			if(isUnorm8(src, 4) && isUnorm8(dst, 4))
+				return swap ? kernels.swapRb : nullptr;
+			if(isUnorm8(src, 4) && isUnorm8(dst, 3))
+				return kernels.u8x4ToU8x3[swap];
+			if(isUnorm8(src, 3) && isUnorm8(dst, 4))
+				return kernels.u8x3ToU8x4[swap];
+			return nullptr;
+		}
+		if(isLinearUnorm8x4(src) && isFloat32x4(dst))
+			return kernels.unorm8x4ToF32x4[src.bgr ? 1 : 0];
+		if(isFloat32x4(src) && isLinearUnorm8x4(dst))
+			return kernels.f32x4ToUnorm8x4[dst.bgr ? 1 : 0];
+		if(isLinearUnorm8x4(src) && isFloat16x4(dst))
+			return kernels.unorm8x4ToF16x4[src.bgr ? 1 : 0];
+		if(isFloat16x4(src) && isLinearUnorm8x4(dst))
+			return kernels.f16x4ToUnorm8x4[dst.bgr ? 1 : 0];
+		if(isFloat16x4(src) && isFloat32x4(dst))
+			return kernels.f16x4ToF32x4;
+		if(isFloat32x4(src) && isFloat16x4(dst))
+			return kernels.f32x4ToF16x4;
+		return nullptr;
+	}
+};
+
+util::PixelConversionIsa util::get_pixel_conversion_isa()
+{
+	static auto isa = []() {
+#ifdef PR_PROSPER_PIXEL_CONVERSION_X86
+		auto features = detect_cpu_features();
+		if(features.avx2)
+			return PixelConversionIsa::AVX2;
+		if(features.sse41)
+			return PixelConversionIsa::SSE41;
+		return PixelConversionIsa::Scalar;
+#elif defined(PR_PROSPER_PIXEL_CONVERSION_NEON)
+		return PixelConversionIsa::NEON; // Always available on aarch64
+#else
+		return PixelConversionIsa::Scalar;
+#endif
+	}();
+	return isa;
+}
+
+bool util::is_pixel_conversion_supported(Format srcFormat, Format dstFormat) { return get_pixel_layout(srcFormat).has_value() && get_pixel_layout(dstFormat).has_value(); }
+
+bool util::convert_pixels(const void *src, Format srcFormat, void *dst, Format dstFormat, size_t numPixels, std::optional<PixelConversionIsa> isa)
+{
+	auto srcLayout = get_pixel_layout(srcFormat);
+	auto dstLayout = get_pixel_layout(dstFormat);
+	if(!srcLayout.has_value() || !dstLayout.has_value())
+		return false;
+	auto *srcData = static_cast<const uint8_t *>(src);
+	auto *dstData = static_cast<uint8_t *>(dst);
+	if(srcFormat == dstFormat) {
+		std::memcpy(dstData, srcData, numPixels * srcLayout->GetPixelSize());
+		return true;
+	}
+	// The ISA values of different architectures can't be compared meaningfully, but get_kernels only knows the kernels of the current one
+	auto supportedIsa = get_pixel_conversion_isa();
+	auto useIsa = isa.has_value() ? static_cast<PixelConversionIsa>(pragma::math::min(pragma::math::to_integral(*isa), pragma::math::to_integral(supportedIsa))) : supportedIsa;
+	size_t numProcessed = 0;
+	if(auto *kernels = get_kernels(useIsa)) {
+		if(auto kernel = find_kernel(*kernels, *srcLayout, *dstLayout))
+			numProcessed = kernel(srcData, dstData, numPixels);
+	}
+	if(numProcessed < numPixels)
+		convert_pixels_scalar(srcData + numProcessed * srcLayout->GetPixelSize(), *srcLayout, dstData + numProcessed * dstLayout->GetPixelSize(), *dstLayout, numPixels - numProcessed);
+	return true;
+}
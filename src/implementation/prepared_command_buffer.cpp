@@ -65,11 +65,74 @@ util::PreparedCommandBufferRecordState::~PreparedCommandBufferRecordState() {}
 ////////////
 
 util::PreparedCommandBuffer::PreparedCommandBuffer() {}
-void util::PreparedCommandBuffer::PushCommand(PreparedCommandFunction &&cmd, std::vector<PreparedCommand::Argument> &&args) { commands.emplace_back(std::move(cmd), std::move(args)); }
+void util::PreparedCommandBuffer::PushCommand(PreparedCommandFunction &&cmd, std::vector<PreparedCommand::Argument> &&args)
+{
+	m_commands.emplace_back(std::move(cmd), std::move(args));
+	m_compiled = false;
+}
+void util::PreparedCommandBuffer::Compile()
+{
+	m_commandArgumentOffsets.clear();
+	m_compiledArguments.clear();
+	m_staticArgumentValues.clear();
+	m_dynamicArgumentSlots.clear();
+	m_commandArgumentOffsets.reserve(m_commands.size());
+	for(auto &cmd : m_commands) {
+		m_commandArgumentOffsets.push_back(static_cast<uint32_t>(m_compiledArguments.size()));
+		for(auto &arg : cmd.args) {
+			CompiledCommandArgument compiledArg {};
+			if(arg.type == PreparedCommand::Argument::Type::DynamicValue) {
+				auto nameHash = *static_cast<PreparedCommand::Argument::StringHash *>(arg.value);
+				auto it = std::find(m_dynamicArgumentSlots.begin(), m_dynamicArgumentSlots.end(), nameHash);
+				if(it == m_dynamicArgumentSlots.end())
+					it = m_dynamicArgumentSlots.insert(m_dynamicArgumentSlots.end(), nameHash);
+				compiledArg.source = CompiledCommandArgument::Source::Dynamic;
+				compiledArg.index = static_cast<uint32_t>(it - m_dynamicArgumentSlots.begin());
+			}
+			else {
+				// The static values are owned by the commands
+				compiledArg.source = CompiledCommandArgument::Source::Static;
+				compiledArg.index = static_cast<uint32_t>(m_staticArgumentValues.size());
+				m_staticArgumentValues.push_back((arg.type == PreparedCommand::Argument::Type::StaticValue) ? static_cast<const udm::Property *>(arg.value) : nullptr);
+			}
+			m_compiledArguments.push_back(compiledArg);
+		}
+	}
+	m_compiled = true;
+}
+bool util::PreparedCommandBuffer::RecordCompiledCommands(PreparedCommandBufferRecordState &recordState) const
+{
+	// Resolve every dynamic argument once, draw arguments take precedence over the dynamic arguments of the command buffer
+	constexpr size_t maxLocalSlots = 32;
+	std::array<const udm::Property *, maxLocalSlots> localValues;
+	std::vector<const udm::Property *> heapValues;
+	auto *values = localValues.data();
+	if(m_dynamicArgumentSlots.size() > maxLocalSlots) {
+		heapValues.resize(m_dynamicArgumentSlots.size());
+		values = heapValues.data();
+	}
+	for(auto i = decltype(m_dynamicArgumentSlots.size()) {0u}; i < m_dynamicArgumentSlots.size(); ++i) {
+		auto *prop = recordState.drawArguments.FindArgument(m_dynamicArgumentSlots[i]);
+		values[i] = prop ? prop : dynamicArguments.FindArgument(m_dynamicArgumentSlots[i]);
+	}
+	recordState.dynamicArgumentValues = values;
+
+	auto *compiledArgs = m_compiledArguments.data();
+	for(auto i = decltype(m_commands.size()) {0u}; i < m_commands.size(); ++i) {
+		auto &cmd = m_commands[i];
+		recordState.curCommand = &cmd;
+		recordState.curCompiledArguments = compiledArgs + m_commandArgumentOffsets[i];
+		if(!cmd.function(recordState))
+			return false;
+	}
+	return true;
+}
 bool util::PreparedCommandBuffer::RecordCommands(ICommandBuffer &cmdBuf, const PreparedCommandArgumentMap &drawArguments, const PreparedCommandBufferUserData &userData) const
 {
 	PreparedCommandBufferRecordState recordState {*this, cmdBuf, drawArguments, userData};
-	for(auto &cmd : commands) {
+	if(IsCompiled())
+		return RecordCompiledCommands(recordState);
+	for(auto &cmd : m_commands) {
 		recordState.curCommand = &cmd;
 		if(!cmd.function(recordState))
 			return false;
@@ -78,7 +141,12 @@ bool util::PreparedCommandBuffer::RecordCommands(ICommandBuffer &cmdBuf, const P
 }
 void util::PreparedCommandBuffer::Reset()
 {
-	commands.clear();
+	m_commands.clear();
 	dynamicArguments = {};
 	enableDrawArgs = true;
+	m_compiled = false;
+	m_commandArgumentOffsets.clear();
+	m_compiledArguments.clear();
+	m_staticArgumentValues.clear();
+	m_dynamicArgumentSlots.clear();
 }
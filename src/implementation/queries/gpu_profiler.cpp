@@ -0,0 +1,267 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+module pragma.prosper;
+
+import :query.gpu_profiler;
+
+using namespace prosper;
+
+GpuProfiler::GpuProfiler(IPrContext &context, uint32_t maxScopesPerFrame, uint32_t maxFrameHistory) : m_context {context}, m_maxFrameHistory {pragma::math::max<uint32_t>(maxFrameHistory, 1)}
+{
+	// Every scope needs a begin and an end timestamp, one additional scope spans the entire frame
+	m_queriesPerFrame = (maxScopesPerFrame + 1) * 2;
+	auto numSlots = pragma::math::max<uint32_t>(context.GetMaxNumberOfFramesInFlight(), 1);
+	m_queryPool = context.CreateQueryPool(QueryType::Timestamp, numSlots * m_queriesPerFrame);
+	if(!m_queryPool) {
+		context.Log("Failed to create query pool for GPU profiler!", pragma::util::LogSeverity::Warning);
+		return;
+	}
+	m_queries.reserve(numSlots * m_queriesPerFrame);
+	for(auto i = decltype(numSlots) {0u}; i < numSlots * m_queriesPerFrame; ++i) {
+		auto query = m_queryPool->CreateTimestampQuery(PipelineStageFlags::BottomOfPipeBit);
+		if(!query) {
+			context.Log("Failed to create timestamp queries for GPU profiler!", pragma::util::LogSeverity::Warning);
+			m_queries.clear();
+			m_queryPool = nullptr;
+			return;
+		}
+		m_queries.push_back(query);
+	}
+	// The pool is not shared, so the ids should be handed out in order, which allows reading each frame's range in one go
+	m_consecutiveQueryIds = true;
+	for(auto i = decltype(m_queries.size()) {0u}; i < m_queries.size(); ++i) {
+		if(m_queries[i]->GetQueryId() != m_queries.front()->GetQueryId() + i) {
+			m_consecutiveQueryIds = false;
+			break;
+		}
+	}
+	m_slots.resize(numSlots);
+	for(auto &slot : m_slots)
+		slot.numQueriesToReset = m_queriesPerFrame;
+}
+
+std::optional<uint32_t> GpuProfiler::WriteTimestamp(ICommandBuffer &cmdBuffer)
+{
+	auto &slot = *m_currentSlot;
+	if(slot.numQueriesUsed >= m_queriesPerFrame)
+		return {};
+	auto queryIdx = slot.numQueriesUsed++;
+	m_queries[m_currentSlotIndex * m_queriesPerFrame + queryIdx]->Write(cmdBuffer);
+	return queryIdx;
+}
+
+void GpuProfiler::BeginFrame(ICommandBuffer &cmdBuffer, uint8_t frameResourceIndex)
+{
+	if(!IsValid())
+		return;
+	if(m_currentSlot) {
+		m_context.Log("GPU profiler frame has been started before the previous one was ended! The previous frame will be discarded.", pragma::util::LogSeverity::Warning);
+		m_currentSlot->numQueriesToReset = m_currentSlot->numQueriesUsed;
+		m_currentSlot = nullptr;
+		m_scopeStack.clear();
+	}
+	m_currentSlotIndex = frameResourceIndex % static_cast<uint32_t>(m_slots.size());
+	auto &slot = m_slots[m_currentSlotIndex];
+	if(slot.pending) {
+		Resolve();
+		if(slot.pending && !ResolveSlot(slot)) {
+			slot.pending = false;
+			++m_stats.numFramesDropped;
+		}
+	}
+	auto *queries = m_queries.data() + m_currentSlotIndex * m_queriesPerFrame;
+	for(auto i = decltype(slot.numQueriesToReset) {0u}; i < slot.numQueriesToReset; ++i)
+		queries[i]->Reset(cmdBuffer);
+	slot.numQueriesToReset = 0;
+	slot.numQueriesUsed = 0;
+	slot.scopes.clear();
+	slot.frameIndex = m_nextFrameIndex++;
+	m_currentSlot = &slot;
+	BeginScope(cmdBuffer, "Frame");
+}
+
+void GpuProfiler::EndFrame(ICommandBuffer &cmdBuffer)
+{
+	if(!m_currentSlot)
+		return;
+	while(!m_scopeStack.empty())
+		EndScope(cmdBuffer);
+	m_currentSlot->numQueriesToReset = m_currentSlot->numQueriesUsed;
+	m_currentSlot->pending = !m_currentSlot->scopes.empty();
+	m_currentSlot = nullptr;
+}
+
+void GpuProfiler::BeginScope(ICommandBuffer &cmdBuffer, const std::string_view &name)
+{
+	if(!m_currentSlot)
+		return;
+	auto &slot = *m_currentSlot;
+	if(slot.numQueriesUsed + 2 > m_queriesPerFrame) {
+		++m_stats.numScopesOverflowed;
+		m_scopeStack.push_back(INVALID_SCOPE_INDEX);
+		return;
+	}
+	Scope scope {};
+	scope.name = name;
+	// Overflowed scopes are skipped, their children are attached to the closest measured ancestor instead
+	for(auto it = m_scopeStack.rbegin(); it != m_scopeStack.rend(); ++it) {
+		if(*it == INVALID_SCOPE_INDEX)
+			continue;
+		scope.parentIndex = *it;
+		scope.depth = slot.scopes[*it].depth + 1;
+		break;
+	}
+	scope.beginQuery = *WriteTimestamp(cmdBuffer);
+	// The end query is reserved right away, so that an open scope can always be closed
+	scope.endQuery = slot.numQueriesUsed++;
+	m_scopeStack.push_back(static_cast<uint32_t>(slot.scopes.size()));
+	slot.scopes.push_back(std::move(scope));
+}
+
+void GpuProfiler::EndScope(ICommandBuffer &cmdBuffer)
+{
+	if(!m_currentSlot || m_scopeStack.empty())
+		return;
+	auto scopeIdx = m_scopeStack.back();
+	m_scopeStack.pop_back();
+	if(scopeIdx == INVALID_SCOPE_INDEX)
+		return;
+	m_queries[m_currentSlotIndex * m_queriesPerFrame + m_currentSlot->scopes[scopeIdx].endQuery]->Write(cmdBuffer);
+}
+
+bool GpuProfiler::ReadTimestamps(uint32_t firstQuery, uint32_t queryCount, std::chrono::nanoseconds *outTimestamps)
+{
+	if(m_timestampResolver) {
+		if(!m_timestampResolver(firstQuery, queryCount, outTimestamps))
+			return false;
+		++m_stats.numBulkReads;
+		return true;
+	}
+	if(m_consecutiveQueryIds) {
+		switch(m_queryPool->QueryTimestampResults(m_queries[firstQuery]->GetQueryId(), queryCount, outTimestamps)) {
+		case IQueryPool::BulkResult::Success:
+			++m_stats.numBulkReads;
+			return true;
+		case IQueryPool::BulkResult::NotReady:
+			return false;
+		default:
+			break;
+		}
+	}
+	// The backend doesn't support bulk reads, fall back to reading the queries individually
+	for(auto i = decltype(queryCount) {0u}; i < queryCount; ++i) {
+		if(!m_queries[firstQuery + i]->QueryResult(outTimestamps[i]))
+			return false;
+	}
+	return true;
+}
+
+bool GpuProfiler::ResolveSlot(FrameSlot &slot)
+{
+	auto slotIndex = static_cast<uint32_t>(&slot - m_slots.data());
+	m_timestampBuffer.resize(slot.numQueriesUsed);
+	if(!ReadTimestamps(slotIndex * m_queriesPerFrame, slot.numQueriesUsed, m_timestampBuffer.data()))
+		return false;
+	FrameResult frame {};
+	frame.frameIndex = slot.frameIndex;
+	frame.scopes.reserve(slot.scopes.size());
+	for(auto &scope : slot.scopes) {
+		ScopeResult result {};
+		result.name = scope.name;
+		result.depth = scope.depth;
+		result.parentIndex = scope.parentIndex;
+		result.start = m_timestampBuffer[scope.beginQuery];
+		result.duration = std::max(m_timestampBuffer[scope.endQuery] - result.start, std::chrono::nanoseconds {0});
+		frame.scopes.push_back(std::move(result));
+	}
+	slot.pending = false;
+	++m_stats.numFramesResolved;
+	m_resolvedFrames.push_back(std::move(frame));
+	while(m_resolvedFrames.size() > m_maxFrameHistory)
+		m_resolvedFrames.pop_front();
+	return true;
+}
+
+void GpuProfiler::Resolve()
+{
+	// Resolve in submission order and stop at the first frame that isn't available yet, so the history stays ordered
+	for(;;) {
+		FrameSlot *oldest = nullptr;
+		for(auto &slot : m_slots) {
+			if(slot.pending && (!oldest || slot.frameIndex < oldest->frameIndex))
+				oldest = &slot;
+		}
+		if(!oldest || !ResolveSlot(*oldest))
+			break;
+	}
+}
+
+static void write_json_string(std::ostream &os, const std::string &str)
+{
+	os << '"';
+	for(auto c : str) {
+		switch(c) {
+		case '"':
+			os << "\\\"";
+			break;
+		case '\\':
+			os << "\\\\";
+			break;
+		case '\n':
+			os << "\\n";
+			break;
+		case '\r':
+			os << "\\r";
+			break;
+		case '\t':
+			os << "\\t";
+			break;
+		default:
+			if(static_cast<unsigned char>(c) < 0x20) {
+				constexpr const char *hexDigits = "0123456789abcdef";
+				os << "\\u00" << hexDigits[(c >> 4) & 0xF] << hexDigits[c & 0xF];
+			}
+			else
+				os << c;
+			break;
+		}
+	}
+	os << '"';
+}
+
+void GpuProfiler::ExportChromeTrace(std::ostream &os) const
+{
+	// Timestamps are written in microseconds relative to the start of the oldest frame
+	auto origin = std::chrono::nanoseconds {0};
+	if(!m_resolvedFrames.empty() && !m_resolvedFrames.front().scopes.empty())
+		origin = m_resolvedFrames.front().scopes.front().start;
+	auto toMicroseconds = [](std::chrono::nanoseconds t) { return std::chrono::duration<double, std::micro> {t}.count(); };
+	auto flags = os.flags();
+	auto precision = os.precision();
+	os << std::fixed << std::setprecision(3);
+	os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+	os << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Queue\"}}";
+	for(auto &frame : m_resolvedFrames) {
+		for(auto &scope : frame.scopes) {
+			os << ",{\"name\":";
+			write_json_string(os, scope.name);
+			os << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+			os << ",\"ts\":" << toMicroseconds(scope.start - origin) << ",\"dur\":" << toMicroseconds(scope.duration);
+			os << ",\"args\":{\"frame\":" << frame.frameIndex << ",\"depth\":" << scope.depth << "}}";
+		}
+	}
+	os << "]}";
+	os.flags(flags);
+	os.precision(precision);
+}
+
+std::string GpuProfiler::ExportChromeTrace() const
+{
+	std::stringstream ss;
+	ExportChromeTrace(ss);
+	return ss.str();
+}
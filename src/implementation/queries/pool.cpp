@@ -23,6 +23,7 @@ bool IQueryPool::RequestQuery(uint32_t &queryId, QueryType type)
 	return true;
 }
 void IQueryPool::FreeQuery(uint32_t queryId) { m_freeQueries.push(queryId); }
+IQueryPool::BulkResult IQueryPool::QueryTimestampResults(uint32_t firstQueryId, uint32_t queryCount, std::chrono::nanoseconds *outTimestampValues) const { return BulkResult::Unsupported; }
 std::shared_ptr<OcclusionQuery> IQueryPool::CreateOcclusionQuery()
 {
 	uint32_t query = 0;
@@ -11,20 +11,24 @@ import :shader_system.shader;
 
 using namespace prosper;
 
+// Worker state of the current thread
+static thread_local const ShaderPipelineLoader *g_currentLoader = nullptr;
+static thread_local size_t g_currentWorkerIdx = 0;
+static thread_local std::optional<ShaderPipelineLoader::Priority> g_currentPriority {};
+
 ShaderPipelineLoader::ShaderPipelineLoader(IPrContext &context) : m_context {context}, m_multiThreaded {context.IsMultiThreadedRenderingEnabled()}
 {
-	if(m_multiThreaded) {
-		m_initThread = std::thread {[this]() {
-			while(m_running)
-				ProcessInitQueue();
-		}};
-		m_bakeThread = std::thread {[this]() {
-			while(m_running)
-				ProcessBakeQueue();
-		}};
-
-		pragma::util::set_thread_name(m_initThread, "prosper_pipeline_loader_init");
-		pragma::util::set_thread_name(m_bakeThread, "prosper_pipeline_loader_bake");
+	if(!m_multiThreaded)
+		return;
+	auto numWorkers = pragma::math::max(std::thread::hardware_concurrency(), 1u);
+	m_workers.reserve(numWorkers);
+	for(auto i = decltype(numWorkers) {0u}; i < numWorkers; ++i)
+		m_workers.push_back(std::make_unique<Worker>());
+	// All workers have to exist before the first thread starts, since idle workers steal from the other queues
+	for(auto i = decltype(m_workers.size()) {0u}; i < m_workers.size(); ++i) {
+		auto &worker = *m_workers[i];
+		worker.thread = std::thread {[this, i]() { RunWorker(i); }};
+		pragma::util::set_thread_name(worker.thread, "prosper_pipeline_loader_" + pragma::util::to_string(i));
 	}
 }
 ShaderPipelineLoader::~ShaderPipelineLoader() { Stop(); }
@@ -33,89 +37,279 @@ void ShaderPipelineLoader::Stop()
 {
 	if(!m_running)
 		return;
-	m_running = false;
+	{
+		std::scoped_lock lock {m_stateMutex};
+		m_running = false;
+	}
 	if(!m_multiThreaded)
 		return;
-	m_initPending.notify_one();
-	m_bakePending.notify_one();
-	m_initThread.join();
-	m_bakeThread.join();
-}
-
-void ShaderPipelineLoader::ProcessInitQueue()
-{
-	std::queue<InitItem> initQueue;
-	if(m_multiThreaded) {
-		if(m_multiThreaded) {
-			std::unique_lock<std::mutex> lock {m_initQueueMutex};
-			m_initPending.wait(lock, [this]() { return !m_initQueue.empty() || !m_running; });
-			if(!m_running)
-				return;
-			initQueue = std::move(m_initQueue);
-			m_initQueue = {};
+	// Discard queued tasks. This breaks their promises, so that threads waiting for them are released.
+	for(auto &worker : m_workers) {
+		std::scoped_lock lock {worker->queueMutex};
+		for(auto &queue : worker->queues)
+			queue.clear();
+	}
+	{
+		std::scoped_lock lock {m_stateMutex};
+		m_numQueuedTasks = {};
+		m_numQueuedShaderTasks.clear();
+	}
+	m_stateChanged.notify_all();
+	for(auto &worker : m_workers)
+		worker->thread.join();
+}
+
+void ShaderPipelineLoader::Push(Task &&task)
+{
+	size_t workerIdx;
+	if(g_currentLoader == this)
+		workerIdx = g_currentWorkerIdx; // Tasks spawned by a task are kept local to the worker
+	else
+		workerIdx = m_nextWorker++ % m_workers.size();
+	auto &worker = *m_workers[workerIdx];
+	auto priority = pragma::math::to_integral(task.priority);
+	// The task has to be counted before it becomes visible to other threads, otherwise it could be dequeued before it was counted
+	std::scoped_lock lock {worker.queueMutex};
+	{
+		std::scoped_lock lockState {m_stateMutex};
+		OnTaskQueued(task);
+	}
+	worker.queues[priority].push_back(std::move(task));
+	m_stateChanged.notify_all();
+}
+
+void ShaderPipelineLoader::OnTaskQueued(const Task &task)
+{
+	++m_numQueuedTasks[pragma::math::to_integral(task.priority)];
+	++m_numQueuedShaderTasks[task.shaderIndex];
+}
+
+void ShaderPipelineLoader::OnTaskDequeued(const Task &task)
+{
+	--m_numQueuedTasks[pragma::math::to_integral(task.priority)];
+	auto it = m_numQueuedShaderTasks.find(task.shaderIndex);
+	if(it != m_numQueuedShaderTasks.end() && --it->second == 0)
+		m_numQueuedShaderTasks.erase(it);
+}
+
+bool ShaderPipelineLoader::HasQueuedTasks(Priority minPriority, std::optional<ShaderIndex> shaderIndex) const
+{
+	if(shaderIndex.has_value())
+		return m_numQueuedShaderTasks.contains(*shaderIndex);
+	for(auto priority = pragma::math::to_integral(minPriority); priority < pragma::math::to_integral(Priority::Count); ++priority) {
+		if(m_numQueuedTasks[priority] > 0)
+			return true;
+	}
+	return false;
+}
+
+std::optional<ShaderPipelineLoader::Task> ShaderPipelineLoader::PopTask(std::optional<size_t> workerIdx, Priority minPriority, std::optional<ShaderIndex> shaderIndex)
+{
+	auto numWorkers = m_workers.size();
+	auto fMatches = [&shaderIndex](const Task &task) { return !shaderIndex.has_value() || task.shaderIndex == *shaderIndex; };
+	auto fDequeue = [this](std::deque<Task> &queue, std::deque<Task>::iterator it) -> Task {
+		auto task = std::move(*it);
+		queue.erase(it);
+		std::scoped_lock lock {m_stateMutex};
+		OnTaskDequeued(task);
+		return task;
+	};
+	for(auto priority = pragma::math::to_integral(Priority::Count); priority-- > pragma::math::to_integral(minPriority);) {
+		if(workerIdx.has_value()) {
+			// Own queue first, newest tasks first
+			auto &worker = *m_workers[*workerIdx];
+			std::scoped_lock lock {worker.queueMutex};
+			auto &queue = worker.queues[priority];
+			auto it = std::find_if(queue.rbegin(), queue.rend(), fMatches);
+			if(it != queue.rend())
+				return fDequeue(queue, std::next(it).base());
 		}
-		else {
-			initQueue = std::move(m_initQueue);
-			m_initQueue = {};
+		// Steal the oldest task from another worker
+		auto offset = workerIdx.has_value() ? (*workerIdx + 1) : 0;
+		for(auto i = decltype(numWorkers) {0u}; i < numWorkers; ++i) {
+			auto idx = (offset + i) % numWorkers;
+			if(workerIdx.has_value() && idx == *workerIdx)
+				continue;
+			auto &worker = *m_workers[idx];
+			std::scoped_lock lock {worker.queueMutex};
+			auto &queue = worker.queues[priority];
+			auto it = std::find_if(queue.begin(), queue.end(), fMatches);
+			if(it == queue.end())
+				continue;
+			return fDequeue(queue, it);
 		}
 	}
-	else {
-		initQueue = std::move(m_initQueue);
-		m_initQueue = {};
-	}
-	auto n = initQueue.size();
-	while(!initQueue.empty()) {
-		auto &item = initQueue.front();
-		auto res = item.init();
-		if(res)
-			m_shadersPendingForFinalization.insert(item.shaderIndex);
-		AddPendingShaderJobCount(item.shaderIndex, -1);
-		initQueue.pop();
-	}
-	m_pendingWorkMutex.lock();
-	m_pendingWork -= n;
-	m_pendingWorkCondition.notify_one();
-	m_pendingWorkMutex.unlock();
-}
-void ShaderPipelineLoader::ProcessBakeQueue()
-{
-	std::queue<BakeItem> bakeQueue;
-	if(m_multiThreaded) {
-		if(m_multiThreaded) {
-			std::unique_lock<std::mutex> lock {m_bakeQueueMutex};
-			m_bakePending.wait(lock, [this]() { return !m_bakeQueue.empty() || !m_running; });
-			if(!m_running)
-				return;
-			bakeQueue = std::move(m_bakeQueue);
-			m_bakeQueue = {};
+	return {};
+}
+
+bool ShaderPipelineLoader::RunTask(std::optional<size_t> workerIdx, Priority minPriority, std::optional<ShaderIndex> shaderIndex)
+{
+	auto task = PopTask(workerIdx, minPriority, shaderIndex);
+	if(!task.has_value())
+		return false;
+	auto prevPriority = g_currentPriority;
+	g_currentPriority = task->priority;
+	task->execute();
+	g_currentPriority = prevPriority;
+
+	AddPendingShaderJobCount(task->shaderIndex, -1);
+	{
+		std::scoped_lock lock {m_stateMutex};
+		--m_pendingWork;
+	}
+	m_stateChanged.notify_all();
+	return true;
+}
+
+void ShaderPipelineLoader::RunWorker(size_t workerIdx)
+{
+	g_currentLoader = this;
+	g_currentWorkerIdx = workerIdx;
+	while(m_running) {
+		if(RunTask(workerIdx))
+			continue;
+		std::unique_lock lock {m_stateMutex};
+		m_stateChanged.wait(lock, [this]() { return HasQueuedTasks(Priority::Low) || !m_running; });
+	}
+}
+
+void ShaderPipelineLoader::HelpUntil(const std::function<bool()> &isDone, Priority minPriority, std::optional<ShaderIndex> shaderIndex)
+{
+	std::optional<size_t> workerIdx {};
+	if(g_currentLoader == this)
+		workerIdx = g_currentWorkerIdx;
+	while(!isDone() && m_running) {
+		if(RunTask(workerIdx, minPriority, shaderIndex))
+			continue;
+		// Only wake up for tasks this thread is allowed to run, otherwise it would spin until they have been picked up by a worker
+		std::unique_lock lock {m_stateMutex};
+		m_stateChanged.wait(lock, [this, &isDone, minPriority, shaderIndex]() { return HasQueuedTasks(minPriority, shaderIndex) || !m_running || isDone(); });
+	}
+}
+
+std::shared_future<bool> ShaderPipelineLoader::AddTask(ShaderIndex shaderIndex, const std::function<bool()> &task, std::optional<Priority> priority)
+{
+	auto promise = std::make_shared<std::promise<bool>>();
+	std::shared_future<bool> future = promise->get_future().share();
+	if(!m_running) {
+		promise->set_value(false);
+		return future;
+	}
+	auto execute = [task, promise]() {
+		try {
+			promise->set_value(task());
 		}
-		else {
-			bakeQueue = std::move(m_bakeQueue);
-			m_bakeQueue = {};
+		catch(...) {
+			promise->set_exception(std::current_exception());
 		}
+	};
+	if(!m_multiThreaded) {
+		execute();
+		return future;
 	}
-	else {
-		bakeQueue = std::move(m_bakeQueue);
-		m_bakeQueue = {};
+	AddPendingShaderJobCount(shaderIndex, 1);
+	++m_pendingWork;
+	Push(Task {shaderIndex, priority.value_or(g_currentPriority.value_or(Priority::Normal)), std::move(execute)});
+	return future;
+}
+
+bool ShaderPipelineLoader::Wait(const std::shared_future<bool> &future, std::optional<ShaderIndex> shaderIndex)
+{
+	if(!future.valid())
+		return false;
+	auto fIsReady = [&future]() { return future.wait_for(std::chrono::seconds {0}) == std::future_status::ready; };
+	// A thread that is already executing a task must not pick up arbitrary tasks. E.g. the init task of a derived shader would wait for the
+	// init task of its base shader, which may be further down the stack of this very thread. Tasks of the awaited shader are safe, since
+	// they can only wait on shaders further up the base shader chain.
+	if(!g_currentPriority.has_value())
+		HelpUntil(fIsReady, Priority::Low);
+	else if(shaderIndex.has_value())
+		HelpUntil(fIsReady, Priority::Low, shaderIndex);
+	future.wait();
+	try {
+		return future.get();
 	}
-	auto n = bakeQueue.size();
-	while(!bakeQueue.empty()) {
-		auto &item = bakeQueue.front();
-		m_context.BakeShaderPipeline(item.pipelineId, item.pipelineBindPoint);
-		AddPendingShaderJobCount(item.shaderIndex, -1);
-		bakeQueue.pop();
+	catch(const std::future_error &) {
+		// Task was discarded
+		return false;
 	}
-	m_pendingWorkMutex.lock();
-	m_pendingWork -= n;
-	m_pendingWorkCondition.notify_one();
-	m_pendingWorkMutex.unlock();
 }
+
+bool ShaderPipelineLoader::WaitForInit(ShaderIndex shaderIndex)
+{
+	std::shared_future<bool> future;
+	{
+		std::scoped_lock lock {m_pendingShaderJobsMutex};
+		auto it = m_initJobs.find(shaderIndex);
+		if(it == m_initJobs.end())
+			return true;
+		future = it->second;
+	}
+	// Avoid waiting on a lower priority task
+	if(g_currentPriority.has_value())
+		Prioritize(shaderIndex, *g_currentPriority);
+	return Wait(future, shaderIndex);
+}
+
+void ShaderPipelineLoader::Prioritize(ShaderIndex shaderIndex, Priority priority)
+{
+	if(!m_multiThreaded)
+		return;
+	auto dstPriority = pragma::math::to_integral(priority);
+	for(auto &worker : m_workers) {
+		std::scoped_lock lock {worker->queueMutex};
+		auto &dstQueue = worker->queues[dstPriority];
+		for(auto i = decltype(dstPriority) {0u}; i < dstPriority; ++i) {
+			auto &queue = worker->queues[i];
+			for(auto it = queue.begin(); it != queue.end();) {
+				if(it->shaderIndex != shaderIndex) {
+					++it;
+					continue;
+				}
+				{
+					std::scoped_lock lockState {m_stateMutex};
+					--m_numQueuedTasks[i];
+					++m_numQueuedTasks[dstPriority];
+				}
+				it->priority = priority;
+				dstQueue.push_back(std::move(*it));
+				it = queue.erase(it);
+			}
+		}
+	}
+	// Threads that only help out with high priority tasks may be able to run them now
+	m_stateChanged.notify_all();
+}
+
 bool ShaderPipelineLoader::IsShaderQueued(ShaderIndex shaderIndex) const
 {
 	std::scoped_lock lock {m_pendingShaderJobsMutex};
 	auto it = m_pendingShaderJobs.find(shaderIndex);
 	return it != m_pendingShaderJobs.end() && it->second > 0;
 }
+void ShaderPipelineLoader::FinalizeCompletedShaders()
+{
+	std::vector<ShaderIndex> shaders;
+	{
+		std::scoped_lock lock {m_finalizationMutex};
+		shaders.reserve(m_shadersPendingForFinalization.size());
+		for(auto it = m_shadersPendingForFinalization.begin(); it != m_shadersPendingForFinalization.end();) {
+			// Shaders with pipelines that are still being baked have to wait
+			if(IsShaderQueued(*it)) {
+				++it;
+				continue;
+			}
+			shaders.push_back(*it);
+			it = m_shadersPendingForFinalization.erase(it);
+		}
+	}
+	for(auto idx : shaders) {
+		auto *shader = m_context.GetShaderManager().GetShader(idx);
+		if(!shader)
+			continue;
+		shader->FinalizeInitialization();
+	}
+}
 void ShaderPipelineLoader::Flush()
 {
 	if(!m_running)
@@ -123,21 +317,28 @@ void ShaderPipelineLoader::Flush()
 	if(m_pendingWork > 0 && m_multiThreaded) {
 		if(std::this_thread::get_id() != m_context.GetMainThreadId())
 			throw std::runtime_error {"Pipeline loader must not be flushed from non-main thread!"};
-		std::unique_lock<std::mutex> lock {m_pendingWorkMutex};
-		m_pendingWorkCondition.wait(lock, [this]() { return m_pendingWork == 0; });
+		HelpUntil([this]() { return m_pendingWork == 0; }, Priority::Low);
 	}
-
-	// No need for a mutex, since all threaded work has been completed
-	if(!m_shadersPendingForFinalization.empty()) {
-		auto shadersPendingForFinalization = std::move(m_shadersPendingForFinalization);
-		m_shadersPendingForFinalization.clear();
-		for(auto idx : shadersPendingForFinalization) {
-			auto *shader = m_context.GetShaderManager().GetShader(idx);
-			if(!shader)
-				continue;
-			shader->FinalizeInitialization();
-		}
+	FinalizeCompletedShaders();
+}
+void ShaderPipelineLoader::WaitForShader(ShaderIndex shaderIndex)
+{
+	if(!m_running)
+		return;
+	if(m_multiThreaded && IsShaderQueued(shaderIndex)) {
+		if(std::this_thread::get_id() != m_context.GetMainThreadId())
+			throw std::runtime_error {"Pipeline loader must not be flushed from non-main thread!"};
+		Prioritize(shaderIndex);
+		// The main thread only helps out with high priority tasks, to avoid getting stuck on unrelated shaders
+		HelpUntil([this, shaderIndex]() { return !IsShaderQueued(shaderIndex); }, Priority::High);
 	}
+	FinalizeCompletedShaders();
+}
+void ShaderPipelineLoader::Update()
+{
+	if(!m_running)
+		return;
+	FinalizeCompletedShaders();
 }
 void ShaderPipelineLoader::AddPendingShaderJobCount(ShaderIndex shaderIndex, int32_t i)
 {
@@ -150,43 +351,34 @@ void ShaderPipelineLoader::AddPendingShaderJobCount(ShaderIndex shaderIndex, int
 		m_pendingShaderJobs.erase(it);
 	m_pendingShaderJobsMutex.unlock();
 }
-void ShaderPipelineLoader::Init(ShaderIndex shaderIndex, const std::function<bool()> &job)
+std::shared_future<bool> ShaderPipelineLoader::Init(ShaderIndex shaderIndex, const std::function<bool()> &job, Priority priority)
 {
-	if(!m_running)
-		return;
-	AddPendingShaderJobCount(shaderIndex, 1);
-	m_pendingWorkMutex.lock();
-	++m_pendingWork;
-	m_pendingWorkMutex.unlock();
-
-	m_initQueueMutex.lock();
-	m_initQueue.push(InitItem {shaderIndex, job});
-	m_initQueueMutex.unlock();
-	m_initPending.notify_one();
-
-	if(!m_multiThreaded) {
-		ProcessInitQueue();
-		ProcessBakeQueue();
-		Flush();
+	auto future = AddTask(
+	  shaderIndex,
+	  [this, shaderIndex, job]() -> bool {
+		  auto res = job();
+		  if(res) {
+			  std::scoped_lock lock {m_finalizationMutex};
+			  m_shadersPendingForFinalization.insert(shaderIndex);
+		  }
+		  return res;
+	  },
+	  priority);
+	{
+		std::scoped_lock lock {m_pendingShaderJobsMutex};
+		m_initJobs[shaderIndex] = future;
 	}
+	if(!m_multiThreaded)
+		Flush();
+	return future;
 }
-void ShaderPipelineLoader::Bake(ShaderIndex shaderIndex, PipelineID id, PipelineBindPoint pipelineType)
+std::shared_future<bool> ShaderPipelineLoader::Bake(ShaderIndex shaderIndex, PipelineID id, PipelineBindPoint pipelineType)
 {
-	if(!m_running)
-		return;
-	AddPendingShaderJobCount(shaderIndex, 1);
-	m_pendingWorkMutex.lock();
-	++m_pendingWork;
-	m_pendingWorkMutex.unlock();
-
-	m_bakeQueueMutex.lock();
-	m_bakeQueue.push(BakeItem {shaderIndex, id, pipelineType});
-	m_bakeQueueMutex.unlock();
-	m_bakePending.notify_one();
-
-	if(!m_multiThreaded) {
-		ProcessInitQueue();
-		ProcessBakeQueue();
+	auto future = AddTask(shaderIndex, [this, id, pipelineType]() -> bool {
+		m_context.BakeShaderPipeline(id, pipelineType);
+		return true;
+	});
+	if(!m_multiThreaded)
 		Flush();
-	}
+	return future;
 }
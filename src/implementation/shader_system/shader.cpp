@@ -51,6 +51,8 @@ prosper::Shader::Shader(IPrContext &context, const std::string &identifier, cons
 void prosper::Shader::Release(bool bDelete)
 {
 	ClearPipelines();
+	if(IsHotReloading())
+		ReleaseRetiredPipelines();
 	for(auto &stage : m_stages)
 		stage.reset();
 	if(bDelete == true)
@@ -99,7 +101,7 @@ prosper::PipelineBindPoint prosper::Shader::GetPipelineBindPoint() const { retur
 
 prosper::ShaderModule *prosper::Shader::GetModule(ShaderStage stage)
 {
-	auto *stageModule = GetStage(stage);
+	auto *stageModule = IsHotReloading() ? m_retiredStages.at(pragma::math::to_integral(stage)).get() : GetStage(stage);
 	if(stageModule == nullptr)
 		return nullptr;
 	return stageModule->module.get();
@@ -176,10 +178,57 @@ void prosper::Shader::SetIdentifier(const std::string &identifier) { m_identifie
 
 uint32_t prosper::Shader::GetPipelineCount() const
 {
+	if(IsHotReloading())
+		return m_retiredPipelineInfos.size();
 	FlushLoad();
 	return m_pipelineInfos.size();
 }
 void prosper::Shader::ReloadPipelines(bool bReloadSourceCode) { Initialize(bReloadSourceCode); }
+void prosper::Shader::HotReload()
+{
+	FlushLoad();
+	auto valid = m_bValid || IsHotReloading();
+	if(m_bValid && !IsHotReloading()) {
+		// The loader builds the new pipelines into a separate set, the current one stays untouched and is used by the main thread
+		// until FinalizeInitialization swaps them
+		m_retiredPipelineInfos = std::move(m_pipelineInfos);
+		m_pipelineInfos.resize(m_retiredPipelineInfos.size(), {});
+		m_cachedPipelineIds.assign(m_cachedPipelineIds.size(), std::numeric_limits<PipelineID>::max());
+		m_retiredStages = m_stages;
+		for(auto &stage : m_stages) {
+			if(!stage)
+				continue;
+			auto newStage = std::make_shared<ShaderStageData>();
+			newStage->path = stage->path;
+			stage = std::move(newStage);
+		}
+		m_hotReloading = true;
+	}
+	// ClearPipelines only touches the pending set during a hot reload, so this doesn't stall the device
+	Initialize(true);
+	// The retired pipelines can still be used for rendering
+	m_bValid = valid;
+}
+void prosper::Shader::ReleaseRetiredPipelines()
+{
+	auto &context = GetContext();
+	std::vector<PipelineID> pipelineIds;
+	pipelineIds.reserve(m_retiredPipelineInfos.size());
+	for(auto &pipelineInfo : m_retiredPipelineInfos) {
+		if(pipelineInfo.id != std::numeric_limits<PipelineID>::max())
+			pipelineIds.push_back(pipelineInfo.id);
+	}
+	m_retiredPipelineInfos.clear();
+	m_hotReloading = false;
+	// Command buffers of frames that are still in flight may be referencing the pipelines
+	context.KeepResourceAliveUntilPresentationComplete(std::shared_ptr<void> {nullptr, [&context, pipelineIds = std::move(pipelineIds), stages = std::move(m_retiredStages), graphics = IsGraphicsShader()](void *) {
+		// The retired stage modules are released together with the pipelines
+		static_cast<void>(stages);
+		for(auto id : pipelineIds)
+			context.ClearPipeline(graphics, id);
+	}});
+	m_retiredStages = {};
+}
 void prosper::Shader::Initialize(bool bReloadSourceCode)
 {
 	auto &context = GetContext();
@@ -197,7 +246,7 @@ void prosper::Shader::Initialize(bool bReloadSourceCode)
 	ClearShaderResources();
 	InitializeShaderResources();
 
-	auto fInit = [this, shouldLog, &context, bReloadSourceCode]() -> bool {
+	auto fInit = [this, shouldLog, &context, &loader, bReloadSourceCode]() -> bool {
 		if(shouldLog)
 			context.Log("Initializing shader sources for '" + GetIdentifier() + "'...", pragma::util::LogSeverity::Debug);
 		context.StartProfiling("Initialize shader sources");
@@ -213,6 +262,9 @@ void prosper::Shader::Initialize(bool bReloadSourceCode)
 		if(shouldLog)
 			context.Log("Initializing shader pipelines for '" + GetIdentifier() + "'...", pragma::util::LogSeverity::Debug);
 		if(m_enableMultiThreadedPipelineInitialization) {
+			// Derived pipelines require the pipelines of the base shader
+			if(auto basePipeline = m_basePipeline.lock())
+				loader.WaitForInit(basePipeline->GetIndex());
 			context.StartProfiling("Initialize shader pipelines");
 			InitializePipeline();
 			context.EndProfiling();
@@ -227,6 +279,8 @@ void prosper::Shader::FinalizeInitialization()
 {
 	m_bValid = true;
 	m_loading = false;
+	if(IsHotReloading())
+		ReleaseRetiredPipelines();
 	if(!m_enableMultiThreadedPipelineInitialization)
 		InitializePipeline();
 	OnPipelinesInitialized();
@@ -306,10 +360,15 @@ void prosper::Shader::OnPipelineInitialized(uint32_t pipelineIdx)
 }
 void prosper::Shader::ClearPipelines()
 {
-	GetContext().WaitIdle();
 	auto &loader = GetContext().GetPipelineLoader();
 	if(loader.IsShaderQueued(GetIndex()))
 		FlushLoad();
+	auto hasPipelines = std::any_of(m_pipelineInfos.begin(), m_pipelineInfos.end(), [](const PipelineInfo &pipelineInfo) { return pipelineInfo.id != std::numeric_limits<PipelineID>::max(); });
+	if(!hasPipelines)
+		return;
+	// Pipelines that were built during a hot reload have never been swapped in, so they can't be in use yet
+	if(!IsHotReloading())
+		GetContext().WaitIdle();
 	for(auto &pipelineInfo : m_pipelineInfos) {
 		if(pipelineInfo.id == std::numeric_limits<PipelineID>::max())
 			continue;
@@ -342,7 +401,7 @@ void prosper::Shader::SetBaseShader(Shader &shader) { m_basePipeline = shader.sh
 void prosper::Shader::ClearBaseShader() { m_basePipeline = {}; }
 const prosper::ShaderModuleStageEntryPoint *prosper::Shader::GetModuleStageEntryPoint(ShaderStage stage, uint32_t pipelineIdx) const
 {
-	auto *stageData = GetStage(stage);
+	auto *stageData = IsHotReloading() ? m_retiredStages.at(pragma::math::to_integral(stage)).get() : GetStage(stage);
 	if(stageData == nullptr)
 		return nullptr;
 	return stageData->entryPoint.get();
@@ -350,8 +409,14 @@ const prosper::ShaderModuleStageEntryPoint *prosper::Shader::GetModuleStageEntry
 bool prosper::Shader::GetPipelineId(PipelineID &pipelineId, uint32_t pipelineIdx, bool waitForLoad) const
 {
 	const PipelineInfo *info = nullptr;
-	if(!waitForLoad)
+	if(IsHotReloading())
+		info = (pipelineIdx < m_retiredPipelineInfos.size()) ? &m_retiredPipelineInfos[pipelineIdx] : nullptr;
+	else if(!waitForLoad) {
+		// The loader may still be writing the pipeline infos
+		if(m_loading)
+			return false;
 		info = (pipelineIdx < m_pipelineInfos.size()) ? &m_pipelineInfos[pipelineIdx] : nullptr;
+	}
 	else
 		info = GetPipelineInfo(pipelineIdx);
 	if(!info)
@@ -359,6 +424,13 @@ bool prosper::Shader::GetPipelineId(PipelineID &pipelineId, uint32_t pipelineIdx
 	pipelineId = info->id;
 	return true;
 }
+bool prosper::Shader::GetLoadedPipelineId(PipelineID &pipelineId, uint32_t pipelineIdx) const
+{
+	if(pipelineIdx >= m_pipelineInfos.size())
+		return false;
+	pipelineId = m_pipelineInfos[pipelineIdx].id;
+	return true;
+}
 size_t prosper::Shader::GetBaseTypeHashCode() const { return typeid(Shader).hash_code(); }
 
 bool prosper::Shader::RecordPushConstants(ShaderBindState &bindState, uint32_t size, const void *data, uint32_t offset) const
@@ -375,6 +447,9 @@ bool prosper::Shader::RecordPushConstants(ShaderBindState &bindState, uint32_t s
 const prosper::PipelineInfo *prosper::Shader::GetPipelineInfo(PipelineID id) const { return const_cast<Shader *>(this)->GetPipelineInfo(id); }
 prosper::PipelineInfo *prosper::Shader::GetPipelineInfo(PipelineID id)
 {
+	// While the shader is being hot-reloaded, the previous pipelines are used instead of waiting for the new ones
+	if(IsHotReloading())
+		return (id < m_retiredPipelineInfos.size()) ? &m_retiredPipelineInfos.at(id) : nullptr;
 	FlushLoad();
 	return (id < m_pipelineInfos.size()) ? &m_pipelineInfos.at(id) : nullptr;
 }
@@ -473,7 +548,7 @@ void prosper::Shader::FlushLoad() const
 	if(!m_loading)
 		return;
 	m_loading = false;
-	GetContext().GetPipelineLoader().Flush();
+	GetContext().GetPipelineLoader().WaitForShader(GetIndex());
 }
 void prosper::Shader::BakePipelines() const
 {
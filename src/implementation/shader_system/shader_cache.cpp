@@ -0,0 +1,196 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#include <lz4.h>
+
+module pragma.prosper;
+
+import :shader_system.shader_cache;
+
+using namespace prosper;
+
+namespace {
+	constexpr std::array<char, 4> CACHE_FILE_MAGIC = {'P', 'R', 'S', 'C'};
+	constexpr auto CACHE_FILE_EXTENSION = ".prsc";
+	struct CacheFileHeader {
+		std::array<char, 4> magic;
+		uint32_t version;
+		uint64_t hash0;
+		uint64_t hash1;
+		uint32_t lineOffset;
+		uint32_t reserved;
+		uint64_t sourceSize;
+		uint64_t spirvSize;
+		uint64_t compressedSize;
+	};
+	static_assert(sizeof(CacheFileHeader) == 56);
+
+	// Two independent 64-bit FNV-1a style hashes, which makes accidental collisions practically impossible
+	struct KeyHasher {
+		uint64_t hash0 = 14'695'981'039'346'656'037ull;
+		uint64_t hash1 = 0x9ae1'6a3b'2f90'404full;
+		void Add(const void *data, size_t size)
+		{
+			auto *bytes = static_cast<const uint8_t *>(data);
+			for(auto i = decltype(size) {0u}; i < size; ++i) {
+				hash0 = (hash0 ^ bytes[i]) * 1'099'511'628'211ull;
+				hash1 = (hash1 ^ bytes[i]) * 0x9e37'79b9'7f4a'7c15ull;
+			}
+		}
+		void Add(const std::string &str)
+		{
+			// The length is included to make the concatenation of multiple strings unambiguous
+			uint64_t len = str.length();
+			Add(&len, sizeof(len));
+			Add(str.data(), str.length());
+		}
+	};
+};
+
+std::string ShaderCache::Key::ToString() const
+{
+	constexpr const char *digits = "0123456789abcdef";
+	std::string str;
+	str.reserve(32);
+	for(auto hash : {hash0, hash1}) {
+		for(auto i = 15; i >= 0; --i)
+			str += digits[(hash >> (i * 4)) & 0xF];
+	}
+	return str;
+}
+
+ShaderCache::Key ShaderCache::CalcKey(const std::string &expandedSource, const std::unordered_map<std::string, std::string> &definitions, const std::string &prefixCode, ShaderStage stage, const std::string &compilerVersion)
+{
+	KeyHasher hasher {};
+	auto version = FORMAT_VERSION;
+	hasher.Add(&version, sizeof(version));
+	hasher.Add(&stage, sizeof(stage));
+	hasher.Add(compilerVersion);
+	hasher.Add(prefixCode);
+	// The iteration order of the map is undefined, so the definitions have to be sorted first
+	std::vector<const std::pair<const std::string, std::string> *> sortedDefinitions;
+	sortedDefinitions.reserve(definitions.size());
+	for(auto &pair : definitions)
+		sortedDefinitions.push_back(&pair);
+	std::sort(sortedDefinitions.begin(), sortedDefinitions.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+	for(auto *pair : sortedDefinitions) {
+		hasher.Add(pair->first);
+		hasher.Add(pair->second);
+	}
+	hasher.Add(expandedSource);
+	return {hasher.hash0, hasher.hash1};
+}
+
+ShaderCache::ShaderCache(const std::string &rootPath) : m_rootPath {rootPath}
+{
+	if(!m_rootPath.empty() && m_rootPath.back() != '/' && m_rootPath.back() != '\\')
+		m_rootPath += '/';
+}
+
+std::string ShaderCache::GetEntryPath(const Key &key) const { return m_rootPath + key.ToString() + CACHE_FILE_EXTENSION; }
+
+std::optional<ShaderCache::Entry> ShaderCache::Load(const Key &key) const
+{
+	auto fMiss = [this]() -> std::optional<Entry> {
+		++m_numMisses;
+		return {};
+	};
+	std::ifstream f {GetEntryPath(key), std::ios::binary};
+	if(!f)
+		return fMiss();
+	CacheFileHeader header;
+	f.read(reinterpret_cast<char *>(&header), sizeof(header));
+	if(!f || header.magic != CACHE_FILE_MAGIC || header.version != FORMAT_VERSION || header.hash0 != key.hash0 || header.hash1 != key.hash1)
+		return fMiss();
+	constexpr uint64_t maxSize = std::numeric_limits<int>::max();
+	auto size = header.sourceSize + header.spirvSize;
+	if(size > maxSize || header.compressedSize > maxSize || (header.spirvSize % sizeof(uint32_t)) != 0)
+		return fMiss();
+	std::vector<char> compressedData(header.compressedSize);
+	f.read(compressedData.data(), compressedData.size());
+	if(!f)
+		return fMiss();
+	std::vector<char> data(size);
+	auto decompressedSize = LZ4_decompress_safe(compressedData.data(), data.data(), static_cast<int>(compressedData.size()), static_cast<int>(data.size()));
+	if(decompressedSize < 0 || static_cast<uint64_t>(decompressedSize) != size)
+		return fMiss();
+
+	Entry entry {};
+	entry.preprocessedSource.assign(data.data(), header.sourceSize);
+	entry.lineOffset = header.lineOffset;
+	entry.spirv.resize(header.spirvSize / sizeof(uint32_t));
+	std::memcpy(entry.spirv.data(), data.data() + header.sourceSize, header.spirvSize);
+	++m_numHits;
+	return entry;
+}
+
+bool ShaderCache::Store(const Key &key, const Entry &entry)
+{
+	auto spirvSize = entry.spirv.size() * sizeof(uint32_t);
+	auto size = entry.preprocessedSource.size() + spirvSize;
+	if(size > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+		return false;
+	std::vector<char> data(size);
+	std::memcpy(data.data(), entry.preprocessedSource.data(), entry.preprocessedSource.size());
+	std::memcpy(data.data() + entry.preprocessedSource.size(), entry.spirv.data(), spirvSize);
+	std::vector<char> compressedData(LZ4_compressBound(static_cast<int>(size)));
+	auto compressedSize = LZ4_compress_default(data.data(), compressedData.data(), static_cast<int>(size), static_cast<int>(compressedData.size()));
+	if(compressedSize <= 0)
+		return false;
+
+	CacheFileHeader header {};
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = FORMAT_VERSION;
+	header.hash0 = key.hash0;
+	header.hash1 = key.hash1;
+	header.lineOffset = entry.lineOffset;
+	header.sourceSize = entry.preprocessedSource.size();
+	header.spirvSize = spirvSize;
+	header.compressedSize = compressedSize;
+
+	std::error_code ec;
+	std::filesystem::create_directories(m_rootPath, ec);
+	// The temporary file name has to be unique across threads and processes sharing the cache
+	auto path = GetEntryPath(key);
+	auto tmpPath = path + "." + pragma::util::to_string(std::hash<std::thread::id> {}(std::this_thread::get_id())) + "_" + pragma::util::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_" + pragma::util::to_string(m_tmpFileIndex++) + ".tmp";
+	{
+		std::ofstream f {tmpPath, std::ios::binary | std::ios::trunc};
+		if(f) {
+			f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+			f.write(compressedData.data(), compressedSize);
+		}
+		if(!f) {
+			f.close();
+			std::filesystem::remove(tmpPath, ec);
+			return false;
+		}
+	}
+	// Replaces the previous entry atomically
+	std::filesystem::rename(tmpPath, path, ec);
+	if(ec) {
+		std::filesystem::remove(tmpPath, ec);
+		return false;
+	}
+	++m_numWrites;
+	return true;
+}
+
+void ShaderCache::Clear()
+{
+	std::error_code ec;
+	for(auto &dirEntry : std::filesystem::directory_iterator {m_rootPath, ec}) {
+		if(dirEntry.path().extension() == CACHE_FILE_EXTENSION)
+			std::filesystem::remove(dirEntry.path(), ec);
+	}
+}
+
+ShaderCache::Stats ShaderCache::GetStats() const
+{
+	Stats stats {};
+	stats.numHits = m_numHits;
+	stats.numMisses = m_numMisses;
+	stats.numWrites = m_numWrites;
+	return stats;
+}
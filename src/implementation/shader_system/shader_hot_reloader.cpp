@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+module pragma.prosper;
+
+import :glsl;
+import :shader_system.manager;
+import :shader_system.shader;
+import :shader_system.shader_hot_reloader;
+
+using namespace prosper;
+
+std::string ShaderDependencyGraph::NormalizePath(const std::string &path)
+{
+	auto normalizedPath = path;
+	std::replace(normalizedPath.begin(), normalizedPath.end(), '\\', '/');
+	pragma::string::to_lower(normalizedPath);
+	return normalizedPath;
+}
+
+void ShaderDependencyGraph::SetIncludes(const std::string &filePath, const std::vector<std::string> &includes)
+{
+	auto path = NormalizePath(filePath);
+	std::vector<std::string> normalizedIncludes;
+	normalizedIncludes.reserve(includes.size());
+	for(auto &include : includes)
+		normalizedIncludes.push_back(NormalizePath(include));
+
+	{
+		// Most files are preprocessed many times without changing, so avoid the exclusive lock where possible
+		std::shared_lock lock {m_mutex};
+		auto it = m_includes.find(path);
+		if(it != m_includes.end() && it->second == normalizedIncludes)
+			return;
+	}
+	std::unique_lock lock {m_mutex};
+	auto &curIncludes = m_includes[path];
+	for(auto &include : curIncludes) {
+		auto it = m_includedBy.find(include);
+		if(it != m_includedBy.end())
+			it->second.erase(path);
+	}
+	for(auto &include : normalizedIncludes)
+		m_includedBy[include].insert(path);
+	curIncludes = std::move(normalizedIncludes);
+}
+
+std::unordered_set<std::string> ShaderDependencyGraph::FindDependents(const std::string &filePath) const
+{
+	std::unordered_set<std::string> dependents;
+	std::vector<std::string> queue {NormalizePath(filePath)};
+	std::shared_lock lock {m_mutex};
+	while(!queue.empty()) {
+		auto path = std::move(queue.back());
+		queue.pop_back();
+		if(!dependents.insert(path).second)
+			continue;
+		auto it = m_includedBy.find(path);
+		if(it == m_includedBy.end())
+			continue;
+		for(auto &parent : it->second)
+			queue.push_back(parent);
+	}
+	return dependents;
+}
+
+void ShaderDependencyGraph::Clear()
+{
+	std::unique_lock lock {m_mutex};
+	m_includes.clear();
+	m_includedBy.clear();
+}
+
+///////////////////////////
+
+ShaderHotReloader::ShaderHotReloader(IPrContext &context) : m_context {context}
+{
+#ifdef __linux__
+	m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(m_inotifyFd == -1) {
+		m_context.Log("Failed to initialize inotify, shader files will not be watched!", pragma::util::LogSeverity::Warning);
+		return;
+	}
+	m_watcherThread = std::thread {[this]() { RunWatcher(); }};
+	pragma::util::set_thread_name(m_watcherThread, "prosper_shader_watcher");
+#endif
+}
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+	m_running = false;
+	if(m_watcherThread.joinable())
+		m_watcherThread.join();
+#ifdef __linux__
+	if(m_inotifyFd != -1)
+		close(m_inotifyFd);
+#endif
+}
+
+bool ShaderHotReloader::AddWatchDirectory(const std::string &absolutePath, const std::string &virtualRoot)
+{
+	auto virtualPath = virtualRoot;
+	if(!virtualPath.empty() && virtualPath.back() != '/')
+		virtualPath += '/';
+	if(!AddWatch(absolutePath, virtualPath))
+		return false;
+	// inotify does not watch sub-directories, so every directory needs its own watch
+	std::error_code ec;
+	auto rootPath = std::filesystem::path {absolutePath};
+	for(auto &entry : std::filesystem::recursive_directory_iterator {rootPath, ec}) {
+		if(!entry.is_directory(ec))
+			continue;
+		auto relPath = std::filesystem::relative(entry.path(), rootPath, ec).generic_string();
+		AddWatch(entry.path().string(), virtualPath + relPath + '/');
+	}
+	return true;
+}
+
+bool ShaderHotReloader::AddWatch(const std::string &absolutePath, const std::string &virtualPath)
+{
+#ifdef __linux__
+	if(m_inotifyFd == -1)
+		return false;
+	auto wd = inotify_add_watch(m_inotifyFd, absolutePath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if(wd == -1) {
+		m_context.Log("Failed to watch shader directory '" + absolutePath + "'!", pragma::util::LogSeverity::Warning);
+		return false;
+	}
+	auto dirPath = absolutePath;
+	if(!dirPath.empty() && dirPath.back() != '/')
+		dirPath += '/';
+	std::scoped_lock lock {m_watchMutex};
+	m_watchDirectories[wd] = {dirPath, virtualPath};
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ShaderHotReloader::RunWatcher()
+{
+#ifdef __linux__
+	alignas(inotify_event) std::array<char, 4096> buffer;
+	while(m_running) {
+		pollfd pfd {m_inotifyFd, POLLIN, 0};
+		// The timeout allows the thread to notice when the reloader is destroyed
+		if(poll(&pfd, 1, 100) <= 0)
+			continue;
+		auto len = read(m_inotifyFd, buffer.data(), buffer.size());
+		if(len <= 0)
+			continue;
+		for(auto *ptr = buffer.data(); ptr < buffer.data() + len;) {
+			auto *event = reinterpret_cast<const inotify_event *>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+			if(event->len == 0)
+				continue;
+			WatchDirectory dir;
+			{
+				std::scoped_lock lock {m_watchMutex};
+				auto it = m_watchDirectories.find(event->wd);
+				if(it == m_watchDirectories.end())
+					continue;
+				dir = it->second;
+			}
+			std::string name {event->name};
+			if(event->mask & IN_ISDIR) {
+				AddWatch(dir.absolutePath + name, dir.virtualPath + name + '/');
+				continue;
+			}
+			NotifyFileChanged(dir.virtualPath + name);
+		}
+	}
+#endif
+}
+
+void ShaderHotReloader::NotifyFileChanged(const std::string &filePath)
+{
+	std::scoped_lock lock {m_pendingChangesMutex};
+	m_pendingChanges.insert(ShaderDependencyGraph::NormalizePath(filePath));
+	m_lastChangeTime = std::chrono::steady_clock::now();
+}
+
+void ShaderHotReloader::Poll()
+{
+	// Shaders that have finished reloading replace their old pipelines here
+	m_context.GetPipelineLoader().Update();
+
+	std::unordered_set<std::string> changedFiles;
+	{
+		std::scoped_lock lock {m_pendingChangesMutex};
+		if(m_pendingChanges.empty() || std::chrono::steady_clock::now() - m_lastChangeTime < m_debounceDelay)
+			return;
+		changedFiles = std::move(m_pendingChanges);
+		m_pendingChanges.clear();
+	}
+	ReloadShaders(changedFiles);
+}
+
+void ShaderHotReloader::ReloadShaders(const std::unordered_set<std::string> &changedFiles)
+{
+	std::unordered_set<std::string> affectedFiles;
+	for(auto &filePath : changedFiles)
+		affectedFiles.merge(m_dependencyGraph.FindDependents(filePath));
+
+	std::vector<Shader *> shaders;
+	for(auto &shader : m_context.GetShaderManager().GetShaders()) {
+		if(!shader)
+			continue;
+		auto &stages = shader->GetStages();
+		for(auto i = decltype(stages.size()) {0u}; i < stages.size(); ++i) {
+			auto &stage = stages[i];
+			if(!stage || stage->path.empty())
+				continue;
+			auto filePath = glsl::find_shader_file(static_cast<ShaderStage>(i), "shaders/" + stage->path);
+			if(!filePath || !affectedFiles.contains(ShaderDependencyGraph::NormalizePath(*filePath)))
+				continue;
+			shaders.push_back(shader.get());
+			break;
+		}
+	}
+	if(shaders.empty())
+		return;
+	m_context.Log("Shader files have changed, reloading " + pragma::util::to_string(shaders.size()) + " shaders...", pragma::util::LogSeverity::Info);
+	// Included files may have changed
+	glsl::clear_global_include_file_cache();
+	for(auto *shader : shaders)
+		shader->HotReload();
+}
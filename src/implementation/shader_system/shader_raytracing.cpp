@@ -35,7 +35,7 @@ void prosper::ShaderRaytracing::InitializePipeline()
 		else if(m_basePipeline.expired() == false) {
 			assert(!GetContext().GetPipelineLoader().IsShaderQueued(m_basePipeline.lock()->GetIndex()));
 			// Base shader pipeline must have already been loaded (but not necessarily baked) at this point!
-			m_basePipeline.lock()->GetPipelineId(basePipelineId);
+			m_basePipeline.lock()->GetLoadedPipelineId(basePipelineId, 0u);
 		}
 
 		PipelineCreateFlags createFlags = PipelineCreateFlags::AllowDerivativesBit;
@@ -5,6 +5,7 @@ module;
 
 module pragma.prosper;
 
+import :descriptor_set_cache;
 import :shader_system.pipeline_create_info;
 import :shader_system.shaders.blur;
 
@@ -71,6 +72,42 @@ ShaderBlurV::~ShaderBlurV() { s_blurShaderV = nullptr; }
 
 /////////////////////////
 
+static bool record_blur_passes(IPrimaryCommandBuffer &cmdBuffer, const BlurSet &blurSet, const ShaderBlurBase::PushConstants &pushConstants, uint32_t blurStrength, ShaderBlurBase &shaderH, ShaderBlurBase::Pipeline pipelineIdH, ShaderBlurBase &shaderV,
+  ShaderBlurBase::Pipeline pipelineIdV)
+{
+	auto &stagingRt = *blurSet.GetStagingRenderTarget();
+	auto &stagingImg = stagingRt.GetTexture().GetImage();
+	auto &finalRt = *blurSet.GetFinalRenderTarget();
+	for(auto i = decltype(blurStrength) {0u}; i < blurStrength; ++i) {
+		cmdBuffer.RecordImageBarrier(stagingImg, ImageLayout::ShaderReadOnlyOptimal, ImageLayout::ColorAttachmentOptimal);
+		if(cmdBuffer.RecordBeginRenderPass(stagingRt) == false)
+			return false;
+		ShaderBindState bindState {cmdBuffer};
+		if(shaderH.RecordBeginDraw(bindState, pipelineIdH) == false) {
+			cmdBuffer.RecordEndRenderPass();
+			return false;
+		}
+		shaderH.RecordDraw(bindState, blurSet.GetFinalDescriptorSet(), pushConstants);
+		shaderH.RecordEndDraw(bindState);
+		cmdBuffer.RecordEndRenderPass();
+
+		cmdBuffer.RecordPostRenderPassImageBarrier(stagingImg, ImageLayout::ColorAttachmentOptimal, ImageLayout::ShaderReadOnlyOptimal);
+		cmdBuffer.RecordImageBarrier(finalRt.GetTexture().GetImage(), ImageLayout::ShaderReadOnlyOptimal, ImageLayout::ColorAttachmentOptimal);
+
+		if(cmdBuffer.RecordBeginRenderPass(finalRt) == false)
+			return false;
+		if(shaderV.RecordBeginDraw(bindState, pipelineIdV) == false)
+			return false;
+		shaderV.RecordDraw(bindState, blurSet.GetStagingDescriptorSet(), pushConstants);
+		shaderV.RecordEndDraw(bindState);
+		auto success = cmdBuffer.RecordEndRenderPass();
+		if(success == false)
+			return success;
+		cmdBuffer.RecordPostRenderPassImageBarrier(finalRt.GetTexture().GetImage(), ImageLayout::ColorAttachmentOptimal, ImageLayout::ShaderReadOnlyOptimal);
+	}
+	return true;
+}
+
 bool util::record_blur_image(IPrContext &context, const std::shared_ptr<IPrimaryCommandBuffer> &cmdBuffer, const BlurSet &blurSet, const ShaderBlurBase::PushConstants &pushConstants, uint32_t blurStrength, const ShaderInfo *shaderInfo)
 {
 	if(s_blurShaderH == nullptr || s_blurShaderV == nullptr)
@@ -118,35 +155,14 @@ bool util::record_blur_image(IPrContext &context, const std::shared_ptr<IPrimary
 		pipelineIdH = pipelineId;
 		pipelineIdV = pipelineId;
 	}
-	auto &finalRt = *blurSet.GetFinalRenderTarget();
-	for(auto i = decltype(blurStrength) {0u}; i < blurStrength; ++i) {
-		cmdBuffer->RecordImageBarrier(stagingImg, ImageLayout::ShaderReadOnlyOptimal, ImageLayout::ColorAttachmentOptimal);
-		if(cmdBuffer->RecordBeginRenderPass(stagingRt) == false)
-			return false;
-		ShaderBindState bindState {*cmdBuffer};
-		if(shaderH.RecordBeginDraw(bindState, pipelineIdH) == false) {
-			cmdBuffer->RecordEndRenderPass();
-			return false;
-		}
-		shaderH.RecordDraw(bindState, blurSet.GetFinalDescriptorSet(), pushConstants);
-		shaderH.RecordEndDraw(bindState);
-		cmdBuffer->RecordEndRenderPass();
-
-		cmdBuffer->RecordPostRenderPassImageBarrier(stagingImg, ImageLayout::ColorAttachmentOptimal, ImageLayout::ShaderReadOnlyOptimal);
-		cmdBuffer->RecordImageBarrier(finalRt.GetTexture().GetImage(), ImageLayout::ShaderReadOnlyOptimal, ImageLayout::ColorAttachmentOptimal);
-
-		if(cmdBuffer->RecordBeginRenderPass(finalRt) == false)
-			return false;
-		if(shaderV.RecordBeginDraw(bindState, pipelineIdV) == false)
-			return false;
-		shaderV.RecordDraw(bindState, blurSet.GetStagingDescriptorSet(), pushConstants);
-		shaderV.RecordEndDraw(bindState);
-		auto success = cmdBuffer->RecordEndRenderPass();
-		if(success == false)
-			return success;
-		cmdBuffer->RecordPostRenderPassImageBarrier(finalRt.GetTexture().GetImage(), ImageLayout::ColorAttachmentOptimal, ImageLayout::ShaderReadOnlyOptimal);
-	}
-	return true;
+	// Merges the post-render-pass barrier of one image with the pre-render-pass barrier of the other
+	auto batchBarriers = !cmdBuffer->IsBarrierBatchingEnabled();
+	if(batchBarriers)
+		cmdBuffer->SetBarrierBatchingEnabled(true);
+	auto success = record_blur_passes(*cmdBuffer, blurSet, pushConstants, blurStrength, shaderH, pipelineIdH, shaderV, pipelineIdV);
+	if(batchBarriers)
+		cmdBuffer->SetBarrierBatchingEnabled(false);
+	return success;
 }
 
 /////////////////////////
@@ -157,15 +173,28 @@ BlurSet::BlurSet(const std::shared_ptr<RenderTarget> &rtFinal, const std::shared
 {
 }
 
+static std::shared_ptr<IDescriptorSetGroup> create_texture_descriptor_set_group(IPrContext &context, Texture &tex)
+{
+	// Blur sets are frequently re-created, so their descriptor set groups are recycled through the cache where possible.
+	// They can't be shared with other blur sets though, since BlurSet hands out its descriptor sets as mutable.
+	auto *cache = context.GetDescriptorSetCache();
+	if(cache) {
+		static auto createInfo = ShaderBlurBase::DESCRIPTOR_SET_TEXTURE.ToProsperDescriptorSetInfo();
+		return cache->AcquireExclusive(*createInfo, DescriptorSetCache::Resources {}.SetTexture(0u, tex));
+	}
+	auto dsg = context.CreateDescriptorSetGroup(ShaderBlurBase::DESCRIPTOR_SET_TEXTURE);
+	dsg->GetDescriptorSet()->SetBindingTexture(tex, 0u);
+	return dsg;
+}
+
 std::shared_ptr<BlurSet> BlurSet::Create(IPrContext &context, const std::shared_ptr<RenderTarget> &finalRt, const std::shared_ptr<Texture> &srcTexture)
 {
 	if(s_blurShaderH == nullptr)
 		return nullptr;
 	auto &rp = finalRt->GetRenderPass();
-	auto finalDescSetGroup = context.CreateDescriptorSetGroup(ShaderBlurBase::DESCRIPTOR_SET_TEXTURE);
 	auto &finalTex = (srcTexture != nullptr) ? *srcTexture : finalRt->GetTexture();
 	auto &finalImg = finalTex.GetImage();
-	finalDescSetGroup->GetDescriptorSet()->SetBindingTexture(finalTex, 0u);
+	auto finalDescSetGroup = create_texture_descriptor_set_group(context, finalTex);
 
 	auto format = finalImg.GetFormat();
 	auto extents = finalImg.GetExtents();
@@ -186,9 +215,7 @@ std::shared_ptr<BlurSet> BlurSet::Create(IPrContext &context, const std::shared_
 	rtCreateInfo.debugName = "blur_staging_rt";
 	auto stagingRt = context.CreateRenderTarget({tex}, rp.shared_from_this(), rtCreateInfo);
 
-	auto stagingDescSetGroup = context.CreateDescriptorSetGroup(ShaderBlurBase::DESCRIPTOR_SET_TEXTURE);
-	auto &stagingTex = stagingRt->GetTexture();
-	stagingDescSetGroup->GetDescriptorSet()->SetBindingTexture(stagingTex, 0u);
+	auto stagingDescSetGroup = create_texture_descriptor_set_group(context, stagingRt->GetTexture());
 	return std::shared_ptr<BlurSet>(new BlurSet(finalRt, finalDescSetGroup, stagingRt, stagingDescSetGroup, finalTex.shared_from_this()));
 }
 
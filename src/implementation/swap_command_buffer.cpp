@@ -83,60 +83,124 @@ bool ISwapCommandBufferGroup::ExecuteCommands(IPrimaryCommandBuffer &cmdBuf)
 
 /////////////
 
-MtSwapCommandBufferGroup::MtSwapCommandBufferGroup(Window &window, const std::string &debugName) : ISwapCommandBufferGroup {window, debugName}
-{
-	m_thread = std::thread {[this]() {
-		while(!m_close) {
-			std::unique_lock<std::mutex> lock {m_waitMutex};
-			if(m_recordCalls.empty() && m_pending) {
-				m_pending = false;
-				m_conditionVar.notify_all();
-			}
-			m_conditionVar.wait(lock, [this] { return !m_recordCalls.empty() || m_close; });
-
-			if(m_close)
-				break;
-			if(!m_curCommandBuffer) {
-				while(!m_recordCalls.empty())
-					m_recordCalls.pop();
-			}
-			else {
-				auto drawCall = std::move(m_recordCalls.front());
-				m_recordCalls.pop();
-				lock.unlock();
-
-				drawCall(*m_curCommandBuffer);
-			}
+CommandRecordThreadPool::CommandRecordThreadPool(uint32_t numThreads)
+{
+	numThreads = pragma::math::max(numThreads, 1u);
+	m_threads.reserve(numThreads);
+	for(auto i = decltype(numThreads) {0u}; i < numThreads; ++i) {
+		m_threads.push_back(std::thread {[this]() { RunWorker(); }});
+		pragma::util::set_thread_name(m_threads.back(), "prosper_cmd_record_" + pragma::util::to_string(i));
+	}
+}
+
+CommandRecordThreadPool::~CommandRecordThreadPool()
+{
+	{
+		std::scoped_lock lock {m_mutex};
+		m_running = false;
+	}
+	m_taskAvailable.notify_all();
+	for(auto &thread : m_threads)
+		thread.join();
+}
+
+void CommandRecordThreadPool::Push(std::function<void()> &&task)
+{
+	{
+		std::scoped_lock lock {m_mutex};
+		m_tasks.push_back(std::move(task));
+	}
+	m_taskAvailable.notify_one();
+}
+
+void CommandRecordThreadPool::RunWorker()
+{
+	for(;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock lock {m_mutex};
+			m_taskAvailable.wait(lock, [this]() { return !m_tasks.empty() || !m_running; });
+			// Remaining tasks are still executed during shutdown, since groups may be waiting for them
+			if(m_tasks.empty())
+				return;
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
 		}
-	}};
-	pragma::util::set_thread_name(m_thread, debugName);
+		task();
+	}
 }
 
+/////////////
+
+MtSwapCommandBufferGroup::MtSwapCommandBufferGroup(Window &window, const std::string &debugName) : ISwapCommandBufferGroup {window, debugName} {}
+
 MtSwapCommandBufferGroup::~MtSwapCommandBufferGroup()
 {
-	m_close = true;
-	m_waitMutex.lock();
-	m_conditionVar.notify_one();
-	m_waitMutex.unlock();
-	m_thread.join();
+	// The scheduled task references this group, it has to be finished entirely, not just its record calls
+	std::unique_lock<std::mutex> lock {m_waitMutex};
+	m_conditionVar.wait(lock, [this] { return m_numPendingCalls == 0 && !m_scheduled; });
 }
 
 void MtSwapCommandBufferGroup::Record(const RenderThreadRecordCall &record)
 {
-	m_waitMutex.lock();
-
-	m_pending = true;
-	m_recordCalls.push(record);
-	m_conditionVar.notify_one();
-	m_waitMutex.unlock();
-	if(GetContext().IsMultiThreadedRenderingEnabled() == false)
+	auto &context = GetContext();
+	auto *pool = context.GetCommandRecordThreadPool();
+	auto schedule = false;
+	{
+		std::scoped_lock lock {m_waitMutex};
+		m_pending = true;
+		m_recordCalls.push(record);
+		++m_numPendingCalls;
+		if(!m_scheduled) {
+			m_scheduled = true;
+			schedule = true;
+		}
+	}
+	if(schedule) {
+		if(pool)
+			pool->Push([this]() { RunRecordCalls(); });
+		else
+			RunRecordCalls();
+	}
+	if(context.IsMultiThreadedRenderingEnabled() == false)
 		Wait();
 }
 
+void MtSwapCommandBufferGroup::RunRecordCalls()
+{
+	RenderThreadRecordCall drawCall;
+	{
+		std::scoped_lock lock {m_waitMutex};
+		if(m_recordCalls.empty()) {
+			m_scheduled = false;
+			return;
+		}
+		drawCall = std::move(m_recordCalls.front());
+		m_recordCalls.pop();
+	}
+	for(;;) {
+		if(m_curCommandBuffer)
+			drawCall(*m_curCommandBuffer);
+
+		// Completing the call and taking the next one has to happen in the same critical section. Once the last call has been completed,
+		// the group may be destroyed (see ~MtSwapCommandBufferGroup) as soon as the lock has been released, so no members may be accessed afterwards.
+		std::scoped_lock lock {m_waitMutex};
+		--m_numPendingCalls;
+		if(m_recordCalls.empty()) {
+			m_scheduled = false;
+			m_pending = false;
+			m_conditionVar.notify_all();
+			return;
+		}
+		drawCall = std::move(m_recordCalls.front());
+		m_recordCalls.pop();
+	}
+}
+
 void MtSwapCommandBufferGroup::Wait()
 {
 	std::unique_lock<std::mutex> lock {m_waitMutex};
-	m_conditionVar.wait(lock, [this] { return !m_pending; });
+	m_conditionVar.wait(lock, [this] { return m_numPendingCalls == 0; });
 }
 
 /////////////
@@ -5,6 +5,7 @@ module;
 
 module pragma.prosper;
 
+import :buffer.image_readback;
 import :gli;
 import :util;
 
@@ -1162,506 +1163,25 @@ void prosper::util::to_string(const ImageCreateInfo &createInfo, std::stringstre
 	out << "memoryFeatures: " << magic_enum::enum_flags_name(createInfo.memoryFeatures) << "\n";
 }
 
-bool prosper::util::has_alpha(Format format)
-{
-	switch(format) {
-	case Format::BC1_RGBA_UNorm_Block:
-	case Format::BC1_RGBA_SRGB_Block:
-	case Format::BC2_UNorm_Block:
-	case Format::BC2_SRGB_Block:
-	case Format::BC3_UNorm_Block:
-	case Format::BC3_SRGB_Block:
-	case Format::ETC2_R8G8B8A1_UNorm_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A1_SRGB_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A8_UNorm_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A8_SRGB_Block_PoorCoverage:
-	case Format::R4G4B4A4_UNorm_Pack16:
-	case Format::B4G4R4A4_UNorm_Pack16:
-	case Format::R5G5B5A1_UNorm_Pack16:
-	case Format::B5G5R5A1_UNorm_Pack16:
-	case Format::A1R5G5B5_UNorm_Pack16:
-	case Format::R8G8B8A8_UNorm:
-	case Format::R8G8B8A8_SNorm:
-	case Format::R8G8B8A8_UScaled_PoorCoverage:
-	case Format::R8G8B8A8_SScaled_PoorCoverage:
-	case Format::R8G8B8A8_UInt:
-	case Format::R8G8B8A8_SInt:
-	case Format::R8G8B8A8_SRGB:
-	case Format::B8G8R8A8_UNorm:
-	case Format::B8G8R8A8_SNorm:
-	case Format::B8G8R8A8_UScaled_PoorCoverage:
-	case Format::B8G8R8A8_SScaled_PoorCoverage:
-	case Format::B8G8R8A8_UInt:
-	case Format::B8G8R8A8_SInt:
-	case Format::B8G8R8A8_SRGB:
-	case Format::A8B8G8R8_UNorm_Pack32:
-	case Format::A8B8G8R8_SNorm_Pack32:
-	case Format::A8B8G8R8_UScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_SScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_UInt_Pack32:
-	case Format::A8B8G8R8_SInt_Pack32:
-	case Format::A8B8G8R8_SRGB_Pack32:
-	case Format::A2R10G10B10_UNorm_Pack32:
-	case Format::A2R10G10B10_SNorm_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_UScaled_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_SScaled_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_UInt_Pack32:
-	case Format::A2R10G10B10_SInt_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UNorm_Pack32:
-	case Format::A2B10G10R10_SNorm_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UScaled_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_SScaled_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UInt_Pack32:
-	case Format::A2B10G10R10_SInt_Pack32_PoorCoverage:
-	case Format::R16G16B16A16_UNorm:
-	case Format::R16G16B16A16_SNorm:
-	case Format::R16G16B16A16_UScaled_PoorCoverage:
-	case Format::R16G16B16A16_SScaled_PoorCoverage:
-	case Format::R16G16B16A16_UInt:
-	case Format::R16G16B16A16_SInt:
-	case Format::R16G16B16A16_SFloat:
-	case Format::R32G32B32A32_UInt:
-	case Format::R32G32B32A32_SInt:
-	case Format::R32G32B32A32_SFloat:
-	case Format::R64G64B64A64_UInt_PoorCoverage:
-	case Format::R64G64B64A64_SInt_PoorCoverage:
-	case Format::R64G64B64A64_SFloat_PoorCoverage:
-	case Format::BC7_UNorm_Block:
-	case Format::BC7_SRGB_Block:
-	case Format::ASTC_4x4_UNorm_Block_PoorCoverage:
-	case Format::ASTC_4x4_SRGB_Block_PoorCoverage:
-	case Format::ASTC_5x4_UNorm_Block_PoorCoverage:
-	case Format::ASTC_5x4_SRGB_Block_PoorCoverage:
-	case Format::ASTC_5x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_5x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_6x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_6x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_6x6_UNorm_Block_PoorCoverage:
-	case Format::ASTC_6x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_8x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x6_UNorm_Block_PoorCoverage:
-	case Format::ASTC_8x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x8_UNorm_Block_PoorCoverage:
-	case Format::ASTC_8x8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x6_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x8_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x10_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x10_SRGB_Block_PoorCoverage:
-	case Format::ASTC_12x10_UNorm_Block_PoorCoverage:
-	case Format::ASTC_12x10_SRGB_Block_PoorCoverage:
-	case Format::ASTC_12x12_UNorm_Block_PoorCoverage:
-	case Format::ASTC_12x12_SRGB_Block_PoorCoverage:
-		return true;
-	}
-	return false;
-}
-
-bool prosper::util::is_depth_format(Format format)
-{
-	switch(format) {
-	case Format::D16_UNorm:
-	case Format::D16_UNorm_S8_UInt_PoorCoverage:
-	case Format::D24_UNorm_S8_UInt_PoorCoverage:
-	case Format::D32_SFloat:
-	case Format::D32_SFloat_S8_UInt:
-	case Format::X8_D24_UNorm_Pack32_PoorCoverage:
-		return true;
-	};
-	return false;
-}
-
-bool prosper::util::is_compressed_format(Format format)
-{
-	switch(format) {
-	case Format::BC1_RGB_UNorm_Block:
-	case Format::BC1_RGB_SRGB_Block:
-	case Format::BC1_RGBA_UNorm_Block:
-	case Format::BC1_RGBA_SRGB_Block:
-	case Format::BC2_UNorm_Block:
-	case Format::BC2_SRGB_Block:
-	case Format::BC3_UNorm_Block:
-	case Format::BC3_SRGB_Block:
-	case Format::BC4_UNorm_Block:
-	case Format::BC4_SNorm_Block:
-	case Format::BC5_UNorm_Block:
-	case Format::BC5_SNorm_Block:
-	case Format::BC6H_UFloat_Block:
-	case Format::BC6H_SFloat_Block:
-	case Format::BC7_UNorm_Block:
-	case Format::BC7_SRGB_Block:
-	case Format::ETC2_R8G8B8_UNorm_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8_SRGB_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A1_UNorm_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A1_SRGB_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A8_UNorm_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A8_SRGB_Block_PoorCoverage:
-	case Format::EAC_R11_UNorm_Block_PoorCoverage:
-	case Format::EAC_R11_SNorm_Block_PoorCoverage:
-	case Format::EAC_R11G11_UNorm_Block_PoorCoverage:
-	case Format::EAC_R11G11_SNorm_Block_PoorCoverage:
-	case Format::ASTC_4x4_UNorm_Block_PoorCoverage:
-	case Format::ASTC_4x4_SRGB_Block_PoorCoverage:
-	case Format::ASTC_5x4_UNorm_Block_PoorCoverage:
-	case Format::ASTC_5x4_SRGB_Block_PoorCoverage:
-	case Format::ASTC_5x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_5x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_6x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_6x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_6x6_UNorm_Block_PoorCoverage:
-	case Format::ASTC_6x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_8x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x6_UNorm_Block_PoorCoverage:
-	case Format::ASTC_8x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x8_UNorm_Block_PoorCoverage:
-	case Format::ASTC_8x8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x5_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x6_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x8_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x10_UNorm_Block_PoorCoverage:
-	case Format::ASTC_10x10_SRGB_Block_PoorCoverage:
-	case Format::ASTC_12x10_UNorm_Block_PoorCoverage:
-	case Format::ASTC_12x10_SRGB_Block_PoorCoverage:
-	case Format::ASTC_12x12_UNorm_Block_PoorCoverage:
-	case Format::ASTC_12x12_SRGB_Block_PoorCoverage:
-		return true;
-	};
-	return false;
-}
-bool prosper::util::is_uncompressed_format(Format format)
-{
-	if(format == Format::Unknown)
-		return false;
-	return !is_compressed_format(format);
-}
-
-uint32_t prosper::util::get_bit_size(Format format)
-{
-	switch(format) {
-	// Sub-Byte formats
-	case Format::Unknown:
-		return 0;
-	case Format::R4G4_UNorm_Pack8:
-		return 8;
-	case Format::R4G4B4A4_UNorm_Pack16:
-	case Format::B4G4R4A4_UNorm_Pack16:
-	case Format::R5G6B5_UNorm_Pack16:
-	case Format::B5G6R5_UNorm_Pack16:
-	case Format::R5G5B5A1_UNorm_Pack16:
-	case Format::B5G5R5A1_UNorm_Pack16:
-	case Format::A1R5G5B5_UNorm_Pack16:
-		return 16;
-	//
-	case Format::R8_UNorm:
-	case Format::R8_SNorm:
-	case Format::R8_UScaled_PoorCoverage:
-	case Format::R8_SScaled_PoorCoverage:
-	case Format::R8_UInt:
-	case Format::R8_SInt:
-	case Format::R8_SRGB:
-		return 8;
-	case Format::R8G8_UNorm:
-	case Format::R8G8_SNorm:
-	case Format::R8G8_UScaled_PoorCoverage:
-	case Format::R8G8_SScaled_PoorCoverage:
-	case Format::R8G8_UInt:
-	case Format::R8G8_SInt:
-	case Format::R8G8_SRGB_PoorCoverage:
-		return 16;
-	case Format::R8G8B8_UNorm_PoorCoverage:
-	case Format::R8G8B8_SNorm_PoorCoverage:
-	case Format::R8G8B8_UScaled_PoorCoverage:
-	case Format::R8G8B8_SScaled_PoorCoverage:
-	case Format::R8G8B8_UInt_PoorCoverage:
-	case Format::R8G8B8_SInt_PoorCoverage:
-	case Format::R8G8B8_SRGB_PoorCoverage:
-	case Format::B8G8R8_UNorm_PoorCoverage:
-	case Format::B8G8R8_SNorm_PoorCoverage:
-	case Format::B8G8R8_UScaled_PoorCoverage:
-	case Format::B8G8R8_SScaled_PoorCoverage:
-	case Format::B8G8R8_UInt_PoorCoverage:
-	case Format::B8G8R8_SInt_PoorCoverage:
-	case Format::B8G8R8_SRGB_PoorCoverage:
-		return 24;
-	case Format::R8G8B8A8_UNorm:
-	case Format::R8G8B8A8_SNorm:
-	case Format::R8G8B8A8_UScaled_PoorCoverage:
-	case Format::R8G8B8A8_SScaled_PoorCoverage:
-	case Format::R8G8B8A8_UInt:
-	case Format::R8G8B8A8_SInt:
-	case Format::R8G8B8A8_SRGB:
-	case Format::B8G8R8A8_UNorm:
-	case Format::B8G8R8A8_SNorm:
-	case Format::B8G8R8A8_UScaled_PoorCoverage:
-	case Format::B8G8R8A8_SScaled_PoorCoverage:
-	case Format::B8G8R8A8_UInt:
-	case Format::B8G8R8A8_SInt:
-	case Format::B8G8R8A8_SRGB:
-	case Format::A8B8G8R8_UNorm_Pack32:
-	case Format::A8B8G8R8_SNorm_Pack32:
-	case Format::A8B8G8R8_UScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_SScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_UInt_Pack32:
-	case Format::A8B8G8R8_SInt_Pack32:
-	case Format::A8B8G8R8_SRGB_Pack32:
-		return 32;
-	case Format::A2R10G10B10_UNorm_Pack32:
-	case Format::A2R10G10B10_SNorm_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_UScaled_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_SScaled_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_UInt_Pack32:
-	case Format::A2R10G10B10_SInt_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UNorm_Pack32:
-	case Format::A2B10G10R10_SNorm_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UScaled_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_SScaled_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UInt_Pack32:
-	case Format::A2B10G10R10_SInt_Pack32_PoorCoverage:
-		return 32;
-	case Format::R16_UNorm:
-	case Format::R16_SNorm:
-	case Format::R16_UScaled_PoorCoverage:
-	case Format::R16_SScaled_PoorCoverage:
-	case Format::R16_UInt:
-	case Format::R16_SInt:
-	case Format::R16_SFloat:
-		return 16;
-	case Format::R16G16_UNorm:
-	case Format::R16G16_SNorm:
-	case Format::R16G16_UScaled_PoorCoverage:
-	case Format::R16G16_SScaled_PoorCoverage:
-	case Format::R16G16_UInt:
-	case Format::R16G16_SInt:
-	case Format::R16G16_SFloat:
-		return 32;
-	case Format::R16G16B16_UNorm_PoorCoverage:
-	case Format::R16G16B16_SNorm_PoorCoverage:
-	case Format::R16G16B16_UScaled_PoorCoverage:
-	case Format::R16G16B16_SScaled_PoorCoverage:
-	case Format::R16G16B16_UInt_PoorCoverage:
-	case Format::R16G16B16_SInt_PoorCoverage:
-	case Format::R16G16B16_SFloat_PoorCoverage:
-		return 48;
-	case Format::R16G16B16A16_UNorm:
-	case Format::R16G16B16A16_SNorm:
-	case Format::R16G16B16A16_UScaled_PoorCoverage:
-	case Format::R16G16B16A16_SScaled_PoorCoverage:
-	case Format::R16G16B16A16_UInt:
-	case Format::R16G16B16A16_SInt:
-	case Format::R16G16B16A16_SFloat:
-		return 64;
-	case Format::R32_UInt:
-	case Format::R32_SInt:
-	case Format::R32_SFloat:
-		return 32;
-	case Format::R32G32_UInt:
-	case Format::R32G32_SInt:
-	case Format::R32G32_SFloat:
-		return 64;
-	case Format::R32G32B32_UInt:
-	case Format::R32G32B32_SInt:
-	case Format::R32G32B32_SFloat:
-		return 96;
-	case Format::R32G32B32A32_UInt:
-	case Format::R32G32B32A32_SInt:
-	case Format::R32G32B32A32_SFloat:
-		return 128;
-	case Format::R64_UInt_PoorCoverage:
-	case Format::R64_SInt_PoorCoverage:
-	case Format::R64_SFloat_PoorCoverage:
-		return 64;
-	case Format::R64G64_UInt_PoorCoverage:
-	case Format::R64G64_SInt_PoorCoverage:
-	case Format::R64G64_SFloat_PoorCoverage:
-		return 128;
-	case Format::R64G64B64_UInt_PoorCoverage:
-	case Format::R64G64B64_SInt_PoorCoverage:
-	case Format::R64G64B64_SFloat_PoorCoverage:
-		return 192;
-	case Format::R64G64B64A64_UInt_PoorCoverage:
-	case Format::R64G64B64A64_SInt_PoorCoverage:
-	case Format::R64G64B64A64_SFloat_PoorCoverage:
-		return 256;
-	case Format::B10G11R11_UFloat_Pack32:
-	case Format::E5B9G9R9_UFloat_Pack32:
-		return 32;
-	case Format::D16_UNorm:
-		return 16;
-	case Format::X8_D24_UNorm_Pack32_PoorCoverage:
-		return 32;
-	case Format::D32_SFloat:
-		return 32;
-	case Format::S8_UInt_PoorCoverage:
-		return 8;
-	case Format::D16_UNorm_S8_UInt_PoorCoverage:
-		return 16;
-	case Format::D24_UNorm_S8_UInt_PoorCoverage:
-		return 24;
-	case Format::D32_SFloat_S8_UInt:
-		return 32;
-	};
-	return 0;
-}
-
-bool prosper::util::is_8bit_format(Format format)
-{
-	switch(format) {
-	case Format::R8_UNorm:
-	case Format::R8_SNorm:
-	case Format::R8_UScaled_PoorCoverage:
-	case Format::R8_SScaled_PoorCoverage:
-	case Format::R8_UInt:
-	case Format::R8_SInt:
-	case Format::R8_SRGB:
-	case Format::R8G8_UNorm:
-	case Format::R8G8_SNorm:
-	case Format::R8G8_UScaled_PoorCoverage:
-	case Format::R8G8_SScaled_PoorCoverage:
-	case Format::R8G8_UInt:
-	case Format::R8G8_SInt:
-	case Format::R8G8_SRGB_PoorCoverage:
-	case Format::R8G8B8_UNorm_PoorCoverage:
-	case Format::R8G8B8_SNorm_PoorCoverage:
-	case Format::R8G8B8_UScaled_PoorCoverage:
-	case Format::R8G8B8_SScaled_PoorCoverage:
-	case Format::R8G8B8_UInt_PoorCoverage:
-	case Format::R8G8B8_SInt_PoorCoverage:
-	case Format::R8G8B8_SRGB_PoorCoverage:
-	case Format::B8G8R8_UNorm_PoorCoverage:
-	case Format::B8G8R8_SNorm_PoorCoverage:
-	case Format::B8G8R8_UScaled_PoorCoverage:
-	case Format::B8G8R8_SScaled_PoorCoverage:
-	case Format::B8G8R8_UInt_PoorCoverage:
-	case Format::B8G8R8_SInt_PoorCoverage:
-	case Format::B8G8R8_SRGB_PoorCoverage:
-	case Format::R8G8B8A8_UNorm:
-	case Format::R8G8B8A8_SNorm:
-	case Format::R8G8B8A8_UScaled_PoorCoverage:
-	case Format::R8G8B8A8_SScaled_PoorCoverage:
-	case Format::R8G8B8A8_UInt:
-	case Format::R8G8B8A8_SInt:
-	case Format::R8G8B8A8_SRGB:
-	case Format::B8G8R8A8_UNorm:
-	case Format::B8G8R8A8_SNorm:
-	case Format::B8G8R8A8_UScaled_PoorCoverage:
-	case Format::B8G8R8A8_SScaled_PoorCoverage:
-	case Format::B8G8R8A8_UInt:
-	case Format::B8G8R8A8_SInt:
-	case Format::B8G8R8A8_SRGB:
-	case Format::A8B8G8R8_UNorm_Pack32:
-	case Format::A8B8G8R8_SNorm_Pack32:
-	case Format::A8B8G8R8_UScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_SScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_UInt_Pack32:
-	case Format::A8B8G8R8_SInt_Pack32:
-	case Format::A8B8G8R8_SRGB_Pack32:
-	case Format::S8_UInt_PoorCoverage:
-		return true;
-	};
-	return false;
-}
-bool prosper::util::is_16bit_format(Format format)
-{
-	switch(format) {
-	case Format::R16_UNorm:
-	case Format::R16_SNorm:
-	case Format::R16_UScaled_PoorCoverage:
-	case Format::R16_SScaled_PoorCoverage:
-	case Format::R16_UInt:
-	case Format::R16_SInt:
-	case Format::R16_SFloat:
-	case Format::R16G16_UNorm:
-	case Format::R16G16_SNorm:
-	case Format::R16G16_UScaled_PoorCoverage:
-	case Format::R16G16_SScaled_PoorCoverage:
-	case Format::R16G16_UInt:
-	case Format::R16G16_SInt:
-	case Format::R16G16_SFloat:
-	case Format::R16G16B16_UNorm_PoorCoverage:
-	case Format::R16G16B16_SNorm_PoorCoverage:
-	case Format::R16G16B16_UScaled_PoorCoverage:
-	case Format::R16G16B16_SScaled_PoorCoverage:
-	case Format::R16G16B16_UInt_PoorCoverage:
-	case Format::R16G16B16_SInt_PoorCoverage:
-	case Format::R16G16B16_SFloat_PoorCoverage:
-	case Format::R16G16B16A16_UNorm:
-	case Format::R16G16B16A16_SNorm:
-	case Format::R16G16B16A16_UScaled_PoorCoverage:
-	case Format::R16G16B16A16_SScaled_PoorCoverage:
-	case Format::R16G16B16A16_UInt:
-	case Format::R16G16B16A16_SInt:
-	case Format::R16G16B16A16_SFloat:
-	case Format::D16_UNorm:
-	case Format::D16_UNorm_S8_UInt_PoorCoverage:
-		return true;
-	};
-	return false;
-}
-bool prosper::util::is_32bit_format(Format format)
-{
-	switch(format) {
-	case Format::R16_UNorm:
-	case Format::R16_SNorm:
-	case Format::R16_UScaled_PoorCoverage:
-	case Format::R16_SScaled_PoorCoverage:
-	case Format::R16_UInt:
-	case Format::R16_SInt:
-	case Format::R16_SFloat:
-	case Format::R16G16_UNorm:
-	case Format::R16G16_SNorm:
-	case Format::R16G16_UScaled_PoorCoverage:
-	case Format::R16G16_SScaled_PoorCoverage:
-	case Format::R16G16_UInt:
-	case Format::R16G16_SInt:
-	case Format::R16G16_SFloat:
-	case Format::R16G16B16_UNorm_PoorCoverage:
-	case Format::R16G16B16_SNorm_PoorCoverage:
-	case Format::R16G16B16_UScaled_PoorCoverage:
-	case Format::R16G16B16_SScaled_PoorCoverage:
-	case Format::R16G16B16_UInt_PoorCoverage:
-	case Format::R16G16B16_SInt_PoorCoverage:
-	case Format::R16G16B16_SFloat_PoorCoverage:
-	case Format::R16G16B16A16_UNorm:
-	case Format::R16G16B16A16_SNorm:
-	case Format::R16G16B16A16_UScaled_PoorCoverage:
-	case Format::R16G16B16A16_SScaled_PoorCoverage:
-	case Format::R16G16B16A16_UInt:
-	case Format::R16G16B16A16_SInt:
-	case Format::R16G16B16A16_SFloat:
-	case Format::D16_UNorm:
-	case Format::D16_UNorm_S8_UInt_PoorCoverage:
-		return true;
-	};
-	return false;
-}
-bool prosper::util::is_64bit_format(Format format)
+bool prosper::util::has_alpha(Format format) { return get_format_info(format).hasAlpha; }
+
+bool prosper::util::is_depth_format(Format format) { return get_format_info(format).HasDepth(); }
+
+bool prosper::util::is_compressed_format(Format format) { return get_format_info(format).IsCompressed(); }
+bool prosper::util::is_uncompressed_format(Format format)
 {
-	switch(format) {
-	case Format::R64_UInt_PoorCoverage:
-	case Format::R64_SInt_PoorCoverage:
-	case Format::R64_SFloat_PoorCoverage:
-	case Format::R64G64_UInt_PoorCoverage:
-	case Format::R64G64_SInt_PoorCoverage:
-	case Format::R64G64_SFloat_PoorCoverage:
-	case Format::R64G64B64_UInt_PoorCoverage:
-	case Format::R64G64B64_SInt_PoorCoverage:
-	case Format::R64G64B64_SFloat_PoorCoverage:
-	case Format::R64G64B64A64_UInt_PoorCoverage:
-	case Format::R64G64B64A64_SInt_PoorCoverage:
-	case Format::R64G64B64A64_SFloat_PoorCoverage:
-		return true;
-	};
-	return false;
+	if(format == Format::Unknown)
+		return false;
+	return !is_compressed_format(format);
 }
 
+uint32_t prosper::util::get_bit_size(Format format) { return get_format_info(format).bitSize; }
+
+bool prosper::util::is_8bit_format(Format format) { return get_format_info(format).componentBits == 8; }
+bool prosper::util::is_16bit_format(Format format) { return get_format_info(format).componentBits == 16; }
+bool prosper::util::is_32bit_format(Format format) { return get_format_info(format).componentBits == 32; }
+bool prosper::util::is_64bit_format(Format format) { return get_format_info(format).componentBits == 64; }
+
 uint32_t prosper::util::get_byte_size(Format format)
 {
 	auto numBits = get_bit_size(format);
@@ -1672,7 +1192,11 @@ uint32_t prosper::util::get_byte_size(Format format)
 
 uint32_t prosper::util::get_block_size(Format format) { return gli_wrapper::get_block_size(format); }
 
-uint32_t prosper::util::get_pixel_size(Format format) { return is_compressed_format(format) ? get_block_size(format) : get_byte_size(format); }
+uint32_t prosper::util::get_pixel_size(Format format)
+{
+	auto &info = get_format_info(format);
+	return info.IsCompressed() ? info.blockSize : get_byte_size(format);
+}
 
 uint32_t prosper::util::get_component_count(Format format) { return gli_wrapper::get_component_count(format); }
 
@@ -2460,6 +1984,96 @@ std::function<const uint8_t *(uint32_t, uint32_t, std::function<void(void)> &)>
 		return static_cast<uint8_t *>(data);
 	};
 }
+void prosper::util::image_to_data_async(IImage &image, const std::optional<Format> &dstFormat, const std::function<void(std::function<const uint8_t *(uint32_t, uint32_t, std::function<void(void)> &)>)> &callback, ImageLayout curImgLayout)
+{
+	auto &context = image.GetContext();
+	auto *readback = context.GetImageReadback();
+	if(!readback) {
+		callback(nullptr);
+		return;
+	}
+	// Same conversion rules as image_to_data
+	auto readFormat = image.GetFormat();
+	if(dstFormat.has_value() && *dstFormat != readFormat) {
+		if(!is_compressed_format(readFormat))
+			readFormat = *dstFormat;
+		else if(!is_compatible(readFormat, *dstFormat))
+			readFormat = Format::R32G32B32A32_SFloat;
+	}
+	auto extents = image.GetExtents();
+	auto numLayers = image.GetLayerCount();
+	auto numLevels = image.GetMipmapCount();
+	auto gliTex = std::make_shared<std::vector<gli_wrapper::GliTextureWrapper>>();
+	gliTex->reserve(numLayers);
+	for(auto i = decltype(numLayers) {0u}; i < numLayers; ++i)
+		gliTex->push_back(gli_wrapper::GliTextureWrapper {extents.width, extents.height, readFormat, numLevels});
+
+	auto img = image.shared_from_this();
+	// The converted image is created when the readback is recorded and has to stay alive until it has completed
+	auto convertedImg = std::make_shared<std::shared_ptr<IImage>>();
+	ImageReadback::Request request {};
+	request.size = gliTex->front().size() * gliTex->size();
+	request.record = [img, convertedImg, gliTex, readFormat, curImgLayout](ICommandBuffer &cmd, IBuffer &buf) -> bool {
+		auto *imgRead = img.get();
+		cmd.RecordImageBarrier(*img, curImgLayout, ImageLayout::TransferSrcOptimal);
+		if(readFormat != img->GetFormat()) {
+			auto copyCreateInfo = img->GetCreateInfo();
+			copyCreateInfo.format = readFormat;
+			copyCreateInfo.memoryFeatures = MemoryFeatureFlags::DeviceLocal;
+			copyCreateInfo.postCreateLayout = ImageLayout::TransferDstOptimal;
+			copyCreateInfo.tiling = ImageTiling::Optimal; // Needs to be in optimal tiling because some GPUs do not support linear tiling with mipmaps
+			*convertedImg = img->Copy(cmd, copyCreateInfo);
+			cmd.RecordImageBarrier(*img, ImageLayout::TransferSrcOptimal, curImgLayout);
+			if(!*convertedImg)
+				return false;
+			imgRead = convertedImg->get();
+			cmd.RecordImageBarrier(*imgRead, ImageLayout::TransferDstOptimal, ImageLayout::TransferSrcOptimal);
+		}
+		size_t bufferOffset = 0;
+		auto numLayers = imgRead->GetLayerCount();
+		auto numLevels = imgRead->GetMipmapCount();
+		for(auto iLayer = decltype(numLayers) {0u}; iLayer < numLayers; ++iLayer) {
+			for(auto iMipmap = decltype(numLevels) {0u}; iMipmap < numLevels; ++iMipmap) {
+				auto extents = imgRead->GetExtents(iMipmap);
+				BufferImageCopyInfo copyInfo {};
+				copyInfo.baseArrayLayer = iLayer;
+				copyInfo.bufferOffset = bufferOffset;
+				copyInfo.dstImageLayout = ImageLayout::TransferSrcOptimal;
+				copyInfo.imageExtent = {extents.width, extents.height};
+				copyInfo.layerCount = 1;
+				copyInfo.mipLevel = iMipmap;
+				if(!cmd.RecordCopyImageToBuffer(copyInfo, *imgRead, ImageLayout::TransferSrcOptimal, buf))
+					return false;
+				bufferOffset += (*gliTex)[iLayer].size(iMipmap);
+			}
+		}
+		if(imgRead == img.get())
+			cmd.RecordImageBarrier(*img, ImageLayout::TransferSrcOptimal, curImgLayout);
+		return true;
+	};
+	request.onComplete = [gliTex, convertedImg, numLayers, numLevels, callback](IBuffer *buf) {
+		if(!buf) {
+			callback(nullptr);
+			return;
+		}
+		size_t bufferOffset = 0;
+		for(auto iLayer = decltype(numLayers) {0u}; iLayer < numLayers; ++iLayer) {
+			for(auto iMipmap = decltype(numLevels) {0u}; iMipmap < numLevels; ++iMipmap) {
+				auto mipmapSize = (*gliTex)[iLayer].size(iMipmap);
+				if(!buf->Read(bufferOffset, mipmapSize, (*gliTex)[iLayer].data(0u, 0u /* face */, iMipmap))) {
+					callback(nullptr);
+					return;
+				}
+				bufferOffset += mipmapSize;
+			}
+		}
+		callback([gliTex](uint32_t iLayer, uint32_t iMipmap, std::function<void(void)> &outDeleter) -> const uint8_t * {
+			outDeleter = nullptr;
+			return static_cast<const uint8_t *>((*gliTex)[iLayer].data(0u, 0u /* face */, iMipmap));
+		});
+	};
+	readback->Enqueue(std::move(request));
+}
 bool prosper::util::compress_image(IImage &image, const pragma::image::TextureInfo &texInfo, const pragma::image::TextureOutputHandler &outputHandler, const std::function<void(const std::string &)> &errorHandler)
 {
 	auto extents = image.GetExtents();
@@ -2491,78 +2105,9 @@ bool prosper::util::compress_image(IImage &image, const pragma::image::TextureIn
 	return pragma::image::compress_texture(outputData, util::image_to_data(image, dstFormat), saveInfo, errorHandler);
 }
 
-bool prosper::util::is_packed_format(Format format)
-{
-	switch(format) {
-	case Format::R4G4_UNorm_Pack8:
-	case Format::R4G4B4A4_UNorm_Pack16:
-	case Format::R5G5B5A1_UNorm_Pack16:
-	case Format::R5G6B5_UNorm_Pack16:
-	case Format::B5G6R5_UNorm_Pack16:
-	case Format::B4G4R4A4_UNorm_Pack16:
-	case Format::B5G5R5A1_UNorm_Pack16:
-	case Format::B10G11R11_UFloat_Pack32:
-	case Format::A1R5G5B5_UNorm_Pack16:
-	case Format::A2R10G10B10_UNorm_Pack32:
-	case Format::A2R10G10B10_SNorm_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_UScaled_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_SScaled_Pack32_PoorCoverage:
-	case Format::A2R10G10B10_UInt_Pack32:
-	case Format::A2R10G10B10_SInt_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_UNorm_Pack32:
-	case Format::A8B8G8R8_SNorm_Pack32:
-	case Format::A8B8G8R8_UScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_SScaled_Pack32_PoorCoverage:
-	case Format::A8B8G8R8_UInt_Pack32:
-	case Format::A8B8G8R8_SInt_Pack32:
-	case Format::A8B8G8R8_SRGB_Pack32:
-	case Format::A2B10G10R10_UNorm_Pack32:
-	case Format::A2B10G10R10_SNorm_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UScaled_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_SScaled_Pack32_PoorCoverage:
-	case Format::A2B10G10R10_UInt_Pack32:
-	case Format::A2B10G10R10_SInt_Pack32_PoorCoverage:
-		return true;
-	}
-	return false;
-}
+bool prosper::util::is_packed_format(Format format) { return get_format_info(format).packed; }
 
-bool prosper::util::is_srgb_format(Format format)
-{
-	switch(format) {
-	case Format::R8_SRGB:
-	case Format::R8G8_SRGB_PoorCoverage:
-	case Format::R8G8B8_SRGB_PoorCoverage:
-	case Format::B8G8R8_SRGB_PoorCoverage:
-	case Format::R8G8B8A8_SRGB:
-	case Format::B8G8R8A8_SRGB:
-	case Format::A8B8G8R8_SRGB_Pack32:
-	case Format::BC1_RGB_SRGB_Block:
-	case Format::BC1_RGBA_SRGB_Block:
-	case Format::BC2_SRGB_Block:
-	case Format::BC3_SRGB_Block:
-	case Format::BC7_SRGB_Block:
-	case Format::ETC2_R8G8B8_SRGB_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A1_SRGB_Block_PoorCoverage:
-	case Format::ETC2_R8G8B8A8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_4x4_SRGB_Block_PoorCoverage:
-	case Format::ASTC_5x4_SRGB_Block_PoorCoverage:
-	case Format::ASTC_5x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_6x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_6x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_8x8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x5_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x6_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x8_SRGB_Block_PoorCoverage:
-	case Format::ASTC_10x10_SRGB_Block_PoorCoverage:
-	case Format::ASTC_12x10_SRGB_Block_PoorCoverage:
-	case Format::ASTC_12x12_SRGB_Block_PoorCoverage:
-		return true;
-	}
-	return false;
-}
+bool prosper::util::is_srgb_format(Format format) { return get_format_info(format).IsSrgb(); }
 
 bool prosper::util::save_texture(const std::string &fileName, IImage &image, const pragma::image::TextureInfo &texInfo, const std::function<void(const std::string &)> &errorHandler)
 {
@@ -8,6 +8,7 @@ module;
 
 module pragma.prosper;
 
+import :barrier_accumulator;
 import :shader_system.shader;
 import :util;
 
@@ -137,6 +138,12 @@ static bool record_image_barrier(prosper::ICommandBuffer &cmdBuffer, prosper::II
 		srcInfo = {prosper::PipelineStageFlags::TransferBit, currentLayout, prosper::AccessFlags::TransferWriteBit};
 		break;
 	}
+	if(auto *barrierAccumulator = cmdBuffer.GetBarrierAccumulator()) {
+		// Prefer the actual access and stage masks of the last transition over the generic ones
+		auto state = barrierAccumulator->FindImageState(img, subresourceRange);
+		if(state.has_value() && state->layout == originalLayout)
+			srcInfo = {state->stageMask, currentLayout, state->accessMask};
+	}
 
 	prosper::util::BarrierImageLayout dstInfo {};
 	switch(dstLayout) {
@@ -162,6 +169,15 @@ static bool record_image_barrier(prosper::ICommandBuffer &cmdBuffer, prosper::II
 bool prosper::ICommandBuffer::RecordImageBarrier(IImage &img, PipelineStageFlags srcStageMask, PipelineStageFlags dstStageMask, ImageLayout oldLayout, ImageLayout newLayout, AccessFlags srcAccessMask, AccessFlags dstAccessMask,
   uint32_t baseLayer, std::optional<ImageAspectFlags> aspectMask)
 {
+	if(m_barrierAccumulator) {
+		util::ImageSubresourceRange subresourceRange {};
+		if(baseLayer != std::numeric_limits<uint32_t>::max()) {
+			subresourceRange.baseArrayLayer = baseLayer;
+			subresourceRange.layerCount = 1u;
+		}
+		m_barrierAccumulator->AddImageBarrier(*this, img, {srcStageMask, oldLayout, srcAccessMask}, {dstStageMask, newLayout, dstAccessMask}, subresourceRange, aspectMask);
+		return true;
+	}
 	util::PipelineBarrierInfo barrier {};
 	barrier.srcStageMask = srcStageMask;
 	barrier.dstStageMask = dstStageMask;
@@ -181,6 +197,10 @@ bool prosper::ICommandBuffer::RecordImageBarrier(IImage &img, PipelineStageFlags
 }
 bool prosper::ICommandBuffer::RecordImageBarrier(IImage &img, const util::BarrierImageLayout &srcBarrierInfo, const util::BarrierImageLayout &dstBarrierInfo, const util::ImageSubresourceRange &subresourceRange, std::optional<ImageAspectFlags> aspectMask)
 {
+	if(m_barrierAccumulator) {
+		m_barrierAccumulator->AddImageBarrier(*this, img, srcBarrierInfo, dstBarrierInfo, subresourceRange, aspectMask);
+		return true;
+	}
 	util::PipelineBarrierInfo barrier {};
 	barrier.srcStageMask = srcBarrierInfo.stageMask;
 	barrier.dstStageMask = dstBarrierInfo.stageMask;
@@ -207,10 +227,15 @@ bool prosper::ICommandBuffer::RecordBindShaderPipeline(Shader &shader, PipelineI
 	if(pipelineInfo == nullptr)
 		return false;
 	auto pipelineId = pipelineInfo->id;
+	FlushBarriers();
 	return pipelineId != std::numeric_limits<PipelineID>::max() && DoRecordBindShaderPipeline(shader, shaderPipelineId, pipelineId);
 }
 bool prosper::ICommandBuffer::RecordBufferBarrier(IBuffer &buf, PipelineStageFlags srcStageMask, PipelineStageFlags dstStageMask, AccessFlags srcAccessMask, AccessFlags dstAccessMask, DeviceSize offset, DeviceSize size)
 {
+	if(m_barrierAccumulator) {
+		m_barrierAccumulator->AddBufferBarrier(*this, buf, srcStageMask, dstStageMask, srcAccessMask, dstAccessMask, offset, size);
+		return true;
+	}
 	util::PipelineBarrierInfo barrier {};
 	barrier.srcStageMask = srcStageMask;
 	barrier.dstStageMask = dstStageMask;
@@ -232,8 +257,10 @@ bool prosper::ICommandBuffer::RecordBufferBarrier(IBuffer &buf, PipelineStageFla
 bool prosper::IPrimaryCommandBuffer::RecordEndRenderPass()
 {
 	m_renderTargetInfo = {};
-	return DoRecordEndRenderPass();
+	// Barriers that were batched after the last command of the render pass can't be recorded within it
+	return DoRecordEndRenderPass() && FlushBarriers();
 }
+bool prosper::IPrimaryCommandBuffer::ExecuteCommands(ISecondaryCommandBuffer &cmdBuf) { return FlushBarriers(); }
 prosper::IPrimaryCommandBuffer::RenderTargetInfo *prosper::IPrimaryCommandBuffer::GetActiveRenderPassTargetInfo() const { return m_renderTargetInfo.has_value() ? &*m_renderTargetInfo : nullptr; }
 bool prosper::IPrimaryCommandBuffer::GetActiveRenderPassTarget(IRenderPass **outRp, IImage **outImg, IFramebuffer **outFb, RenderTarget **outRt) const
 {
@@ -284,6 +311,7 @@ bool prosper::IPrimaryCommandBuffer::DoRecordBeginRenderPass(RenderTarget &rt, u
 		}
 	}
 
+	FlushBarriers();
 	SetActiveRenderPassTarget(rp, (layerId != nullptr) ? *layerId : std::numeric_limits<uint32_t>::max(), &img, fb, nullptr);
 	return DoRecordBeginRenderPass(img, *rp, *fb, layerId, clearValues, renderPassFlags);
 }
@@ -302,5 +330,6 @@ bool prosper::IPrimaryCommandBuffer::RecordBeginRenderPass(RenderTarget &rt, Ren
 bool prosper::IPrimaryCommandBuffer::RecordBeginRenderPass(RenderTarget &rt, const std::vector<ClearValue> &clearValues, RenderPassFlags renderPassFlags, IRenderPass *rp) { return DoRecordBeginRenderPass(rt, nullptr, clearValues, rp, renderPassFlags); }
 bool prosper::IPrimaryCommandBuffer::RecordBeginRenderPass(IImage &img, IRenderPass &rp, IFramebuffer &fb, RenderPassFlags renderPassFlags, const std::vector<ClearValue> &clearValues)
 {
+	FlushBarriers();
 	return DoRecordBeginRenderPass(img, rp, fb, 0u, clearValues, renderPassFlags);
 }
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:barrier_accumulator;
+
+export import :structs;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class ICommandBuffer;
+		// Collects image and buffer barriers of a command buffer and emits them as a single pipeline barrier.
+		// Since no commands can be recorded between pending barriers, consecutive transitions of the same image subresources
+		// are collapsed into one, and barriers of the same buffer range are merged.
+		// The accumulator also keeps track of the last known layout, access and stage mask of every image subresource
+		// it has seen, which is used to determine the source masks of subsequent transitions.
+		class DLLPROSPER BarrierAccumulator {
+		  public:
+			struct DLLPROSPER Stats {
+				uint64_t numBarriers = 0;
+				uint64_t numMergedBarriers = 0;
+				uint64_t numRecordedPipelineBarriers = 0;
+			};
+			BarrierAccumulator();
+
+			void AddImageBarrier(ICommandBuffer &cmd, IImage &img, const util::BarrierImageLayout &srcBarrierInfo, const util::BarrierImageLayout &dstBarrierInfo, const util::ImageSubresourceRange &subresourceRange = {}, std::optional<ImageAspectFlags> aspectMask = {});
+			// Offset is relative to the buffer's start offset
+			void AddBufferBarrier(ICommandBuffer &cmd, IBuffer &buf, PipelineStageFlags srcStageMask, PipelineStageFlags dstStageMask, AccessFlags srcAccessMask, AccessFlags dstAccessMask, DeviceSize offset = 0ull, DeviceSize size = std::numeric_limits<DeviceSize>::max());
+			bool Flush(ICommandBuffer &cmd);
+			bool HasPendingBarriers() const { return !m_pending.imageBarriers.empty() || !m_pending.bufferBarriers.empty(); }
+
+			// Returns the tracked state of the specified subresources, if all of them are known and share the same state
+			std::optional<util::BarrierImageLayout> FindImageState(const IImage &img, const util::ImageSubresourceRange &subresourceRange = {}) const;
+			// Clears pending barriers and tracked image states
+			void Reset();
+
+			const Stats &GetStats() const { return m_stats; }
+			void ResetStats() { m_stats = {}; }
+		  private:
+			struct ImageState {
+				uint32_t numLayers = 0;
+				uint32_t numMipmaps = 0;
+				std::vector<std::optional<util::BarrierImageLayout>> subresources; // Indexed by layer *numMipmaps +mipmap
+			};
+			void UpdateImageState(IImage &img, const util::ImageSubresourceRange &range, const util::BarrierImageLayout &state);
+			bool Overlaps(const util::ImageBarrier &barrier, const IImage &img, const util::ImageSubresourceRange &range) const;
+
+			util::PipelineBarrierInfo m_pending {};
+			std::unordered_map<const IImage *, ImageState> m_imageStates;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
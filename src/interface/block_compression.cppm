@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:block_compression;
+
+export import :types;
+
+export namespace prosper::util {
+	enum class BlockCompressionQuality : uint8_t {
+		Fast = 0, // Bounding box endpoints
+		Normal,   // Endpoints along the principal axis of the block colors
+		High,     // Principal axis with least-squares endpoint refinement, single channel blocks try both interpolation modes
+	};
+	struct DLLPROSPER BlockCompressionInfo {
+		BlockCompressionQuality quality = BlockCompressionQuality::Normal;
+		uint32_t numThreads = 0; // 0 = One thread per hardware thread
+	};
+	// Returns true if the format can be encoded with compress_blocks (BC1, BC3, BC4 and BC5 unsigned formats)
+	DLLPROSPER bool is_block_compression_supported(Format format);
+	// Compresses a range of block rows (4 pixel rows each) of a tightly packed RGBA8 image. dst points to the first block of the image,
+	// with ceil(width / 4) blocks per row. Blocks at the image borders are padded by repeating the edge pixels.
+	DLLPROSPER void compress_blocks(Format format, const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t firstBlockRow, uint32_t numBlockRows, uint8_t *dst, BlockCompressionQuality quality);
+};
@@ -20,6 +20,7 @@ export {
 	namespace prosper {
 		class IUniformResizableBuffer;
 		class IDynamicResizableBuffer;
+		class FrameRingAllocator;
 
 		class DLLPROSPER IBuffer : public ContextObject, public std::enable_shared_from_this<IBuffer> {
 		  public:
@@ -42,6 +43,9 @@ export {
 			std::shared_ptr<IBuffer> GetParent();
 			const std::shared_ptr<IBuffer> GetParent() const;
 
+			// Writes to buffers that are not host-accessible are only deferred if called outside of the main thread: The data is queued
+			// in the staging uploader and copied with the next frame, in which case the return value only indicates that the upload
+			// has been queued. Synchronous writes on the main thread are always ordered after previously queued uploads.
 			bool Write(Offset offset, Size size, const void *data) const;
 			bool Read(Offset offset, Size size, void *data) const;
 
@@ -85,6 +89,7 @@ export {
 		  protected:
 			friend IUniformResizableBuffer;
 			friend IDynamicResizableBuffer;
+			friend FrameRingAllocator;
 			virtual void OnRelease() override;
 
 			virtual bool DoWrite(Offset offset, Size size, const void *data) const = 0;
@@ -113,6 +118,7 @@ export {
 			void *m_apiTypePtr = nullptr;
 		  private:
 			SubBufferIndex m_baseIndex = INVALID_INDEX;
+			SubBufferIndex m_parentSlot = INVALID_INDEX; // Index into the parent's list of allocated sub-buffers
 		};
 
 		template<typename T>
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:buffer.buffer_update_queue;
+
+export import :buffer.buffer;
+export import :context;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class ICommandBuffer;
+		// Accumulates deferred buffer updates (see IPrContext::ScheduleRecordUpdateBuffer) in a single data blob.
+		// Overlapping or adjacent updates to the same buffer are merged, and all updates are recorded with one
+		// barrier before and one barrier after the update commands.
+		class DLLPROSPER BufferUpdateQueue {
+		  public:
+			struct DLLPROSPER Stats {
+				uint64_t numUpdates = 0;
+				uint64_t numRecordedUpdates = 0;
+				uint64_t numRecordedBarriers = 0;
+			};
+			BufferUpdateQueue() = default;
+
+			void Add(IBuffer &buffer, uint64_t offset, uint64_t size, const void *data, const detail::BufferUpdateInfo &updateInfo);
+			bool Record(ICommandBuffer &cmd);
+			void Clear();
+			bool IsEmpty() const { return m_buffers.empty(); }
+
+			// Statistics of the last call to Record
+			const Stats &GetStats() const { return m_stats; }
+		  private:
+			struct Range {
+				uint64_t size;
+				uint64_t dataOffset;
+			};
+			struct BufferUpdates {
+				IBuffer *buffer = nullptr;
+				std::map<uint64_t, Range> ranges;
+				PipelineStageFlags srcStageMask = PipelineStageFlags::None;
+				AccessFlags srcAccessMask {};
+				PipelineStageFlags postStageMask = PipelineStageFlags::None;
+				AccessFlags postAccessMask {};
+			};
+			uint64_t AppendData(const void *data, uint64_t size);
+
+			std::vector<uint8_t> m_data;
+			std::vector<BufferUpdates> m_buffers;
+			std::unordered_map<IBuffer *, size_t> m_bufferIndices;
+			uint64_t m_numPendingUpdates = 0;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
@@ -5,9 +5,14 @@ module;
 
 export module pragma.prosper:buffer;
 export import :buffer.buffer;
+export import :buffer.buffer_update_queue;
 export import :buffer.buffer_create_info;
+export import :buffer.device_image_buffer_defragmenter;
 export import :buffer.dynamic_resizable_buffer;
+export import :buffer.frame_ring_allocator;
+export import :buffer.image_readback;
 export import :buffer.render_buffer;
 export import :buffer.resizable_buffer;
+export import :buffer.staging_uploader;
 export import :buffer.swap_buffer;
 export import :buffer.uniform_resizable_buffer;
@@ -0,0 +1,32 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:buffer.device_image_buffer_defragmenter;
+
+export import :buffer.dynamic_resizable_buffer;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		// Releases device image buffers that no longer hold any images. Images can't be bound to different memory after
+		// they have been created, so their sub-buffers are never moved between buffers; only buffers that have become empty are released.
+		class DLLPROSPER DeviceImageBufferDefragmenter {
+		  public:
+			struct DLLPROSPER Stats {
+				uint64_t numReleasedBuffers = 0;
+			};
+			DeviceImageBufferDefragmenter(IPrContext &context, std::vector<std::shared_ptr<IDynamicResizableBuffer>> &buffers);
+
+			// Has to be called from the main thread. Returns true if any buffers were released.
+			bool Step();
+			const Stats &GetStats() const { return m_stats; }
+		  private:
+			IPrContext &m_context;
+			std::vector<std::shared_ptr<IDynamicResizableBuffer>> &m_buffers;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
@@ -24,12 +24,24 @@ export {
 				DeviceSize startOffset;
 				DeviceSize size;
 			};
+			// Start offset -> size
+			using FreeRangeMap = std::map<DeviceSize, DeviceSize>;
 			IDynamicResizableBuffer(IPrContext &context, IBuffer &buffer, const util::BufferCreateInfo &createInfo);
-			void InsertFreeMemoryRange(std::list<Range>::iterator itWhere, DeviceSize startOffset, DeviceSize size);
+			void InsertFreeMemoryRange(DeviceSize startOffset, DeviceSize size);
+			FreeRangeMap::iterator EraseFreeMemoryRange(FreeRangeMap::iterator it);
 			void MarkMemoryRangeAsFree(DeviceSize startOffset, DeviceSize size);
+			void AddSubBuffer(IBuffer &subBuffer);
+			void RemoveSubBuffer(IBuffer &subBuffer);
 			void ReleaseBufferSafely() override {}
-			std::list<Range>::iterator FindFreeRange(DeviceSize size, uint32_t alignment);
-			std::list<Range> m_freeRanges;
+			bool CanReleaseBufferSafely() const override { return false; }
+			FreeRangeMap::iterator FindFreeRange(DeviceSize size, uint32_t alignment);
+			// Removes the requested size from the free range and returns the aligned start offset of the reserved memory
+			DeviceSize ReserveFreeRange(FreeRangeMap::iterator it, DeviceSize size, uint32_t alignment);
+
+			// Free ranges are stored twice: Ordered by offset (for coalescing neighbors) and ordered by size (for best-fit lookups)
+			FreeRangeMap m_freeRanges;
+			std::set<std::pair<DeviceSize, DeviceSize>> m_freeRangesBySize; // {size, start offset}
+			DeviceSize m_freeSize = 0ull;
 			mutable std::recursive_mutex m_bufferMutex;
 			uint32_t m_alignment = 0u;
 		};
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:buffer.frame_ring_allocator;
+
+export import :buffer.buffer;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		// Linear allocator for transient per-frame data (uniforms, vertices, indices, ...).
+		// The backing buffer is split into one segment per frame in flight, allocations are bump-allocated from the
+		// segment of the current frame and are only valid until the same frame resource index is used again.
+		class DLLPROSPER FrameRingAllocator {
+		  public:
+			struct DLLPROSPER Allocation {
+				IBuffer *buffer = nullptr;
+				DeviceSize offset = 0;
+				DeviceSize size = 0;
+				void *data = nullptr;
+				bool IsValid() const { return buffer != nullptr; }
+			};
+			struct DLLPROSPER Stats {
+				DeviceSize highWaterMark = 0; // Largest number of bytes allocated within a single frame
+				uint64_t numAllocations = 0;
+				uint64_t numOverflows = 0; // Allocations that did not fit into the current frame's segment
+				uint64_t numRejected = 0;  // Allocations that were made while no frame was being recorded
+			};
+
+			FrameRingAllocator(IPrContext &context, DeviceSize segmentSize);
+			~FrameRingAllocator();
+
+			// Returns an invalid allocation if the frame's segment is exhausted, or if no frame has begun
+			Allocation Allocate(DeviceSize size, uint32_t alignment = 0, const void *data = nullptr);
+			// Wraps the allocation in a sub-buffer object
+			std::shared_ptr<IBuffer> AllocateBuffer(DeviceSize size, uint32_t alignment = 0, const void *data = nullptr);
+
+			// Resets the segment of the specified frame. Must only be called once the GPU has finished processing the previous frame with this index.
+			void BeginFrame(uint8_t frameResourceIndex);
+			// Closes the current segment once its frame has been submitted. Allocations are rejected until the next BeginFrame call,
+			// since they would otherwise end up in a segment that is still in use by the GPU.
+			void EndFrame();
+
+			Stats GetStats() const;
+			void ResetStats();
+			DeviceSize GetSegmentSize() const { return m_segmentSize; }
+			const std::shared_ptr<IBuffer> &GetBuffer() const { return m_buffer; }
+		  private:
+			struct Segment {
+				std::atomic<DeviceSize> offset = 0;
+			};
+			IPrContext &m_context;
+			std::shared_ptr<IBuffer> m_buffer;
+			uint8_t *m_mappedData = nullptr;
+			DeviceSize m_segmentSize = 0;
+			DeviceSize m_minAlignment = 1;
+			std::unique_ptr<Segment[]> m_segments;
+			uint8_t m_numSegments = 0;
+			static constexpr uint8_t NO_SEGMENT = std::numeric_limits<uint8_t>::max();
+			std::atomic<uint8_t> m_currentSegment = NO_SEGMENT;
+
+			std::atomic<DeviceSize> m_highWaterMark = 0;
+			std::atomic<uint64_t> m_numAllocations = 0;
+			std::atomic<uint64_t> m_numOverflows = 0;
+			std::atomic<uint64_t> m_numRejected = 0;
+		};
+	};
+#pragma warning(pop)
+}
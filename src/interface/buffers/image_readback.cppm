@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:buffer.image_readback;
+
+export import :buffer.buffer;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		class IFence;
+		class ICommandBuffer;
+		class IPrimaryCommandBuffer;
+		// Reads data from the GPU back to the host without blocking. Queued readbacks are recorded into a single command buffer once per frame (see Flush),
+		// and are completed by Poll once the fence of their submission has been signaled. Staging buffers are pooled by power-of-two size classes.
+		class DLLPROSPER ImageReadback {
+		  public:
+			struct DLLPROSPER Stats {
+				uint64_t numRequests = 0;
+				uint64_t numSubmissions = 0;
+				uint64_t numStagingBuffersCreated = 0;
+				uint64_t numStagingBuffersReused = 0;
+			};
+			struct DLLPROSPER Request {
+				DeviceSize size = 0;
+				// Records the commands that copy the data into the staging buffer, starting at offset 0. Called on the main thread during Flush.
+				// Any images used by the commands have to be in the layout that was expected at the time of the request.
+				std::function<bool(ICommandBuffer &, IBuffer &)> record;
+				// Called on the main thread once the data is available in the staging buffer, or with nullptr if the readback has failed
+				std::function<void(IBuffer *)> onComplete;
+			};
+
+			ImageReadback(IPrContext &context);
+			~ImageReadback();
+			ImageReadback(const ImageReadback &) = delete;
+			ImageReadback &operator=(const ImageReadback &) = delete;
+
+			// Can be called from any thread
+			void Enqueue(Request &&request);
+			// Records and submits all queued readbacks. Has to be called from the main thread.
+			void Flush();
+			// Completes all readbacks whose submission has finished, without waiting. Has to be called from the main thread.
+			void Poll();
+			// Releases all staging buffers that are currently not in use
+			void ClearStagingBuffers();
+
+			const Stats &GetStats() const { return m_stats; }
+		  private:
+			static constexpr DeviceSize MIN_STAGING_BUFFER_SIZE = 64ull * 1'024ull; // 64 KiB
+			struct StagingBuffer {
+				std::shared_ptr<IBuffer> buffer;
+				uint32_t sizeClass;
+			};
+			struct Readback {
+				Request request;
+				StagingBuffer stagingBuffer;
+			};
+			struct Submission {
+				std::shared_ptr<IFence> fence;
+				std::shared_ptr<IPrimaryCommandBuffer> cmd;
+				std::vector<Readback> readbacks;
+			};
+			std::optional<StagingBuffer> AcquireStagingBuffer(DeviceSize size);
+			void ReleaseStagingBuffer(StagingBuffer &&stagingBuffer);
+			std::shared_ptr<IFence> AcquireFence();
+
+			IPrContext &m_context;
+			std::mutex m_queueMutex;
+			std::vector<Request> m_queuedRequests;
+			std::deque<Submission> m_submissions;
+			std::vector<std::vector<std::shared_ptr<IBuffer>>> m_freeStagingBuffers; // Per size class
+			std::vector<std::shared_ptr<IFence>> m_freeFences;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
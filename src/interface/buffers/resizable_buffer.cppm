@@ -14,6 +14,10 @@ export {
 			enum class ReallocationBehavior : uint8_t {
 				DeviceWaitIdle = 0,
 				SafelyFreeOldBuffer,
+				// The data is copied to the new buffer on the GPU without staging it through host memory. The copy is submitted without waiting for it,
+				// the old buffer is released once the current frame has been presented. Host-accessible buffers and buffers whose old memory can't be
+				// kept alive wait for the copy instead. Requires the buffer to have been created with the transfer src/dst usage flags.
+				CopyOnGPU,
 			};
 			IResizableBuffer(IBuffer &parent);
 			ReallocationBehavior GetReallocationBehavior() const { return m_reallocationBehavior; }
@@ -27,8 +31,14 @@ export {
 			void ReallocateMemory();
 		  protected:
 			virtual void MoveInternalBuffer(IBuffer &other) = 0;
+			// Keeps the current internal buffer alive until the current frame has been presented, even if it is replaced by MoveInternalBuffer
 			virtual void ReleaseBufferSafely() = 0;
+			// Returns false if ReleaseBufferSafely releases the internal buffer immediately
+			virtual bool CanReleaseBufferSafely() const { return true; }
 			bool ReallocateMemory(size_t requiredSize);
+			// Copies the contents to newBuffer on the GPU. If waitForCompletion is false, the copy is only submitted and the command buffer
+			// is kept alive until the current frame has been presented.
+			bool CopyToReallocatedBuffer(IBuffer &newBuffer, DeviceSize size, bool waitForCompletion);
 			void RunReallocationCallbacks();
 
 			std::vector<IBuffer *> m_allocatedSubBuffers;
@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:buffer.staging_uploader;
+
+export import :buffer.buffer;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		class IFence;
+		class IPrimaryCommandBuffer;
+		// Batches uploads to device-local buffers through a persistently mapped ring buffer.
+		// Uploads can be queued from any thread and are submitted together once per frame (see Flush).
+		// Uploads that are still pending when the uploader is destroyed are submitted and waited for.
+		class DLLPROSPER StagingUploader {
+		  public:
+			using CompletionValue = uint64_t;
+			struct DLLPROSPER CreateInfo {
+				DeviceSize ringBufferSize = 32ull * 1'024ull * 1'024ull; // 32 MiB
+				// If a queue other than the universal queue is used, the caller is responsible for not using
+				// the uploaded data before the corresponding completion value has been reached!
+				QueueFamilyType queueFamilyType = QueueFamilyType::Universal;
+			};
+			struct DLLPROSPER Stats {
+				uint64_t numUploads = 0;
+				uint64_t numCopyRegions = 0;
+				uint64_t numSubmissions = 0;
+				uint64_t numFallbackWrites = 0;
+				uint64_t numDedicatedBuffers = 0; // Uploads from other threads that did not fit into the ring buffer
+			};
+
+			StagingUploader(IPrContext &context, const CreateInfo &createInfo = {});
+			~StagingUploader();
+
+			// Copies the data into the staging ring buffer and schedules a copy to the destination buffer.
+			// Returns the completion value of the submission the upload will be part of, or an empty optional on failure.
+			// Uploads that don't fit into the ring buffer are written synchronously on the main thread. On other threads, they are staged
+			// through a dedicated buffer instead, since waiting for the main thread to free up ring buffer space could deadlock.
+			std::optional<CompletionValue> Upload(IBuffer &dstBuffer, DeviceSize dstOffset, DeviceSize size, const void *data);
+
+			// Records and submits all pending uploads. Has to be called from the main thread.
+			CompletionValue Flush();
+			// Submits the pending uploads if any of them overlap the specified range of dstBuffer, so that a
+			// subsequent synchronous write to that range can't be overwritten by them. Has to be called from the main thread.
+			void FlushPendingUploads(const IBuffer &dstBuffer, DeviceSize dstOffset, DeviceSize size);
+			// Polls the fences of previous submissions and releases their staging memory.
+			CompletionValue GetCompletedValue();
+			bool IsComplete(CompletionValue value) { return GetCompletedValue() >= value; }
+			void Wait(CompletionValue value);
+
+			const Stats &GetStats() const { return m_stats; }
+			DeviceSize GetRingBufferSize() const { return m_ringBufferSize; }
+		  private:
+			static constexpr DeviceSize COPY_ALIGNMENT = 16;
+			struct CopyRegion {
+				std::shared_ptr<IBuffer> dstBuffer;
+				std::shared_ptr<IBuffer> srcBuffer; // Dedicated staging buffer, or nullptr for the ring buffer
+				DeviceSize srcOffset;               // Physical offset in the ring buffer
+				DeviceSize dstOffset;
+				DeviceSize size;
+			};
+			struct Submission {
+				CompletionValue value;
+				uint64_t ringEnd;
+				std::shared_ptr<IFence> fence;
+				std::shared_ptr<IPrimaryCommandBuffer> cmd;
+				std::vector<std::shared_ptr<IBuffer>> dstBuffers;
+				std::vector<std::shared_ptr<IBuffer>> srcBuffers;
+			};
+			// Returns an empty optional if called outside of the main thread and the ring buffer is full
+			std::optional<uint64_t> AllocateRingSpace(std::unique_lock<std::mutex> &lock, DeviceSize size);
+			std::optional<CompletionValue> UploadThroughDedicatedBuffer(IBuffer &root, DeviceSize rootOffset, DeviceSize size, const void *data);
+			void RetireCompletedSubmissions(bool waitForOldest);
+			std::shared_ptr<IFence> AcquireFence();
+
+			IPrContext &m_context;
+			QueueFamilyType m_queueFamilyType;
+			std::shared_ptr<IBuffer> m_ringBuffer;
+			uint8_t *m_ringData = nullptr;
+			DeviceSize m_ringBufferSize = 0;
+
+			std::mutex m_mutex;
+			std::condition_variable m_stateChanged;
+			// Monotonic positions in the ring buffer; The physical offset is position % m_ringBufferSize
+			uint64_t m_ringHead = 0;
+			uint64_t m_ringTail = 0;
+			// Start positions of allocations whose data is still being written
+			std::multiset<uint64_t> m_pendingWrites;
+			std::vector<CopyRegion> m_pendingRegions;
+			std::deque<Submission> m_submissions;
+			std::vector<std::shared_ptr<IFence>> m_freeFences;
+			CompletionValue m_submittedValue = 0;
+			CompletionValue m_completedValue = 0;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
@@ -21,18 +21,62 @@ export {
 			IBuffer &GetCurrentBuffer() const;
 			bool IsDirty() const;
 
+			// Writes the data to the current buffer and flags the other buffers as dirty, so they receive it once they become current.
+			// If flagAsDirty is false, the data is assumed to be the same as in the last flagged write and is only written if the current buffer is dirty.
+			// With a shadow copy (see HasShadowCopy), only the byte ranges that have changed since a frame's buffer was last written are uploaded for that frame.
 			IBuffer &Write(IBuffer::Offset offset, IBuffer::Size size, const void *data, bool flagAsDirty = true);
+			// Writes the data to the current buffer only, the other buffers are left as they are
+			IBuffer &WriteCurrentBuffer(IBuffer::Offset offset, IBuffer::Size size, const void *data);
+			// Swap buffers created from a uniform resizable buffer keep a CPU copy of the buffer contents, which is used to only upload the changed bytes
+			bool HasShadowCopy() const { return m_useShadowCopy; }
 
 			IBuffer *operator->();
 			const IBuffer *operator->() const { return const_cast<SwapBuffer *>(this)->operator->(); }
 			IBuffer &operator*();
 			const IBuffer &operator*() const { return const_cast<SwapBuffer *>(this)->operator*(); }
 		  private:
-			SwapBuffer(IPrContext &context, std::vector<std::shared_ptr<IBuffer>> &&buffers);
+			SwapBuffer(IPrContext &context, std::vector<std::shared_ptr<IBuffer>> &&buffers, bool useShadowCopy);
 			uint8_t GetCurrentBufferIndex() const;
 			uint32_t GetCurrentBufferFlag() const;
+			// Ranges are stored as start offset -> end offset and never overlap
+			using RangeSet = std::map<DeviceSize, DeviceSize>;
+			static void AddRange(RangeSet &ranges, DeviceSize start, DeviceSize end);
+			static void RemoveRange(RangeSet &ranges, DeviceSize start, DeviceSize end);
+			void MarkRangeAsDirty(DeviceSize start, DeviceSize end);
+			void UpdateShadowData(IBuffer::Offset offset, IBuffer::Size size, const uint8_t *data, bool flagChangesAsDirty);
+			void ReplayDirtyRanges(IBuffer &buf, RangeSet &dirtyRanges);
 			std::vector<std::shared_ptr<IBuffer>> m_buffers;
-			mutable uint8_t m_buffersDirty = 0;
+			bool m_useShadowCopy = false;
+			// Without shadow copy
+			mutable uint32_t m_buffersDirty = 0;
+			// With shadow copy
+			std::vector<RangeSet> m_dirtyRanges; // Per buffer
+			// CPU copy of the most recent buffer contents; Only the bytes in m_shadowValidRanges are known
+			std::vector<uint8_t> m_shadowData;
+			RangeSet m_shadowValidRanges;
+		};
+
+		// Frame-scoped storage for deferred SwapBuffer updates (see IPrContext::ScheduleRecordUpdateBuffer).
+		// Payloads are stored inline in a single data blob whose capacity is reused between frames, buffers
+		// are referenced weakly and updates for buffers that have been destroyed in the meantime are skipped.
+		class DLLPROSPER SwapBufferUpdateArena {
+		  public:
+			SwapBufferUpdateArena() = default;
+			void Add(SwapBuffer &buffer, IBuffer::Offset offset, IBuffer::Size size, const void *data);
+			// Writes all updates to the current buffers of their respective swap buffers and clears the arena
+			void Replay();
+			void Clear();
+			bool IsEmpty() const { return m_updates.empty(); }
+		  private:
+			static constexpr DeviceSize PAYLOAD_ALIGNMENT = 8;
+			struct Update {
+				std::weak_ptr<SwapBuffer> buffer;
+				IBuffer::Offset offset;
+				IBuffer::Size size;
+				DeviceSize dataOffset;
+			};
+			std::vector<Update> m_updates;
+			std::vector<uint8_t> m_data;
 		};
 	};
 }
@@ -11,9 +11,25 @@ export {
 	namespace prosper {
 		class DLLPROSPER IUniformResizableBuffer : public IResizableBuffer {
 		  public:
+			enum class AllocationMode : uint8_t {
+				Shared = 0,  // All allocations go through the shared pool
+				ThreadCached // Each thread allocates from its own cache of free instances, which is refilled from the shared pool in batches
+			};
+			static constexpr uint32_t THREAD_CACHE_BATCH_SIZE = 32;
+			// Threads beyond this number of concurrently running threads fall back to the shared pool
+			static constexpr uint32_t MAX_THREAD_CACHES = 64;
+
 			bool EnsureCapacity(uint32_t instanceCount);
 			std::shared_ptr<IBuffer> AllocateBuffer(const void *data = nullptr);
 
+			// Has to be set before any sub-buffers have been allocated. In ThreadCached mode, reallocation callbacks
+			// must not allocate or release instances of this buffer.
+			void SetAllocationMode(AllocationMode mode) { m_allocationMode = mode; }
+			AllocationMode GetAllocationMode() const { return m_allocationMode; }
+			// Returns the free instances cached by the calling thread to the shared pool. The cache of a thread that has exited is
+			// taken over by the next thread that is started, so calling this is optional.
+			void FlushThreadCache();
+
 			uint64_t GetInstanceSize() const;
 			uint32_t GetAlignment() const;
 			uint64_t GetStride() const;
@@ -24,12 +40,34 @@ export {
 			uint64_t GetAssignedMemory() const;
 			uint32_t GetTotalInstanceCount() const;
 		  protected:
+			struct ThreadCache {
+				std::vector<uint64_t> freeOffsets;
+			};
 			IUniformResizableBuffer(IPrContext &context, IBuffer &buffer, uint64_t bufferInstanceSize, uint64_t alignedBufferBaseSize, uint32_t alignment);
+			std::shared_ptr<IBuffer> CreateInstanceSubBuffer(uint64_t offset, const void *data);
+			void FreeInstance(uint64_t offset, uint64_t idx);
+			// Returns nullptr if no thread cache is available for the calling thread
+			ThreadCache *GetThreadCache();
+			bool RefillThreadCache(ThreadCache &cache);
+			// Thread-cached allocations have to be excluded from reallocations of the internal buffer
+			void BeginAccess();
+			void EndAccess();
+
+			// Immutable after construction
 			uint64_t m_bufferInstanceSize = 0ull; // Size of each sub-buffer
-			uint64_t m_assignedMemory = 0ull;
 			uint32_t m_alignment = 0u;
+
+			uint64_t m_assignedMemory = 0ull;
 			mutable std::recursive_mutex m_bufferMutex;
 			std::queue<uint64_t> m_freeOffsets;
+
+			// Set while the internal buffer is being reallocated, which waits for all active thread-cached accesses to complete
+			std::atomic<bool> m_reallocating = false;
+			std::atomic<uint32_t> m_numActiveAccesses = 0;
+			AllocationMode m_allocationMode = AllocationMode::Shared;
+			// Indexed by thread slot, only the thread owning a slot accesses its cache
+			std::array<std::atomic<ThreadCache *>, MAX_THREAD_CACHES> m_threadCaches {};
+			std::vector<std::unique_ptr<ThreadCache>> m_threadCacheStorage;
 		};
 	};
 #pragma warning(pop)
@@ -33,6 +33,7 @@ export {
 		class Shader;
 		class IRenderBuffer;
 		class Window;
+		class BarrierAccumulator;
 		namespace debug {
 			struct ApiDumpRecorder;
 		};
@@ -52,13 +53,15 @@ export {
 			virtual bool RecordBindVertexBuffers(const ShaderGraphics &shader, const std::vector<IBuffer *> &buffers, uint32_t startBinding = 0u, const std::vector<DeviceSize> &offsets = {}) = 0;
 			virtual bool RecordBindVertexBuffer(const ShaderGraphics &shader, const IBuffer &buf, uint32_t startBinding = 0u, DeviceSize offset = 0u) = 0;
 			virtual bool RecordBindRenderBuffer(const IRenderBuffer &renderBuffer) = 0;
-			virtual bool RecordDispatchIndirect(IBuffer &buffer, DeviceSize size) = 0;
-			virtual bool RecordDispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
-			virtual bool RecordDraw(uint32_t vertCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) = 0;
-			virtual bool RecordDrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, uint32_t firstInstance = 0) = 0;
-			virtual bool RecordDrawIndexedIndirect(IBuffer &buf, DeviceSize offset, uint32_t drawCount, uint32_t stride) = 0;
-			virtual bool RecordDrawIndirect(IBuffer &buf, DeviceSize offset, uint32_t count, uint32_t stride) = 0;
-			virtual bool RecordFillBuffer(IBuffer &buf, DeviceSize offset, DeviceSize size, uint32_t data) = 0;
+			// The base implementations of these commands only flush the pending batched barriers (see SetBarrierBatchingEnabled),
+			// backend implementations have to call them before recording the command.
+			virtual bool RecordDispatchIndirect(IBuffer &buffer, DeviceSize size);
+			virtual bool RecordDispatch(uint32_t x, uint32_t y, uint32_t z);
+			virtual bool RecordDraw(uint32_t vertCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+			virtual bool RecordDrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, uint32_t firstInstance = 0);
+			virtual bool RecordDrawIndexedIndirect(IBuffer &buf, DeviceSize offset, uint32_t drawCount, uint32_t stride);
+			virtual bool RecordDrawIndirect(IBuffer &buf, DeviceSize offset, uint32_t count, uint32_t stride);
+			virtual bool RecordFillBuffer(IBuffer &buf, DeviceSize offset, DeviceSize size, uint32_t data);
 			// bool RecordResetEvent(Event &ev,PipelineStateFlags stageMask);
 			virtual bool RecordSetBlendConstants(const std::array<float, 4> &blendConstants) = 0;
 			virtual bool RecordSetDepthBounds(float minDepthBounds, float maxDepthBounds) = 0;
@@ -70,15 +73,17 @@ export {
 			QueueFamilyType GetQueueFamilyType() const;
 			bool RecordCopyBuffer(const util::BufferCopy &copyInfo, IBuffer &bufferSrc, IBuffer &bufferDst);
 			virtual bool RecordSetDepthBias(float depthBiasConstantFactor = 0.f, float depthBiasClamp = 0.f, float depthBiasSlopeFactor = 0.f) = 0;
-			virtual bool RecordClearImage(IImage &img, ImageLayout layout, const std::array<float, 4> &clearColor, const util::ClearImageInfo &clearImageInfo = {}) = 0;
-			virtual bool RecordClearImage(IImage &img, ImageLayout layout, std::optional<float> clearDepth, std::optional<uint32_t> clearStencil, const util::ClearImageInfo &clearImageInfo = {}) = 0;
-			virtual bool RecordClearAttachment(IImage &img, const std::array<float, 4> &clearColor, uint32_t attId, uint32_t layerId, uint32_t layerCount = 1) = 0;
-			virtual bool RecordClearAttachment(IImage &img, std::optional<float> clearDepth, std::optional<uint32_t> clearStencil, uint32_t layerId = 0u) = 0;
+			// Base implementations only flush the pending batched barriers, see above
+			virtual bool RecordClearImage(IImage &img, ImageLayout layout, const std::array<float, 4> &clearColor, const util::ClearImageInfo &clearImageInfo = {});
+			virtual bool RecordClearImage(IImage &img, ImageLayout layout, std::optional<float> clearDepth, std::optional<uint32_t> clearStencil, const util::ClearImageInfo &clearImageInfo = {});
+			virtual bool RecordClearAttachment(IImage &img, const std::array<float, 4> &clearColor, uint32_t attId, uint32_t layerId, uint32_t layerCount = 1);
+			virtual bool RecordClearAttachment(IImage &img, std::optional<float> clearDepth, std::optional<uint32_t> clearStencil, uint32_t layerId = 0u);
 			bool RecordClearAttachment(IImage &img, const std::array<float, 4> &clearColor, uint32_t attId = 0u);
 			bool RecordCopyImage(const util::CopyInfo &copyInfo, IImage &imgSrc, IImage &imgDst);
 			bool RecordCopyBufferToImage(const util::BufferImageCopyInfo &copyInfo, IBuffer &bufferSrc, IImage &imgDst);
 			bool RecordCopyImageToBuffer(const util::BufferImageCopyInfo &copyInfo, IImage &imgSrc, ImageLayout srcImageLayout, IBuffer &bufferDst);
-			virtual bool RecordUpdateBuffer(IBuffer &buffer, uint64_t offset, uint64_t size, const void *data) = 0;
+			// Base implementation only flushes the pending batched barriers, see above
+			virtual bool RecordUpdateBuffer(IBuffer &buffer, uint64_t offset, uint64_t size, const void *data);
 			template<typename T>
 			bool RecordUpdateBuffer(IBuffer &buffer, uint64_t offset, const T &data);
 
@@ -89,7 +94,8 @@ export {
 			// The source texture image will be copied to the destination image using a resolve (if it's a MSAA texture) or a blit
 			bool RecordBlitTexture(Texture &texSrc, IImage &imgDst);
 			bool RecordGenerateMipmaps(IImage &img, ImageLayout currentLayout, AccessFlags srcAccessMask, PipelineStageFlags srcStage);
-			virtual bool RecordPipelineBarrier(const util::PipelineBarrierInfo &barrierInfo) = 0;
+			// Base implementation only flushes the pending batched barriers, see above
+			virtual bool RecordPipelineBarrier(const util::PipelineBarrierInfo &barrierInfo);
 			// Records an image barrier. If no layer is specified, ALL layers of the image will be included in the barrier.
 			bool RecordImageBarrier(IImage &img, PipelineStageFlags srcStageMask, PipelineStageFlags dstStageMask, ImageLayout oldLayout, ImageLayout newLayout, AccessFlags srcAccessMask, AccessFlags dstAccessMask, uint32_t baseLayer = std::numeric_limits<uint32_t>::max(),
 			  std::optional<ImageAspectFlags> aspectMask = {});
@@ -97,6 +103,16 @@ export {
 			bool RecordImageBarrier(IImage &img, ImageLayout srcLayout, ImageLayout dstLayout, const util::ImageSubresourceRange &subresourceRange = {}, std::optional<ImageAspectFlags> aspectMask = {});
 			bool RecordPostRenderPassImageBarrier(IImage &img, ImageLayout preRenderPassLayout, ImageLayout postRenderPassLayout, const util::ImageSubresourceRange &subresourceRange = {}, std::optional<ImageAspectFlags> aspectMask = {});
 			bool RecordBufferBarrier(IBuffer &buf, PipelineStageFlags srcStageMask, PipelineStageFlags dstStageMask, AccessFlags srcAccessMask, AccessFlags dstAccessMask, DeviceSize offset = 0ull, DeviceSize size = std::numeric_limits<DeviceSize>::max());
+
+			// While barrier batching is enabled, barriers recorded with RecordImageBarrier, RecordPostRenderPassImageBarrier or RecordBufferBarrier are accumulated
+			// and recorded as a single pipeline barrier before the next command that accesses resources (copies, blits, resolves, clears, buffer updates and fills,
+			// render passes, pipeline binds, pipeline barriers, secondary command buffer executions, draws and dispatches) and before the recording is stopped.
+			// Disabling batching flushes all pending barriers.
+			// Commands that are recorded by the backend directly rely on the backend calling the base implementation, which flushes the barriers.
+			void SetBarrierBatchingEnabled(bool enabled);
+			bool IsBarrierBatchingEnabled() const { return m_barrierAccumulator != nullptr; }
+			bool FlushBarriers();
+			BarrierAccumulator *GetBarrierAccumulator() { return m_barrierAccumulator.get(); }
 			virtual bool RecordBindDescriptorSets(PipelineBindPoint bindPoint, Shader &shader, PipelineID pipelineId, uint32_t firstSet, const std::vector<IDescriptorSet *> &descSets, const std::vector<uint32_t> dynamicOffsets = {}) = 0;
 			virtual bool RecordBindDescriptorSets(PipelineBindPoint bindPoint, const IShaderPipelineLayout &pipelineLayout, uint32_t firstSet, const IDescriptorSet &descSet, uint32_t *optDynamicOffset = nullptr) = 0;
 			virtual bool RecordBindDescriptorSets(PipelineBindPoint bindPoint, const IShaderPipelineLayout &pipelineLayout, uint32_t firstSet, uint32_t numDescSets, const IDescriptorSet *const *descSets, uint32_t numDynamicOffsets = 0, const uint32_t *dynamicOffsets = nullptr)
@@ -166,6 +182,7 @@ export {
 			void *m_apiTypePtr = nullptr;
 			void *m_cmdBufSpecializationPtr = nullptr; // Pointer to IPrimaryCommandBuffer or ISecondaryCommandBuffer
 			mutable bool m_recording = false;
+			std::unique_ptr<BarrierAccumulator> m_barrierAccumulator;
 
 #ifdef PR_DEBUG_API_DUMP
 			mutable std::unique_ptr<debug::ApiDumpRecorder> m_apiDumpRecorder;
@@ -202,10 +219,12 @@ export {
 			bool RecordBeginRenderPass(RenderTarget &rt, const std::vector<ClearValue> &clearValues, RenderPassFlags renderPassFlags = RenderPassFlags::None, IRenderPass *rp = nullptr);
 			bool RecordBeginRenderPass(IImage &img, IRenderPass &rp, IFramebuffer &fb, RenderPassFlags renderPassFlags = RenderPassFlags::None, const std::vector<ClearValue> &clearValues = {});
 			virtual bool StartRecording(bool oneTimeSubmit = true, bool simultaneousUseAllowed = false) const;
+			// Flushes the pending batched barriers, has to be called by the backend before the command buffer is ended
 			virtual bool StopRecording() const override;
 			bool RecordEndRenderPass();
 			virtual bool RecordNextSubPass() = 0;
-			virtual bool ExecuteCommands(ISecondaryCommandBuffer &cmdBuf) = 0;
+			// Base implementation only flushes the pending batched barriers
+			virtual bool ExecuteCommands(ISecondaryCommandBuffer &cmdBuf);
 
 			RenderTargetInfo *GetActiveRenderPassTargetInfo() const;
 			bool GetActiveRenderPassTarget(IRenderPass **outRp = nullptr, IImage **outImg = nullptr, IFramebuffer **outFb = nullptr, RenderTarget **outRt = nullptr) const;
@@ -226,6 +245,7 @@ export {
 			using ICommandBuffer::ICommandBuffer;
 			virtual bool StartRecording(bool oneTimeSubmit = true, bool simultaneousUseAllowed = false) const;
 			virtual bool StartRecording(IRenderPass &rp, IFramebuffer &fb, bool oneTimeSubmit = true, bool simultaneousUseAllowed = false) const;
+			// Flushes the pending batched barriers, has to be called by the backend before the command buffer is ended
 			virtual bool StopRecording() const override;
 
 			IRenderPass *GetCurrentRenderPass() { return m_currentRenderPass; }
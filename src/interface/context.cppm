@@ -106,6 +106,17 @@ export {
 		using FrameIndex = uint64_t;
 		class Window;
 		class ShaderPipelineLoader;
+		class StagingUploader;
+		class DescriptorSetCache;
+		class DescriptorWriteBatcher;
+		class CommandRecordThreadPool;
+		class ImageReadback;
+		class FrameRingAllocator;
+		class BufferUpdateQueue;
+		class SwapBufferUpdateArena;
+		class DeviceImageBufferDefragmenter;
+		class ShaderHotReloader;
+		class ShaderCache;
 		class DLLPROSPER IPrContext : public std::enable_shared_from_this<IPrContext> {
 		  public:
 			// Max push constant size supported by most vendors / GPUs
@@ -269,9 +280,16 @@ export {
 			const std::shared_ptr<IBuffer> &GetDummyBuffer() const;
 			const std::shared_ptr<IDynamicResizableBuffer> &GetTemporaryBuffer() const;
 			const std::vector<std::shared_ptr<IDynamicResizableBuffer>> &GetDeviceImageBuffers() const;
+			// If enabled, device image buffers that no longer hold any images are released at the start of every frame
+			void SetDeviceImageBufferDefragmentationEnabled(bool enabled) { m_deviceImgBufferDefragmentationEnabled = enabled; }
+			DeviceImageBufferDefragmenter *GetDeviceImageBufferDefragmenter() { return m_deviceImgBufferDefragmenter.get(); }
 
 			std::shared_ptr<IBuffer> AllocateTemporaryBuffer(DeviceSize size, uint32_t alignment = 0, const void *data = nullptr);
 			void AllocateTemporaryBuffer(IImage &img, const void *data = nullptr);
+			// Allocates from the ring buffer of the current frame, the returned buffer must not be used after the frame has been submitted.
+			// Falls back to AllocateTemporaryBuffer if the frame's ring buffer segment is exhausted, or if no frame is being recorded.
+			std::shared_ptr<IBuffer> AllocateFrameTemporaryBuffer(DeviceSize size, uint32_t alignment = 0, const void *data = nullptr);
+			FrameRingAllocator *GetFrameRingAllocator() { return m_frameRingAllocator.get(); }
 
 			std::shared_ptr<IBuffer> AllocateDeviceImageBuffer(DeviceSize size, uint32_t alignment = 0, const void *data = nullptr);
 			void AllocateDeviceImageBuffer(IImage &img, const void *data = nullptr);
@@ -379,8 +397,38 @@ export {
 			CommonBufferCache &GetCommonBufferCache() const;
 
 			ShaderPipelineLoader &GetPipelineLoader();
+			// Batched uploads to device-local buffers, pending uploads are submitted at the start of every frame
+			StagingUploader *GetStagingUploader() { return m_stagingUploader.get(); }
+			// Shared descriptor set groups for resource combinations that are requested repeatedly, e.g. by temporary blur sets
+			DescriptorSetCache *GetDescriptorSetCache() { return m_descriptorSetCache.get(); }
+			// Descriptor sets with changed bindings, which are written together at the start of the next frame
+			DescriptorWriteBatcher *GetDescriptorWriteBatcher() { return m_descriptorWriteBatcher.get(); }
+			// Writes the dirty bindings of all specified descriptor sets. Backends can override this to submit all writes with a single call.
+			virtual void UpdateDescriptorSets(const std::vector<IDescriptorSet *> &descSets);
+			// Shared by all multi-threaded swap command buffer groups
+			CommandRecordThreadPool *GetCommandRecordThreadPool() { return m_commandRecordThreadPool.get(); }
+			// Non-blocking readbacks of GPU data, which are submitted and completed once per frame
+			ImageReadback *GetImageReadback() { return m_imageReadback.get(); }
 			const ShaderPipelineLoader &GetPipelineLoader() const { return const_cast<IPrContext *>(this)->GetPipelineLoader(); }
 
+			// Reloads shaders whenever one of their source files or includes changes on disk. Should be enabled before any shaders are loaded,
+			// otherwise changes to the includes of shaders that are already loaded are only detected after they have been reloaded once.
+			void SetShaderHotReloadEnabled(bool enabled);
+			bool IsShaderHotReloadEnabled() const { return m_shaderHotReloader != nullptr; }
+			ShaderHotReloader *GetShaderHotReloader() { return m_shaderHotReloader.get(); }
+
+			// On-disk cache for compiled shader stages. Compiled stages are only stored and restored if the backend implements
+			// GetShaderCompilerVersion, SerializeShaderStageProgram and DeserializeShaderStageProgram.
+			void SetShaderCacheEnabled(bool enabled, const std::string &rootPath = "cache/shaders/");
+			bool IsShaderCacheEnabled() const { return GetShaderCache() != nullptr; }
+			std::shared_ptr<ShaderCache> GetShaderCache() const;
+			// Identifies the shader compiler of the backend, cache entries of a different compiler version are ignored. The shader cache
+			// is bypassed if this is empty.
+			virtual std::string GetShaderCompilerVersion() const { return {}; }
+			// Returns the SPIR-V code of a compiled stage program, or an empty vector if the program can't be serialized
+			virtual std::vector<uint32_t> SerializeShaderStageProgram(const ShaderStageProgram &program) const { return {}; }
+			virtual std::shared_ptr<ShaderStageProgram> DeserializeShaderStageProgram(ShaderStage stage, const std::vector<uint32_t> &spirv) { return nullptr; }
+
 			virtual void *GetInternalDevice() const { return nullptr; }
 			virtual void *GetInternalPhysicalDevice() const { return nullptr; }
 			virtual void *GetInternalInstance() const { return nullptr; }
@@ -427,6 +475,9 @@ export {
 			virtual void UpdateMultiThreadedRendering(bool mtEnabled);
 			void ReloadPipelineLoader();
 			void CheckDeviceLimits();
+			// Restores the compiled stage from the shader cache, or compiles it and stores the result in the cache
+			std::shared_ptr<ShaderStageProgram> CompileShaderCached(ShaderStage stage, const std::string &shaderPath, std::string &outInfoLog, std::string &outDebugInfoLog, bool reload, const std::string &prefixCode,
+			  const std::unordered_map<std::string, std::string> &definitions);
 
 			std::shared_ptr<IImage> CreateImage(const std::vector<std::shared_ptr<pragma::image::ImageBuffer>> &imgBuffer, const std::optional<util::ImageCreateInfo> &createInfo = {});
 			virtual std::shared_ptr<IImageView> DoCreateImageView(const util::ImageViewCreateInfo &createInfo, IImage &img, Format format, ImageViewType imgViewType, ImageAspectFlags aspectMask, uint32_t numLayers) = 0;
@@ -467,6 +518,10 @@ export {
 			std::shared_ptr<IPrimaryCommandBuffer> m_setupCmdBuffer = nullptr;
 			std::vector<ShaderPipeline> m_shaderPipelines;
 			std::unique_ptr<ShaderPipelineLoader> m_pipelineLoader;
+			std::unique_ptr<ShaderHotReloader> m_shaderHotReloader;
+			// Loader threads keep a reference to the cache while they're using it, so it can be disabled at any time
+			std::shared_ptr<ShaderCache> m_shaderCache;
+			mutable std::mutex m_shaderCacheMutex;
 
 			uint8_t m_currentFrame = 0;
 			uint8_t m_maxFramesInFlight = 2;
@@ -481,6 +536,14 @@ export {
 			std::shared_ptr<IDynamicResizableBuffer> m_tmpBuffer = nullptr;
 			std::mutex m_tmpBufferMutex;
 			std::vector<std::shared_ptr<IDynamicResizableBuffer>> m_deviceImgBuffers = {};
+			std::unique_ptr<DeviceImageBufferDefragmenter> m_deviceImgBufferDefragmenter;
+			bool m_deviceImgBufferDefragmentationEnabled = false;
+			std::unique_ptr<StagingUploader> m_stagingUploader;
+			std::shared_ptr<DescriptorSetCache> m_descriptorSetCache;
+			std::unique_ptr<DescriptorWriteBatcher> m_descriptorWriteBatcher;
+			std::unique_ptr<CommandRecordThreadPool> m_commandRecordThreadPool;
+			std::unique_ptr<ImageReadback> m_imageReadback;
+			std::unique_ptr<FrameRingAllocator> m_frameRingAllocator;
 			std::mutex m_aliveResourceMutex;
 			pragma::util::LogHandler m_logHandler;
 			std::function<bool(pragma::util::LogSeverity)> m_logHandlerLevel;
@@ -488,6 +551,8 @@ export {
 			std::function<void()> m_endProfiling;
 
 			std::queue<std::function<void(IPrimaryCommandBuffer &)>> m_scheduledBufferUpdates;
+			std::unique_ptr<BufferUpdateQueue> m_bufferUpdateQueue;
+			std::unique_ptr<SwapBufferUpdateArena> m_swapBufferUpdateArena;
 
 			WindowSettings m_initialWindowSettings {};
 
@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:descriptor_set_cache;
+
+export import :descriptor_set_group;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		// Shares descriptor set groups between users that bind the same resources with the same layout.
+		// Groups are reference-counted, once the last user has released a group, it is kept around until all frames in flight have completed
+		// and then moved to a free list of its layout, from which it can be recycled for a different set of resources. Each free list holds
+		// up to maxFreeSetsPerLayout groups, any further released groups are destroyed.
+		class DLLPROSPER DescriptorSetCache : public std::enable_shared_from_this<DescriptorSetCache> {
+		  public:
+			struct DLLPROSPER Stats {
+				uint64_t numRequests = 0;
+				uint64_t numHits = 0;
+				uint64_t numCreated = 0;
+				uint64_t numRecycled = 0;
+				uint32_t numLiveSets = 0;    // Sets that are currently in use
+				uint32_t numPendingSets = 0; // Released sets that may still be used by frames in flight
+				uint32_t numFreeSets = 0;    // Sets in the free lists
+				double GetHitRate() const { return (numRequests > 0) ? (numHits / static_cast<double>(numRequests)) : 0.0; }
+			};
+			// The resources to bind to a descriptor set. Bindings have to be specified in the same order to produce a cache hit.
+			class DLLPROSPER Resources {
+			  public:
+				Resources &SetStorageImage(uint32_t bindingIdx, Texture &texture, std::optional<uint32_t> layerId = {});
+				Resources &SetTexture(uint32_t bindingIdx, Texture &texture, std::optional<uint32_t> layerId = {});
+				Resources &SetArrayTexture(uint32_t bindingIdx, uint32_t arrayIndex, Texture &texture, std::optional<uint32_t> layerId = {});
+				Resources &SetUniformBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset = 0ull, uint64_t size = std::numeric_limits<uint64_t>::max());
+				Resources &SetDynamicUniformBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset = 0ull, uint64_t size = std::numeric_limits<uint64_t>::max());
+				Resources &SetStorageBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset = 0ull, uint64_t size = std::numeric_limits<uint64_t>::max());
+				Resources &SetDynamicStorageBuffer(uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset = 0ull, uint64_t size = std::numeric_limits<uint64_t>::max());
+			  private:
+				friend DescriptorSetCache;
+				struct Resource {
+					DescriptorSetBinding::Type type;
+					uint32_t bindingIndex = 0;
+					uint32_t arrayIndex = 0;
+					std::optional<uint32_t> layerId {};
+					uint64_t startOffset = 0;
+					uint64_t size = 0;
+					std::shared_ptr<Texture> texture {};
+					std::shared_ptr<IBuffer> buffer {};
+				};
+				Resources &AddTexture(DescriptorSetBinding::Type type, uint32_t bindingIdx, uint32_t arrayIndex, Texture &texture, std::optional<uint32_t> layerId);
+				Resources &AddBuffer(DescriptorSetBinding::Type type, uint32_t bindingIdx, IBuffer &buffer, uint64_t startOffset, uint64_t size);
+				std::vector<Resource> m_resources;
+			};
+
+			DescriptorSetCache(IPrContext &context, uint32_t maxFreeSetsPerLayout = 64);
+			~DescriptorSetCache();
+			DescriptorSetCache(const DescriptorSetCache &) = delete;
+			DescriptorSetCache &operator=(const DescriptorSetCache &) = delete;
+
+			// Returns a descriptor set group with the specified resources bound to its first descriptor set. The returned group is shared
+			// with other users of the same resources, so its bindings must not be changed.
+			std::shared_ptr<IDescriptorSetGroup> Acquire(const DescriptorSetCreateInfo &createInfo, const Resources &resources);
+			// Same as Acquire, but the group is never shared with other users, so its bindings may be changed freely.
+			// Only recycles free groups of the same layout.
+			std::shared_ptr<IDescriptorSetGroup> AcquireExclusive(const DescriptorSetCreateInfo &createInfo, const Resources &resources);
+			// Moves released sets whose frames have completed to the free lists. Called once per frame.
+			void Update();
+			// Releases all free sets
+			void Clear();
+
+			Stats GetStats() const;
+		  private:
+			struct LayoutBinding {
+				uint32_t bindingIndex;
+				DescriptorType descriptorType;
+				uint32_t descriptorArraySize;
+				ShaderStageFlags stageFlags;
+				DescriptorBindingFlags flags;
+				PrDescriptorSetBindingFlags prFlags;
+				bool immutableSamplers;
+				bool operator==(const LayoutBinding &other) const = default;
+			};
+			struct ResourceKey {
+				DescriptorSetBinding::Type type;
+				uint32_t bindingIndex;
+				uint32_t arrayIndex;
+				std::optional<uint32_t> layerId;
+				uint64_t startOffset;
+				uint64_t size;
+				const void *resource;
+				bool operator==(const ResourceKey &other) const = default;
+			};
+			struct Key {
+				uint32_t layoutIndex;
+				std::vector<ResourceKey> resources;
+				size_t hash;
+				bool operator==(const Key &other) const { return hash == other.hash && layoutIndex == other.layoutIndex && resources == other.resources; }
+			};
+			struct KeyHash {
+				size_t operator()(const Key &key) const { return key.hash; }
+			};
+			struct Layout {
+				std::vector<LayoutBinding> bindings;
+				std::deque<uint64_t> freeEntries; // Oldest first
+			};
+			struct Lease;
+			struct Entry {
+				enum class State : uint8_t {
+					Live = 0,
+					Pending, // Released, but may still be in use by a frame in flight
+					Free,
+				};
+				std::optional<Key> key {}; // Empty if the entry is exclusive or can't be reused for its resources anymore
+				uint32_t layoutIndex = 0;
+				std::shared_ptr<IDescriptorSetGroup> descriptorSetGroup;
+				std::vector<std::weak_ptr<void>> resources; // Used to detect resources that have been destroyed, since their addresses may be reused
+				std::weak_ptr<Lease> lease;
+				uint64_t leaseGeneration = 0; // Incremented for every new lease, so that releases of outdated leases can be ignored
+				State state = State::Free; // Until the first lease is created
+				uint64_t releaseFrame = 0;
+			};
+			uint32_t FindLayout(const DescriptorSetCreateInfo &createInfo);
+			std::shared_ptr<IDescriptorSetGroup> CreateLease(uint64_t entryId, Entry &entry);
+			void OnLeaseReleased(uint64_t entryId, uint64_t generation);
+			std::optional<uint64_t> PopFreeEntry(Layout &layout);
+			// Recycles a free entry of the layout or creates a new one, and binds the resources
+			std::optional<uint64_t> AllocateEntry(const DescriptorSetCreateInfo &createInfo, uint32_t layoutIndex, const Resources &resources);
+			void DetachKey(uint64_t entryId, Entry &entry);
+
+			IPrContext &m_context;
+			mutable std::mutex m_mutex;
+			std::vector<Layout> m_layouts;
+			std::unordered_map<Key, uint64_t, KeyHash> m_keyToEntry;
+			std::unordered_map<uint64_t, Entry> m_entries;
+			std::unordered_set<uint64_t> m_pendingEntries;
+			uint64_t m_nextEntryId = 0;
+			uint32_t m_maxFreeSetsPerLayout = 0;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
@@ -127,7 +127,17 @@ export {
 			std::vector<std::unique_ptr<DescriptorSetBinding>> &GetBindings();
 			const std::vector<std::unique_ptr<DescriptorSetBinding>> &GetBindings() const;
 			DescriptorSetBinding &SetBinding(uint32_t bindingIndex, std::unique_ptr<DescriptorSetBinding> binding);
-			virtual bool Update() = 0;
+			// Writes all bindings. The base implementation clears the dirty bindings and has to be called by the backend.
+			virtual bool Update();
+
+			// Bindings that have been changed since the last update. A descriptor set is enqueued in the context's DescriptorWriteBatcher
+			// when it becomes dirty, so the changed bindings are written at the start of the next frame if Update isn't called explicitly.
+			bool HasDirtyBindings() const;
+			size_t GetDirtyBindingCount() const;
+			std::vector<uint32_t> GetDirtyBindings() const;
+			void ClearDirtyBindings();
+			// Only writes the bindings that have changed, does nothing if there are none
+			bool UpdateDirtyBindings();
 
 			Texture *GetBoundArrayTexture(uint32_t bindingIndex, uint32_t index);
 			uint32_t GetBoundArrayTextureCount(uint32_t bindingIndex) const;
@@ -168,10 +178,15 @@ export {
 			virtual bool DoSetBindingDynamicUniformBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size) = 0;
 			virtual bool DoSetBindingStorageBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size) = 0;
 			virtual bool DoSetBindingDynamicStorageBuffer(IBuffer &buffer, uint32_t bindingIdx, uint64_t startOffset, uint64_t size) = 0;
+			// Backends should override this to only write the specified bindings, by default the entire set is updated
+			virtual bool DoUpdateBindings(const std::vector<uint32_t> &bindingIndices) { return Update(); }
 			void *m_apiTypePtr = nullptr;
 		  private:
+			bool MarkBindingDirty(uint32_t bindingIdx, bool result);
 			IDescriptorSetGroup &m_dsg;
 			std::vector<std::unique_ptr<DescriptorSetBinding>> m_bindings = {};
+			std::vector<uint32_t> m_dirtyBindings;
+			mutable std::mutex m_dirtyBindingsMutex;
 		};
 
 		class DLLPROSPER IDescriptorSetGroup : public ContextObject, public std::enable_shared_from_this<IDescriptorSetGroup> {
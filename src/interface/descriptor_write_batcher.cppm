@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:descriptor_write_batcher;
+
+export import :descriptor_set_group;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		// Collects descriptor sets with changed bindings and writes all of them with a single backend call (see IPrContext::UpdateDescriptorSets).
+		// Descriptor sets are enqueued automatically when one of their bindings is changed, and the pending writes are flushed once per frame
+		// before the frame is recorded. Descriptor sets must not be written while a command buffer that uses them is being recorded or executed.
+		class DLLPROSPER DescriptorWriteBatcher {
+		  public:
+			struct DLLPROSPER Stats {
+				uint64_t numFlushes = 0;
+				uint64_t numDescriptorSets = 0;
+				uint64_t numBindingWrites = 0;
+			};
+			DescriptorWriteBatcher(IPrContext &context);
+			DescriptorWriteBatcher(const DescriptorWriteBatcher &) = delete;
+			DescriptorWriteBatcher &operator=(const DescriptorWriteBatcher &) = delete;
+
+			// Schedules the dirty bindings of the descriptor set to be written with the next flush. Can be called from any thread.
+			void Enqueue(IDescriptorSet &descSet);
+			// Writes all pending descriptor sets. Has to be called from the main thread.
+			void Flush();
+			// Discards all pending writes
+			void Clear();
+
+			const Stats &GetStats() const { return m_stats; }
+		  private:
+			struct PendingSet {
+				std::weak_ptr<IDescriptorSetGroup> descriptorSetGroup;
+				IDescriptorSet *descriptorSet;
+			};
+			IPrContext &m_context;
+			std::mutex m_mutex;
+			std::vector<PendingSet> m_pendingSets;
+			std::unordered_set<const IDescriptorSet *> m_queuedSets;
+			std::vector<IDescriptorSet *> m_flushSets;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
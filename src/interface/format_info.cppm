@@ -0,0 +1,280 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:format_info;
+
+export import :enums;
+
+export namespace prosper::util {
+	enum class FormatNumericType : uint8_t { Unknown = 0, UNorm, SNorm, UScaled, SScaled, UInt, SInt, UFloat, SFloat, SRGB };
+	struct FormatInfo {
+		Format format = Format::Unknown;
+		uint16_t bitSize = 0;   // Bits per texel, 0 for compressed formats. For combined depth-stencil formats only the depth bits are counted.
+		uint8_t blockSize = 0;  // Bytes per block, only set for compressed formats
+		uint8_t blockWidth = 1; // Block extents in texels
+		uint8_t blockHeight = 1;
+		uint8_t componentCount = 0;
+		uint8_t componentBits = 0; // Bits per component if all components have the same size, otherwise 0
+		FormatNumericType numericType = FormatNumericType::Unknown;
+		ImageAspectFlags aspect {};
+		bool hasAlpha = false;
+		bool packed = false;
+
+		constexpr bool IsCompressed() const { return blockSize > 0; }
+		constexpr bool IsSrgb() const { return numericType == FormatNumericType::SRGB; }
+		constexpr bool HasDepth() const { return (static_cast<uint32_t>(aspect) & static_cast<uint32_t>(ImageAspectFlags::DepthBit)) != 0; }
+		constexpr bool HasStencil() const { return (static_cast<uint32_t>(aspect) & static_cast<uint32_t>(ImageAspectFlags::StencilBit)) != 0; }
+	};
+};
+
+namespace prosper::util::detail {
+	constexpr FormatInfo color(Format format, uint16_t bitSize, uint8_t componentCount, uint8_t componentBits, FormatNumericType numericType, bool hasAlpha, bool packed)
+	{
+		return FormatInfo {format, bitSize, 0, 1, 1, componentCount, componentBits, numericType, ImageAspectFlags::ColorBit, hasAlpha, packed};
+	}
+	constexpr FormatInfo depth_stencil(Format format, uint16_t bitSize, uint8_t componentCount, uint8_t componentBits, FormatNumericType numericType, bool depth, bool stencil)
+	{
+		auto aspect = (depth ? static_cast<uint32_t>(ImageAspectFlags::DepthBit) : 0u) | (stencil ? static_cast<uint32_t>(ImageAspectFlags::StencilBit) : 0u);
+		return FormatInfo {format, bitSize, 0, 1, 1, componentCount, componentBits, numericType, static_cast<ImageAspectFlags>(aspect), false, false};
+	}
+	constexpr FormatInfo compressed(Format format, uint8_t blockSize, uint8_t blockWidth, uint8_t blockHeight, uint8_t componentCount, FormatNumericType numericType, bool hasAlpha)
+	{
+		return FormatInfo {format, 0, blockSize, blockWidth, blockHeight, componentCount, 0, numericType, ImageAspectFlags::ColorBit, hasAlpha, false};
+	}
+};
+
+export namespace prosper::util {
+	inline constexpr size_t FORMAT_COUNT = static_cast<size_t>(Format::ASTC_12x12_SRGB_Block_PoorCoverage) + 1;
+	// Indexed by the numeric value of the format
+	inline constexpr std::array<FormatInfo, FORMAT_COUNT> FORMAT_INFOS = [] {
+		using namespace detail;
+		return std::array<FormatInfo, FORMAT_COUNT> {
+			FormatInfo {},
+			color(Format::R4G4_UNorm_Pack8, 8, 2, 4, FormatNumericType::UNorm, false, true),
+			color(Format::R4G4B4A4_UNorm_Pack16, 16, 4, 4, FormatNumericType::UNorm, true, true),
+			color(Format::B4G4R4A4_UNorm_Pack16, 16, 4, 4, FormatNumericType::UNorm, true, true),
+			color(Format::R5G6B5_UNorm_Pack16, 16, 3, 0, FormatNumericType::UNorm, false, true),
+			color(Format::B5G6R5_UNorm_Pack16, 16, 3, 0, FormatNumericType::UNorm, false, true),
+			color(Format::R5G5B5A1_UNorm_Pack16, 16, 4, 0, FormatNumericType::UNorm, true, true),
+			color(Format::B5G5R5A1_UNorm_Pack16, 16, 4, 0, FormatNumericType::UNorm, true, true),
+			color(Format::A1R5G5B5_UNorm_Pack16, 16, 4, 0, FormatNumericType::UNorm, true, true),
+			color(Format::R8_UNorm, 8, 1, 8, FormatNumericType::UNorm, false, false),
+			color(Format::R8_SNorm, 8, 1, 8, FormatNumericType::SNorm, false, false),
+			color(Format::R8_UScaled_PoorCoverage, 8, 1, 8, FormatNumericType::UScaled, false, false),
+			color(Format::R8_SScaled_PoorCoverage, 8, 1, 8, FormatNumericType::SScaled, false, false),
+			color(Format::R8_UInt, 8, 1, 8, FormatNumericType::UInt, false, false),
+			color(Format::R8_SInt, 8, 1, 8, FormatNumericType::SInt, false, false),
+			color(Format::R8_SRGB, 8, 1, 8, FormatNumericType::SRGB, false, false),
+			color(Format::R8G8_UNorm, 16, 2, 8, FormatNumericType::UNorm, false, false),
+			color(Format::R8G8_SNorm, 16, 2, 8, FormatNumericType::SNorm, false, false),
+			color(Format::R8G8_UScaled_PoorCoverage, 16, 2, 8, FormatNumericType::UScaled, false, false),
+			color(Format::R8G8_SScaled_PoorCoverage, 16, 2, 8, FormatNumericType::SScaled, false, false),
+			color(Format::R8G8_UInt, 16, 2, 8, FormatNumericType::UInt, false, false),
+			color(Format::R8G8_SInt, 16, 2, 8, FormatNumericType::SInt, false, false),
+			color(Format::R8G8_SRGB_PoorCoverage, 16, 2, 8, FormatNumericType::SRGB, false, false),
+			color(Format::R8G8B8_UNorm_PoorCoverage, 24, 3, 8, FormatNumericType::UNorm, false, false),
+			color(Format::R8G8B8_SNorm_PoorCoverage, 24, 3, 8, FormatNumericType::SNorm, false, false),
+			color(Format::R8G8B8_UScaled_PoorCoverage, 24, 3, 8, FormatNumericType::UScaled, false, false),
+			color(Format::R8G8B8_SScaled_PoorCoverage, 24, 3, 8, FormatNumericType::SScaled, false, false),
+			color(Format::R8G8B8_UInt_PoorCoverage, 24, 3, 8, FormatNumericType::UInt, false, false),
+			color(Format::R8G8B8_SInt_PoorCoverage, 24, 3, 8, FormatNumericType::SInt, false, false),
+			color(Format::R8G8B8_SRGB_PoorCoverage, 24, 3, 8, FormatNumericType::SRGB, false, false),
+			color(Format::B8G8R8_UNorm_PoorCoverage, 24, 3, 8, FormatNumericType::UNorm, false, false),
+			color(Format::B8G8R8_SNorm_PoorCoverage, 24, 3, 8, FormatNumericType::SNorm, false, false),
+			color(Format::B8G8R8_UScaled_PoorCoverage, 24, 3, 8, FormatNumericType::UScaled, false, false),
+			color(Format::B8G8R8_SScaled_PoorCoverage, 24, 3, 8, FormatNumericType::SScaled, false, false),
+			color(Format::B8G8R8_UInt_PoorCoverage, 24, 3, 8, FormatNumericType::UInt, false, false),
+			color(Format::B8G8R8_SInt_PoorCoverage, 24, 3, 8, FormatNumericType::SInt, false, false),
+			color(Format::B8G8R8_SRGB_PoorCoverage, 24, 3, 8, FormatNumericType::SRGB, false, false),
+			color(Format::R8G8B8A8_UNorm, 32, 4, 8, FormatNumericType::UNorm, true, false),
+			color(Format::R8G8B8A8_SNorm, 32, 4, 8, FormatNumericType::SNorm, true, false),
+			color(Format::R8G8B8A8_UScaled_PoorCoverage, 32, 4, 8, FormatNumericType::UScaled, true, false),
+			color(Format::R8G8B8A8_SScaled_PoorCoverage, 32, 4, 8, FormatNumericType::SScaled, true, false),
+			color(Format::R8G8B8A8_UInt, 32, 4, 8, FormatNumericType::UInt, true, false),
+			color(Format::R8G8B8A8_SInt, 32, 4, 8, FormatNumericType::SInt, true, false),
+			color(Format::R8G8B8A8_SRGB, 32, 4, 8, FormatNumericType::SRGB, true, false),
+			color(Format::B8G8R8A8_UNorm, 32, 4, 8, FormatNumericType::UNorm, true, false),
+			color(Format::B8G8R8A8_SNorm, 32, 4, 8, FormatNumericType::SNorm, true, false),
+			color(Format::B8G8R8A8_UScaled_PoorCoverage, 32, 4, 8, FormatNumericType::UScaled, true, false),
+			color(Format::B8G8R8A8_SScaled_PoorCoverage, 32, 4, 8, FormatNumericType::SScaled, true, false),
+			color(Format::B8G8R8A8_UInt, 32, 4, 8, FormatNumericType::UInt, true, false),
+			color(Format::B8G8R8A8_SInt, 32, 4, 8, FormatNumericType::SInt, true, false),
+			color(Format::B8G8R8A8_SRGB, 32, 4, 8, FormatNumericType::SRGB, true, false),
+			color(Format::A8B8G8R8_UNorm_Pack32, 32, 4, 8, FormatNumericType::UNorm, true, true),
+			color(Format::A8B8G8R8_SNorm_Pack32, 32, 4, 8, FormatNumericType::SNorm, true, true),
+			color(Format::A8B8G8R8_UScaled_Pack32_PoorCoverage, 32, 4, 8, FormatNumericType::UScaled, true, true),
+			color(Format::A8B8G8R8_SScaled_Pack32_PoorCoverage, 32, 4, 8, FormatNumericType::SScaled, true, true),
+			color(Format::A8B8G8R8_UInt_Pack32, 32, 4, 8, FormatNumericType::UInt, true, true),
+			color(Format::A8B8G8R8_SInt_Pack32, 32, 4, 8, FormatNumericType::SInt, true, true),
+			color(Format::A8B8G8R8_SRGB_Pack32, 32, 4, 8, FormatNumericType::SRGB, true, true),
+			color(Format::A2R10G10B10_UNorm_Pack32, 32, 4, 0, FormatNumericType::UNorm, true, true),
+			color(Format::A2R10G10B10_SNorm_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::SNorm, true, true),
+			color(Format::A2R10G10B10_UScaled_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::UScaled, true, true),
+			color(Format::A2R10G10B10_SScaled_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::SScaled, true, true),
+			color(Format::A2R10G10B10_UInt_Pack32, 32, 4, 0, FormatNumericType::UInt, true, true),
+			color(Format::A2R10G10B10_SInt_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::SInt, true, true),
+			color(Format::A2B10G10R10_UNorm_Pack32, 32, 4, 0, FormatNumericType::UNorm, true, true),
+			color(Format::A2B10G10R10_SNorm_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::SNorm, true, true),
+			color(Format::A2B10G10R10_UScaled_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::UScaled, true, true),
+			color(Format::A2B10G10R10_SScaled_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::SScaled, true, true),
+			color(Format::A2B10G10R10_UInt_Pack32, 32, 4, 0, FormatNumericType::UInt, true, true),
+			color(Format::A2B10G10R10_SInt_Pack32_PoorCoverage, 32, 4, 0, FormatNumericType::SInt, true, true),
+			color(Format::R16_UNorm, 16, 1, 16, FormatNumericType::UNorm, false, false),
+			color(Format::R16_SNorm, 16, 1, 16, FormatNumericType::SNorm, false, false),
+			color(Format::R16_UScaled_PoorCoverage, 16, 1, 16, FormatNumericType::UScaled, false, false),
+			color(Format::R16_SScaled_PoorCoverage, 16, 1, 16, FormatNumericType::SScaled, false, false),
+			color(Format::R16_UInt, 16, 1, 16, FormatNumericType::UInt, false, false),
+			color(Format::R16_SInt, 16, 1, 16, FormatNumericType::SInt, false, false),
+			color(Format::R16_SFloat, 16, 1, 16, FormatNumericType::SFloat, false, false),
+			color(Format::R16G16_UNorm, 32, 2, 16, FormatNumericType::UNorm, false, false),
+			color(Format::R16G16_SNorm, 32, 2, 16, FormatNumericType::SNorm, false, false),
+			color(Format::R16G16_UScaled_PoorCoverage, 32, 2, 16, FormatNumericType::UScaled, false, false),
+			color(Format::R16G16_SScaled_PoorCoverage, 32, 2, 16, FormatNumericType::SScaled, false, false),
+			color(Format::R16G16_UInt, 32, 2, 16, FormatNumericType::UInt, false, false),
+			color(Format::R16G16_SInt, 32, 2, 16, FormatNumericType::SInt, false, false),
+			color(Format::R16G16_SFloat, 32, 2, 16, FormatNumericType::SFloat, false, false),
+			color(Format::R16G16B16_UNorm_PoorCoverage, 48, 3, 16, FormatNumericType::UNorm, false, false),
+			color(Format::R16G16B16_SNorm_PoorCoverage, 48, 3, 16, FormatNumericType::SNorm, false, false),
+			color(Format::R16G16B16_UScaled_PoorCoverage, 48, 3, 16, FormatNumericType::UScaled, false, false),
+			color(Format::R16G16B16_SScaled_PoorCoverage, 48, 3, 16, FormatNumericType::SScaled, false, false),
+			color(Format::R16G16B16_UInt_PoorCoverage, 48, 3, 16, FormatNumericType::UInt, false, false),
+			color(Format::R16G16B16_SInt_PoorCoverage, 48, 3, 16, FormatNumericType::SInt, false, false),
+			color(Format::R16G16B16_SFloat_PoorCoverage, 48, 3, 16, FormatNumericType::SFloat, false, false),
+			color(Format::R16G16B16A16_UNorm, 64, 4, 16, FormatNumericType::UNorm, true, false),
+			color(Format::R16G16B16A16_SNorm, 64, 4, 16, FormatNumericType::SNorm, true, false),
+			color(Format::R16G16B16A16_UScaled_PoorCoverage, 64, 4, 16, FormatNumericType::UScaled, true, false),
+			color(Format::R16G16B16A16_SScaled_PoorCoverage, 64, 4, 16, FormatNumericType::SScaled, true, false),
+			color(Format::R16G16B16A16_UInt, 64, 4, 16, FormatNumericType::UInt, true, false),
+			color(Format::R16G16B16A16_SInt, 64, 4, 16, FormatNumericType::SInt, true, false),
+			color(Format::R16G16B16A16_SFloat, 64, 4, 16, FormatNumericType::SFloat, true, false),
+			color(Format::R32_UInt, 32, 1, 32, FormatNumericType::UInt, false, false),
+			color(Format::R32_SInt, 32, 1, 32, FormatNumericType::SInt, false, false),
+			color(Format::R32_SFloat, 32, 1, 32, FormatNumericType::SFloat, false, false),
+			color(Format::R32G32_UInt, 64, 2, 32, FormatNumericType::UInt, false, false),
+			color(Format::R32G32_SInt, 64, 2, 32, FormatNumericType::SInt, false, false),
+			color(Format::R32G32_SFloat, 64, 2, 32, FormatNumericType::SFloat, false, false),
+			color(Format::R32G32B32_UInt, 96, 3, 32, FormatNumericType::UInt, false, false),
+			color(Format::R32G32B32_SInt, 96, 3, 32, FormatNumericType::SInt, false, false),
+			color(Format::R32G32B32_SFloat, 96, 3, 32, FormatNumericType::SFloat, false, false),
+			color(Format::R32G32B32A32_UInt, 128, 4, 32, FormatNumericType::UInt, true, false),
+			color(Format::R32G32B32A32_SInt, 128, 4, 32, FormatNumericType::SInt, true, false),
+			color(Format::R32G32B32A32_SFloat, 128, 4, 32, FormatNumericType::SFloat, true, false),
+			color(Format::R64_UInt_PoorCoverage, 64, 1, 64, FormatNumericType::UInt, false, false),
+			color(Format::R64_SInt_PoorCoverage, 64, 1, 64, FormatNumericType::SInt, false, false),
+			color(Format::R64_SFloat_PoorCoverage, 64, 1, 64, FormatNumericType::SFloat, false, false),
+			color(Format::R64G64_UInt_PoorCoverage, 128, 2, 64, FormatNumericType::UInt, false, false),
+			color(Format::R64G64_SInt_PoorCoverage, 128, 2, 64, FormatNumericType::SInt, false, false),
+			color(Format::R64G64_SFloat_PoorCoverage, 128, 2, 64, FormatNumericType::SFloat, false, false),
+			color(Format::R64G64B64_UInt_PoorCoverage, 192, 3, 64, FormatNumericType::UInt, false, false),
+			color(Format::R64G64B64_SInt_PoorCoverage, 192, 3, 64, FormatNumericType::SInt, false, false),
+			color(Format::R64G64B64_SFloat_PoorCoverage, 192, 3, 64, FormatNumericType::SFloat, false, false),
+			color(Format::R64G64B64A64_UInt_PoorCoverage, 256, 4, 64, FormatNumericType::UInt, true, false),
+			color(Format::R64G64B64A64_SInt_PoorCoverage, 256, 4, 64, FormatNumericType::SInt, true, false),
+			color(Format::R64G64B64A64_SFloat_PoorCoverage, 256, 4, 64, FormatNumericType::SFloat, true, false),
+			color(Format::B10G11R11_UFloat_Pack32, 32, 3, 0, FormatNumericType::UFloat, false, true),
+			color(Format::E5B9G9R9_UFloat_Pack32, 32, 3, 0, FormatNumericType::UFloat, false, false),
+			depth_stencil(Format::D16_UNorm, 16, 1, 16, FormatNumericType::UNorm, true, false),
+			depth_stencil(Format::X8_D24_UNorm_Pack32_PoorCoverage, 32, 1, 24, FormatNumericType::UNorm, true, false),
+			depth_stencil(Format::D32_SFloat, 32, 1, 32, FormatNumericType::SFloat, true, false),
+			depth_stencil(Format::S8_UInt_PoorCoverage, 8, 1, 8, FormatNumericType::UInt, false, true),
+			depth_stencil(Format::D16_UNorm_S8_UInt_PoorCoverage, 16, 2, 16, FormatNumericType::UNorm, true, true),
+			depth_stencil(Format::D24_UNorm_S8_UInt_PoorCoverage, 24, 2, 24, FormatNumericType::UNorm, true, true),
+			depth_stencil(Format::D32_SFloat_S8_UInt, 32, 2, 32, FormatNumericType::SFloat, true, true),
+			compressed(Format::BC1_RGB_UNorm_Block, 8, 4, 4, 3, FormatNumericType::UNorm, false),
+			compressed(Format::BC1_RGB_SRGB_Block, 8, 4, 4, 3, FormatNumericType::SRGB, false),
+			compressed(Format::BC1_RGBA_UNorm_Block, 8, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::BC1_RGBA_SRGB_Block, 8, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::BC2_UNorm_Block, 16, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::BC2_SRGB_Block, 16, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::BC3_UNorm_Block, 16, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::BC3_SRGB_Block, 16, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::BC4_UNorm_Block, 8, 4, 4, 1, FormatNumericType::UNorm, false),
+			compressed(Format::BC4_SNorm_Block, 8, 4, 4, 1, FormatNumericType::SNorm, false),
+			compressed(Format::BC5_UNorm_Block, 16, 4, 4, 2, FormatNumericType::UNorm, false),
+			compressed(Format::BC5_SNorm_Block, 16, 4, 4, 2, FormatNumericType::SNorm, false),
+			compressed(Format::BC6H_UFloat_Block, 16, 4, 4, 3, FormatNumericType::UFloat, false),
+			compressed(Format::BC6H_SFloat_Block, 16, 4, 4, 3, FormatNumericType::SFloat, false),
+			compressed(Format::BC7_UNorm_Block, 16, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::BC7_SRGB_Block, 16, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ETC2_R8G8B8_UNorm_Block_PoorCoverage, 8, 4, 4, 3, FormatNumericType::UNorm, false),
+			compressed(Format::ETC2_R8G8B8_SRGB_Block_PoorCoverage, 8, 4, 4, 3, FormatNumericType::SRGB, false),
+			compressed(Format::ETC2_R8G8B8A1_UNorm_Block_PoorCoverage, 8, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ETC2_R8G8B8A1_SRGB_Block_PoorCoverage, 8, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ETC2_R8G8B8A8_UNorm_Block_PoorCoverage, 16, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ETC2_R8G8B8A8_SRGB_Block_PoorCoverage, 16, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::EAC_R11_UNorm_Block_PoorCoverage, 8, 4, 4, 1, FormatNumericType::UNorm, false),
+			compressed(Format::EAC_R11_SNorm_Block_PoorCoverage, 8, 4, 4, 1, FormatNumericType::SNorm, false),
+			compressed(Format::EAC_R11G11_UNorm_Block_PoorCoverage, 16, 4, 4, 2, FormatNumericType::UNorm, false),
+			compressed(Format::EAC_R11G11_SNorm_Block_PoorCoverage, 16, 4, 4, 2, FormatNumericType::SNorm, false),
+			compressed(Format::ASTC_4x4_UNorm_Block_PoorCoverage, 16, 4, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_4x4_SRGB_Block_PoorCoverage, 16, 4, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_5x4_UNorm_Block_PoorCoverage, 16, 5, 4, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_5x4_SRGB_Block_PoorCoverage, 16, 5, 4, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_5x5_UNorm_Block_PoorCoverage, 16, 5, 5, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_5x5_SRGB_Block_PoorCoverage, 16, 5, 5, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_6x5_UNorm_Block_PoorCoverage, 16, 6, 5, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_6x5_SRGB_Block_PoorCoverage, 16, 6, 5, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_6x6_UNorm_Block_PoorCoverage, 16, 6, 6, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_6x6_SRGB_Block_PoorCoverage, 16, 6, 6, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_8x5_UNorm_Block_PoorCoverage, 16, 8, 5, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_8x5_SRGB_Block_PoorCoverage, 16, 8, 5, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_8x6_UNorm_Block_PoorCoverage, 16, 8, 6, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_8x6_SRGB_Block_PoorCoverage, 16, 8, 6, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_8x8_UNorm_Block_PoorCoverage, 16, 8, 8, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_8x8_SRGB_Block_PoorCoverage, 16, 8, 8, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_10x5_UNorm_Block_PoorCoverage, 16, 10, 5, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_10x5_SRGB_Block_PoorCoverage, 16, 10, 5, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_10x6_UNorm_Block_PoorCoverage, 16, 10, 6, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_10x6_SRGB_Block_PoorCoverage, 16, 10, 6, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_10x8_UNorm_Block_PoorCoverage, 16, 10, 8, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_10x8_SRGB_Block_PoorCoverage, 16, 10, 8, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_10x10_UNorm_Block_PoorCoverage, 16, 10, 10, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_10x10_SRGB_Block_PoorCoverage, 16, 10, 10, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_12x10_UNorm_Block_PoorCoverage, 16, 12, 10, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_12x10_SRGB_Block_PoorCoverage, 16, 12, 10, 4, FormatNumericType::SRGB, true),
+			compressed(Format::ASTC_12x12_UNorm_Block_PoorCoverage, 16, 12, 12, 4, FormatNumericType::UNorm, true),
+			compressed(Format::ASTC_12x12_SRGB_Block_PoorCoverage, 16, 12, 12, 4, FormatNumericType::SRGB, true),
+		};
+	}();
+
+	constexpr const FormatInfo &get_format_info(Format format)
+	{
+		auto idx = static_cast<size_t>(format);
+		return (idx < FORMAT_INFOS.size()) ? FORMAT_INFOS[idx] : FORMAT_INFOS.front();
+	}
+};
+
+namespace prosper::util::detail {
+	consteval bool validate_format_infos()
+	{
+		for(auto i = decltype(FORMAT_INFOS.size()) {0u}; i < FORMAT_INFOS.size(); ++i) {
+			auto &info = FORMAT_INFOS[i];
+			if(info.format != static_cast<Format>(i))
+				return false;
+			if(info.format == Format::Unknown)
+				continue;
+			if(info.IsCompressed()) {
+				if(info.bitSize != 0 || info.blockWidth < 4 || info.blockHeight < 4 || (info.blockSize != 8 && info.blockSize != 16))
+					return false;
+			}
+			else if(info.bitSize == 0 || info.blockWidth != 1 || info.blockHeight != 1)
+				return false;
+			if(info.componentCount == 0 || info.componentCount > 4)
+				return false;
+			if(!info.HasDepth() && !info.HasStencil() && info.componentBits != 0 && info.componentBits * info.componentCount != info.bitSize)
+				return false;
+		}
+		return true;
+	}
+};
+
+// Compile-time check of the table against the Format enum
+namespace prosper::util {
+	static_assert(detail::validate_format_infos(), "Format info table is inconsistent with the Format enum");
+	static_assert(get_format_info(Format::R8G8B8A8_UNorm).bitSize == 32 && get_format_info(Format::R8G8B8A8_UNorm).hasAlpha);
+	static_assert(get_format_info(Format::BC1_RGB_UNorm_Block).blockSize == 8 && !get_format_info(Format::BC1_RGB_UNorm_Block).hasAlpha);
+	static_assert(get_format_info(Format::BC7_SRGB_Block).blockSize == 16 && get_format_info(Format::BC7_SRGB_Block).IsSrgb());
+	static_assert(get_format_info(Format::ASTC_10x8_UNorm_Block_PoorCoverage).blockWidth == 10 && get_format_info(Format::ASTC_10x8_UNorm_Block_PoorCoverage).blockHeight == 8);
+	static_assert(get_format_info(Format::D32_SFloat_S8_UInt).HasDepth() && get_format_info(Format::D32_SFloat_S8_UInt).HasStencil());
+	static_assert(!get_format_info(Format::S8_UInt_PoorCoverage).HasDepth());
+};
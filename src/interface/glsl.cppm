@@ -31,6 +31,7 @@ export namespace prosper {
 		};
 		DLLPROSPER void set_global_include_file_cache_enabled(bool enabled);
 		DLLPROSPER bool is_global_include_file_cache_enabled();
+		DLLPROSPER void clear_global_include_file_cache();
 		DLLPROSPER const std::vector<std::string> &get_glsl_file_extensions();
 		DLLPROSPER std::string get_shader_file_extension(ShaderStage stage);
 		DLLPROSPER bool is_glsl_file_extension(const std::string &ext);
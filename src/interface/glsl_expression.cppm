@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:glsl_expression;
+
+export import std.compat;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper::glsl {
+		// Evaluator for the constant expressions of preprocessor definitions. Supports integer and floating point literals, references to other
+		// definitions, parentheses as well as the arithmetic, bitwise, logical, comparison and ternary operators of GLSL.
+		// For compatibility with the previous evaluator, "^" is the power operator instead of a bitwise xor, and "pi" and "e" are built-in constants.
+		// Expressions are compiled to a small stack program, which is cached by the expression string.
+		class DLLPROSPER ConstantExpression {
+		  public:
+			// Returns nullptr if the expression contains constructs that aren't supported (e.g. function calls)
+			static std::shared_ptr<const ConstantExpression> Compile(const std::string &expression);
+			// Same as Compile, but returns the cached program if the expression has been compiled before
+			static std::shared_ptr<const ConstantExpression> Get(const std::string &expression);
+
+			// Names of the definitions referenced by the expression, in the order expected by Evaluate
+			const std::vector<std::string> &GetVariables() const { return m_variables; }
+			std::optional<double> Evaluate(const std::vector<double> &variableValues) const;
+		  private:
+			enum class OpCode : uint8_t {
+				Constant = 0,
+				Variable,
+
+				Negate,
+				LogicalNot,
+				BitwiseNot,
+
+				Power,
+				Multiply,
+				Divide,
+				Modulo,
+				Add,
+				Subtract,
+				ShiftLeft,
+				ShiftRight,
+				Less,
+				LessEqual,
+				Greater,
+				GreaterEqual,
+				Equal,
+				NotEqual,
+				BitwiseAnd,
+				BitwiseOr,
+				LogicalAnd,
+				LogicalOr,
+
+				Select,
+			};
+			struct Instruction {
+				OpCode opCode;
+				double value = 0.0;    // Constant
+				uint32_t variable = 0; // Variable index
+			};
+			class Compiler;
+			ConstantExpression() = default;
+			std::vector<Instruction> m_program;
+			std::vector<std::string> m_variables;
+			uint32_t m_maxStackSize = 0;
+		};
+	};
+#pragma warning(pop)
+}
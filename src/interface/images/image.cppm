@@ -3,6 +3,7 @@
 
 export module pragma.prosper:image.image;
 
+export import :block_compression;
 export import :context_object;
 export import :structs;
 import pragma.image;
@@ -64,7 +65,13 @@ export {
 			virtual bool Map(DeviceSize offset, DeviceSize size, void **outPtr = nullptr) = 0;
 			virtual bool Unmap() = 0;
 			std::shared_ptr<pragma::image::ImageBuffer> ToHostImageBuffer(pragma::image::Format format, ImageLayout curImgLayout) const;
-			std::shared_ptr<IImage> Copy(ICommandBuffer &cmd, const util::ImageCreateInfo &copyCreateInfo);
+			// Non-blocking versions of ToHostImageBuffer, see ImageReadback. The callback is invoked on the main thread, the future must not be waited for on the main thread.
+			// The image has to be in the specified layout at the start of the next frame.
+			void ToHostImageBufferAsync(pragma::image::Format format, ImageLayout curImgLayout, const std::function<void(std::shared_ptr<pragma::image::ImageBuffer>)> &callback) const;
+			std::future<std::shared_ptr<pragma::image::ImageBuffer>> ToHostImageBufferAsync(pragma::image::Format format, ImageLayout curImgLayout) const;
+			// If the target format is block-compressed, the image data is compressed on the CPU. BC1, BC3, BC4 and BC5 are encoded natively using
+			// compressionInfo, all other compressed formats go through the image library.
+			std::shared_ptr<IImage> Copy(ICommandBuffer &cmd, const util::ImageCreateInfo &copyCreateInfo, const util::BlockCompressionInfo &compressionInfo = {});
 			bool Copy(ICommandBuffer &cmd, IImage &imgDst);
 			std::shared_ptr<IImage> Convert(ICommandBuffer &cmd, Format newFormat);
 		  protected:
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:pixel_conversion;
+
+export import :types;
+
+export namespace prosper::util {
+	enum class PixelConversionIsa : uint8_t {
+		Scalar = 0,
+		SSE41,
+		AVX2, // Also requires F16C
+		NEON,
+	};
+	// Returns the best instruction set that is supported by the current CPU
+	DLLPROSPER PixelConversionIsa get_pixel_conversion_isa();
+	// Host conversions are supported between 8-bit UNorm/sRGB, 16-bit float and 32-bit float formats with one to four channels, in RGBA or BGRA order.
+	// Missing channels are filled in with 0 (color) or 1 (alpha).
+	DLLPROSPER bool is_pixel_conversion_supported(Format srcFormat, Format dstFormat);
+	// Converts tightly packed pixels on the CPU. If isa is set, no instruction set higher than isa is used; every instruction set produces
+	// bit-identical results to the scalar path. Returns false if the conversion is not supported.
+	DLLPROSPER bool convert_pixels(const void *src, Format srcFormat, void *dst, Format dstFormat, size_t numPixels, std::optional<PixelConversionIsa> isa = {});
+};
@@ -14,6 +14,12 @@ export {
 		class PreparedCommandBuffer;
 		struct PreparedCommand;
 		struct PreparedCommandArgumentMap;
+		// Argument of a compiled prepared command buffer, see PreparedCommandBuffer::Compile
+		struct DLLPROSPER CompiledCommandArgument {
+			enum class Source : uint8_t { Static = 0, Dynamic };
+			Source source = Source::Static;
+			uint32_t index = 0; // Index into the static values or the dynamic argument slots
+		};
 		struct DLLPROSPER PreparedCommandBufferUserData {
 			using StringHash = uint32_t;
 			template<typename T>
@@ -40,6 +46,9 @@ export {
 			const PreparedCommandArgumentMap &drawArguments;
 			const PreparedCommandBufferUserData &userData;
 			const PreparedCommand *curCommand;
+			// Only set if the command buffer has been compiled
+			const CompiledCommandArgument *curCompiledArguments = nullptr;
+			const udm::Property *const *dynamicArgumentValues = nullptr;
 			mutable std::unique_ptr<ShaderBindState> shaderBindState;
 			template<typename T>
 			T GetArgument(uint32_t idx) const;
@@ -77,6 +86,11 @@ export {
 			PreparedCommandArgumentMap() = default;
 			~PreparedCommandArgumentMap();
 			std::unordered_map<PreparedCommand::Argument::StringHash, udm::Property *> arguments;
+			udm::Property *FindArgument(PreparedCommand::Argument::StringHash hash) const
+			{
+				auto it = arguments.find(hash);
+				return (it != arguments.end()) ? it->second : nullptr;
+			}
 			template<typename T>
 			void SetArgumentValue(const std::string &name, T &&value)
 			{
@@ -139,16 +153,61 @@ export {
 				}
 			}
 			template<typename T>
+			void GetCompiledArgumentValue(const CompiledCommandArgument &arg, const udm::Property *const *dynamicArgumentValues, T &outValue) const
+			{
+				if constexpr(std::is_enum_v<T>) {
+					using TBase = std::underlying_type_t<T>;
+					return GetCompiledArgumentValue<TBase>(arg, dynamicArgumentValues, reinterpret_cast<TBase &>(outValue));
+				}
+				else {
+					if(arg.source == CompiledCommandArgument::Source::Dynamic) {
+						auto *prop = dynamicArgumentValues[arg.index];
+						if(!prop)
+							return;
+						auto val = prop->ToValue<T>();
+						if(!val.has_value())
+							throw std::runtime_error {"Dynamic argument value is set, but uses incompatible type!"};
+						outValue = *val;
+						return;
+					}
+					auto *prop = m_staticArgumentValues[arg.index];
+					if(!prop)
+						throw std::runtime_error {"No static argument value has been specified!"};
+					auto val = prop->ToValue<T>();
+					if(!val.has_value())
+						throw std::runtime_error {"Static argument value is set, but uses incompatible type!"};
+					outValue = *val;
+				}
+			}
+			template<typename T>
 			void SetDynamicArgument(const std::string &name, T &&value)
 			{
 				dynamicArguments.SetArgumentValue<T>(name, std::move(value));
 			}
 			void PushCommand(PreparedCommandFunction &&cmd, std::vector<PreparedCommand::Argument> &&args = {});
+			// Flattens the arguments of all commands into a single table and assigns every unique dynamic argument a slot, which is
+			// resolved once per RecordCommands call instead of once per argument access. Has to be called again if commands are added or changed.
+			void Compile();
+			bool IsCompiled() const { return m_compiled; }
 			bool RecordCommands(ICommandBuffer &cmdBuf, const PreparedCommandArgumentMap &drawArguments, const PreparedCommandBufferUserData &userData) const;
 			void Reset();
-			std::vector<PreparedCommand> commands;
+			const std::vector<PreparedCommand> &GetCommands() const { return m_commands; }
+			// The compiled argument table points into the commands, so mutable access invalidates it
+			std::vector<PreparedCommand> &GetCommands()
+			{
+				m_compiled = false;
+				return m_commands;
+			}
 			PreparedCommandArgumentMap dynamicArguments;
 			bool enableDrawArgs = true;
+		  private:
+			std::vector<PreparedCommand> m_commands;
+			bool RecordCompiledCommands(PreparedCommandBufferRecordState &recordState) const;
+			bool m_compiled = false;
+			std::vector<uint32_t> m_commandArgumentOffsets;
+			std::vector<CompiledCommandArgument> m_compiledArguments;
+			std::vector<const udm::Property *> m_staticArgumentValues;
+			std::vector<PreparedCommand::Argument::StringHash> m_dynamicArgumentSlots;
 		};
 
 		template<typename T>
@@ -179,7 +238,11 @@ export {
 		template<typename T>
 		T PreparedCommandBufferRecordState::GetArgument(uint32_t idx) const
 		{
-			T value;
+			T value {};
+			if(curCompiledArguments) {
+				prepCommandBuffer.GetCompiledArgumentValue(curCompiledArguments[idx], dynamicArgumentValues, value);
+				return value;
+			}
 			prepCommandBuffer.GetArgumentValue(curCommand->args[idx], drawArguments, value);
 			return value;
 		}
@@ -7,16 +7,23 @@ export import :debug;
 export import :image;
 export import :query;
 
+export import :barrier_accumulator;
+export import :block_compression;
 export import :command_buffer;
 export import :common_buffer_cache;
 export import :context_object;
 export import :context;
+export import :descriptor_set_cache;
 export import :descriptor_set_group;
+export import :descriptor_write_batcher;
 export import :enums;
 export import :event;
 export import :fence;
+export import :format_info;
 export import :framebuffer;
 export import :glsl;
+export import :glsl_expression;
+export import :pixel_conversion;
 export import :prepared_command_buffer;
 export import :render_pass;
 export import :shader_system;
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:query.gpu_profiler;
+
+export import :query.pool;
+export import :query.timestamp;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		class ICommandBuffer;
+		// Measures the GPU time of hierarchical named scopes. Each frame in flight owns a fixed range of timestamp queries of a dedicated pool, which
+		// is read back with a single bulk read once the frame's resources are reused (or earlier with Resolve). All functions have to be called from the
+		// thread that records the profiled command buffer.
+		class DLLPROSPER GpuProfiler {
+		  public:
+			static constexpr uint32_t INVALID_SCOPE_INDEX = std::numeric_limits<uint32_t>::max();
+			struct DLLPROSPER ScopeResult {
+				std::string name;
+				uint32_t depth = 0;
+				uint32_t parentIndex = INVALID_SCOPE_INDEX; // Index into FrameResult::scopes
+				std::chrono::nanoseconds start {0};
+				std::chrono::nanoseconds duration {0};
+			};
+			struct DLLPROSPER FrameResult {
+				uint64_t frameIndex = 0;
+				// The first scope spans the entire frame (BeginFrame to EndFrame), parents always precede their children
+				std::vector<ScopeResult> scopes;
+			};
+			struct DLLPROSPER Stats {
+				uint64_t numFramesResolved = 0;
+				uint64_t numFramesDropped = 0;    // Frames whose results were not available by the time their queries had to be reused
+				uint64_t numScopesOverflowed = 0; // Scopes that were not measured because the frame's query range was exhausted
+				uint64_t numBulkReads = 0;
+			};
+			// Used instead of the query pool to read the timestamps of queryCount consecutive queries, starting at the specified query of the profiler's range.
+			// Returns false if the results are not available yet. Primarily intended to feed synthetic timestamps when there is no GPU backend.
+			using TimestampResolver = std::function<bool(uint32_t firstQuery, uint32_t queryCount, std::chrono::nanoseconds *outTimestamps)>;
+
+			GpuProfiler(IPrContext &context, uint32_t maxScopesPerFrame = 256, uint32_t maxFrameHistory = 64);
+			GpuProfiler(const GpuProfiler &) = delete;
+			GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+			bool IsValid() const { return !m_queries.empty(); }
+			void SetTimestampResolver(const TimestampResolver &resolver) { m_timestampResolver = resolver; }
+
+			// Resets the queries of the specified frame resource, so cmdBuffer must not be inside a render pass. Any previous results of the frame resource
+			// are resolved first, which requires that the GPU has finished the last frame that used it.
+			void BeginFrame(ICommandBuffer &cmdBuffer, uint8_t frameResourceIndex);
+			// Closes any scopes that are still open
+			void EndFrame(ICommandBuffer &cmdBuffer);
+			void BeginScope(ICommandBuffer &cmdBuffer, const std::string_view &name);
+			void EndScope(ICommandBuffer &cmdBuffer);
+
+			// Resolves all frames whose results are available, without waiting
+			void Resolve();
+			const std::deque<FrameResult> &GetResolvedFrames() const { return m_resolvedFrames; }
+			const FrameResult *GetLastResolvedFrame() const { return m_resolvedFrames.empty() ? nullptr : &m_resolvedFrames.back(); }
+			void ClearResolvedFrames() { m_resolvedFrames.clear(); }
+			const Stats &GetStats() const { return m_stats; }
+
+			// Writes the resolved frames in the Chrome trace event format (JSON), which can be loaded with chrome://tracing or Perfetto
+			void ExportChromeTrace(std::ostream &os) const;
+			std::string ExportChromeTrace() const;
+		  private:
+			struct Scope {
+				std::string name;
+				uint32_t depth = 0;
+				uint32_t parentIndex = INVALID_SCOPE_INDEX;
+				uint32_t beginQuery = 0; // Relative to the frame's query range
+				uint32_t endQuery = 0;
+			};
+			struct FrameSlot {
+				std::vector<Scope> scopes;
+				uint64_t frameIndex = 0;
+				uint32_t numQueriesUsed = 0;
+				uint32_t numQueriesToReset = 0;
+				bool pending = false;
+			};
+			bool ReadTimestamps(uint32_t firstQuery, uint32_t queryCount, std::chrono::nanoseconds *outTimestamps);
+			bool ResolveSlot(FrameSlot &slot);
+			std::optional<uint32_t> WriteTimestamp(ICommandBuffer &cmdBuffer);
+
+			IPrContext &m_context;
+			std::shared_ptr<IQueryPool> m_queryPool;
+			std::vector<std::shared_ptr<TimestampQuery>> m_queries; // Ordered by query id, split into one range per frame in flight
+			bool m_consecutiveQueryIds = false;
+			uint32_t m_queriesPerFrame = 0;
+			std::vector<FrameSlot> m_slots;
+			FrameSlot *m_currentSlot = nullptr;
+			uint32_t m_currentSlotIndex = 0;
+			std::vector<uint32_t> m_scopeStack; // Indices into the current slot's scopes, INVALID_SCOPE_INDEX for overflowed scopes
+			uint64_t m_nextFrameIndex = 0;
+			std::vector<std::chrono::nanoseconds> m_timestampBuffer;
+
+			uint32_t m_maxFrameHistory = 0;
+			std::deque<FrameResult> m_resolvedFrames;
+			TimestampResolver m_timestampResolver;
+			Stats m_stats {};
+		};
+	};
+#pragma warning(pop)
+}
@@ -14,6 +14,11 @@ export namespace prosper {
 	class TimerQuery;
 	class DLLPROSPER IQueryPool : public ContextObject, public std::enable_shared_from_this<IQueryPool> {
 	  public:
+		enum class BulkResult : uint8_t {
+			Success = 0,
+			NotReady,    // At least one of the results is not available yet
+			Unsupported, // The backend can't read multiple results at once, the results have to be read per query
+		};
 		virtual bool RequestQuery(uint32_t &queryId, QueryType type);
 		void FreeQuery(uint32_t queryId);
 
@@ -21,6 +26,8 @@ export namespace prosper {
 		std::shared_ptr<PipelineStatisticsQuery> CreatePipelineStatisticsQuery();
 		std::shared_ptr<TimestampQuery> CreateTimestampQuery(PipelineStageFlags pipelineStage);
 		std::shared_ptr<TimerQuery> CreateTimerQuery(PipelineStageFlags pipelineStageStart, PipelineStageFlags pipelineStageEnd);
+		// Reads the results of queryCount timestamp queries with consecutive ids in a single call, without waiting. No values are written unless Success is returned.
+		virtual BulkResult QueryTimestampResults(uint32_t firstQueryId, uint32_t queryCount, std::chrono::nanoseconds *outTimestampValues) const;
 	  protected:
 		IQueryPool(IPrContext &context, QueryType type, uint32_t queryCount);
 
@@ -4,6 +4,7 @@
 module;
 
 export module pragma.prosper:query;
+export import :query.gpu_profiler;
 export import :query.occlusion;
 export import :query.pipeline_statistics;
 export import :query.query;
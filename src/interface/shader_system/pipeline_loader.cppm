@@ -8,52 +8,91 @@ export import :types;
 #undef max
 
 export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
 	namespace prosper {
 		class IPrContext;
+		// Initializes shaders and bakes shader pipelines on a work-stealing thread pool. Every worker has its own task queues, idle workers steal tasks
+		// from the other workers. Tasks are executed in the order of their priority, threads waiting for a task to complete will execute other tasks in the meantime.
 		class DLLPROSPER ShaderPipelineLoader {
 		  public:
+			enum class Priority : uint8_t {
+				Low = 0,
+				Normal,
+				High, // Shaders that are required for the current frame
+
+				Count
+			};
 			ShaderPipelineLoader(IPrContext &context);
 			~ShaderPipelineLoader();
+			// Waits for all tasks to complete and finalizes the initialized shaders. Has to be called from the main thread.
 			void Flush();
+			// Waits for all tasks of the specified shader to complete (prioritizing them) and finalizes all completed shaders. Has to be called from the main thread.
+			void WaitForShader(ShaderIndex shaderIndex);
+			// Finalizes all shaders that have completed loading, without waiting for anything. Has to be called from the main thread.
+			void Update();
 			void Stop();
-			void Init(ShaderIndex shaderIndex, const std::function<bool()> &job);
-			void Bake(ShaderIndex shaderIndex, PipelineID id, PipelineBindPoint pipelineType);
+			std::shared_future<bool> Init(ShaderIndex shaderIndex, const std::function<bool()> &job, Priority priority = Priority::Normal);
+			std::shared_future<bool> Bake(ShaderIndex shaderIndex, PipelineID id, PipelineBindPoint pipelineType);
+			// Adds a generic task to the pool. If no priority is specified, the priority of the calling task is used (or Normal if not called from a task).
+			std::shared_future<bool> AddTask(ShaderIndex shaderIndex, const std::function<bool()> &task, std::optional<Priority> priority = {});
+			// Waits for the task to complete, executing other tasks in the meantime. Safe to call from within a task, in which case only tasks of the
+			// specified shader are executed while waiting (or none at all if no shader is specified), so that a task can never end up waiting on a task
+			// further down its own call stack.
+			bool Wait(const std::shared_future<bool> &future, std::optional<ShaderIndex> shaderIndex = {});
+			// Waits for the initialization job of the specified shader, if one is queued. Safe to call from within a task.
+			bool WaitForInit(ShaderIndex shaderIndex);
+			// Moves all queued tasks of the specified shader to the front
+			void Prioritize(ShaderIndex shaderIndex, Priority priority = Priority::High);
 			bool IsShaderQueued(ShaderIndex shaderIndex) const;
+			uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
 		  private:
-			struct InitItem {
+			struct Task {
 				ShaderIndex shaderIndex;
-				std::function<bool()> init;
+				Priority priority;
+				std::function<void()> execute;
 			};
-			struct BakeItem {
-				ShaderIndex shaderIndex;
-				PipelineID pipelineId;
-				PipelineBindPoint pipelineBindPoint;
+			struct Worker {
+				std::thread thread;
+				std::mutex queueMutex;
+				std::array<std::deque<Task>, pragma::math::to_integral(Priority::Count)> queues;
 			};
-			void ProcessInitQueue();
-			void ProcessBakeQueue();
+			void Push(Task &&task);
+			std::optional<Task> PopTask(std::optional<size_t> workerIdx, Priority minPriority, std::optional<ShaderIndex> shaderIndex);
+			bool RunTask(std::optional<size_t> workerIdx, Priority minPriority = Priority::Low, std::optional<ShaderIndex> shaderIndex = {});
+			void RunWorker(size_t workerIdx);
+			// Executes tasks with at least the specified priority (and of the specified shader, if set) until the condition is met
+			void HelpUntil(const std::function<bool()> &isDone, Priority minPriority, std::optional<ShaderIndex> shaderIndex = {});
+			// m_stateMutex has to be locked
+			void OnTaskQueued(const Task &task);
+			void OnTaskDequeued(const Task &task);
+			bool HasQueuedTasks(Priority minPriority, std::optional<ShaderIndex> shaderIndex = {}) const;
+			// Finalizes all initialized shaders that have no pending tasks left
+			void FinalizeCompletedShaders();
 			IPrContext &m_context;
 			void AddPendingShaderJobCount(ShaderIndex shaderIndex, int32_t i);
 
 			bool m_multiThreaded = true;
-			std::mutex m_initQueueMutex;
-			std::queue<InitItem> m_initQueue;
-			std::thread m_initThread;
-			std::condition_variable m_initPending;
-
-			std::thread m_bakeThread;
-			std::mutex m_bakeQueueMutex;
-			std::queue<BakeItem> m_bakeQueue;
-			std::condition_variable m_bakePending;
+			std::vector<std::unique_ptr<Worker>> m_workers;
+			std::atomic<size_t> m_nextWorker = 0;
 			std::atomic<bool> m_running = true;
 
+			// Notified whenever a task has been queued or completed
+			std::mutex m_stateMutex;
+			std::condition_variable m_stateChanged;
+			// Number of queued (not yet running) tasks, guarded by m_stateMutex
+			std::array<uint32_t, pragma::math::to_integral(Priority::Count)> m_numQueuedTasks {};
+			std::unordered_map<ShaderIndex, uint32_t> m_numQueuedShaderTasks;
+
 			std::atomic<uint32_t> m_pendingWork = 0;
-			std::condition_variable m_pendingWorkCondition;
-			std::mutex m_pendingWorkMutex;
 
 			mutable std::mutex m_pendingShaderJobsMutex;
 			std::unordered_map<ShaderIndex, uint32_t> m_pendingShaderJobs;
+			std::unordered_map<ShaderIndex, std::shared_future<bool>> m_initJobs;
 
+			std::mutex m_finalizationMutex;
 			std::unordered_set<ShaderIndex> m_shadersPendingForFinalization;
 		};
 	};
+#pragma warning(pop)
 }
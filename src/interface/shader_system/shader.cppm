@@ -64,6 +64,11 @@ export {
 			void Initialize(bool bReloadSourceCode = false);
 			void FinalizeInitialization();
 			void ReloadPipelines(bool bReloadSourceCode = false);
+			// Reloads the source code and pipelines in the background. The new stages and pipelines are built into a separate set, while the current ones
+			// are kept in use until the new ones are swapped in on the main thread (or until the next successful reload if the new source code fails to compile).
+			// The previous pipelines are released once the frames in flight are done with them.
+			void HotReload();
+			bool IsHotReloading() const { return m_hotReloading; }
 			uint32_t GetPipelineCount() const;
 
 			bool IsGraphicsShader() const;
@@ -72,6 +77,9 @@ export {
 			PipelineBindPoint GetPipelineBindPoint() const;
 			const ShaderModuleStageEntryPoint *GetModuleStageEntryPoint(ShaderStage stage, uint32_t pipelineIdx = 0u) const;
 			bool GetPipelineId(PipelineID &pipelineId, uint32_t pipelineIdx = 0u, bool waitForLoad = true) const;
+			// Returns the pipeline id written by the pipeline loader, without waiting or synchronization. Only for loader tasks that have waited
+			// for the initialization of this shader (e.g. derived shaders, see ShaderPipelineLoader::WaitForInit).
+			bool GetLoadedPipelineId(PipelineID &pipelineId, uint32_t pipelineIdx = 0u) const;
 
 			void BakePipeline(uint32_t pipelineIdx) const;
 			void BakePipelines() const;
@@ -152,6 +160,7 @@ export {
 
 			bool InitializeSources(bool bReload = false);
 			void InitializeStages();
+			void ReleaseRetiredPipelines();
 
 			std::array<std::shared_ptr<ShaderStageData>, pragma::math::to_integral(ShaderStage::Count)> m_stages;
 			bool m_bValid = false;
@@ -160,6 +169,10 @@ export {
 			ShaderIndex m_shaderIndex = std::numeric_limits<ShaderIndex>::max();
 			std::string m_identifier;
 			std::vector<PipelineInfo> m_pipelineInfos {};
+			// Stages and pipelines that are still in use on the main thread while the shader is being hot-reloaded
+			std::vector<PipelineInfo> m_retiredPipelineInfos {};
+			std::array<std::shared_ptr<ShaderStageData>, pragma::math::to_integral(ShaderStage::Count)> m_retiredStages;
+			bool m_hotReloading = false;
 
 			PipelineBindPoint m_pipelineBindPoint = static_cast<PipelineBindPoint>(-1);
 			std::vector<PipelineID> m_cachedPipelineIds;
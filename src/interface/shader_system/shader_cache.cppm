@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:shader_system.shader_cache;
+
+export import :types;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		// Content-addressed on-disk cache for compiled shader stages, see IPrContext::SetShaderCacheEnabled. Every entry is stored in its own lz4-compressed
+		// file named after the key. Entries are written to a temporary file first and then renamed, so readers never see partially written entries
+		// and no locking is required.
+		class DLLPROSPER ShaderCache {
+		  public:
+			// Has to be incremented whenever the file layout changes, entries with a different version are ignored
+			static constexpr uint32_t FORMAT_VERSION = 2;
+			struct DLLPROSPER Key {
+				uint64_t hash0 = 0;
+				uint64_t hash1 = 0;
+				std::string ToString() const;
+				bool operator==(const Key &other) const = default;
+			};
+			struct DLLPROSPER Entry {
+				std::string preprocessedSource;
+				uint32_t lineOffset = 0;
+				std::vector<uint32_t> spirv;
+			};
+			struct DLLPROSPER Stats {
+				uint64_t numHits = 0;
+				uint64_t numMisses = 0;
+				uint64_t numWrites = 0;
+			};
+			// expandedSource is the shader code after preprocessing (includes, definitions and prefix code have already been expanded)
+			static Key CalcKey(const std::string &expandedSource, const std::unordered_map<std::string, std::string> &definitions, const std::string &prefixCode, ShaderStage stage, const std::string &compilerVersion);
+
+			ShaderCache(const std::string &rootPath);
+			std::optional<Entry> Load(const Key &key) const;
+			bool Store(const Key &key, const Entry &entry);
+			// Removes all entries
+			void Clear();
+			const std::string &GetRootPath() const { return m_rootPath; }
+			Stats GetStats() const;
+		  private:
+			std::string GetEntryPath(const Key &key) const;
+			std::string m_rootPath;
+			std::atomic<uint64_t> m_tmpFileIndex = 0;
+			mutable std::atomic<uint64_t> m_numHits = 0;
+			mutable std::atomic<uint64_t> m_numMisses = 0;
+			std::atomic<uint64_t> m_numWrites = 0;
+		};
+	};
+#pragma warning(pop)
+}
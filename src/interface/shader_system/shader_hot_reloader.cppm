@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: (c) 2025 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.prosper:shader_system.shader_hot_reloader;
+
+export import :types;
+
+export {
+#pragma warning(push)
+#pragma warning(disable : 4251)
+	namespace prosper {
+		class IPrContext;
+		// Keeps track of which shader files include which other files. The graph is updated during the preprocessing of the shaders.
+		class DLLPROSPER ShaderDependencyGraph {
+		  public:
+			static std::string NormalizePath(const std::string &path);
+
+			// Replaces the direct includes of the specified file
+			void SetIncludes(const std::string &filePath, const std::vector<std::string> &includes);
+			// Returns the file itself and all files that include it, directly or indirectly
+			std::unordered_set<std::string> FindDependents(const std::string &filePath) const;
+			void Clear();
+		  private:
+			mutable std::shared_mutex m_mutex;
+			std::unordered_map<std::string, std::vector<std::string>> m_includes;
+			std::unordered_map<std::string, std::unordered_set<std::string>> m_includedBy;
+		};
+
+		// Watches the shader source directories and reloads all shaders affected by a changed file.
+		// Changes are debounced, since editors usually write a file in several steps.
+		// Directory watching is only implemented for Linux (inotify), on other platforms changes have to be reported with NotifyFileChanged.
+		class DLLPROSPER ShaderHotReloader {
+		  public:
+			ShaderHotReloader(IPrContext &context);
+			~ShaderHotReloader();
+			ShaderHotReloader(const ShaderHotReloader &) = delete;
+			ShaderHotReloader &operator=(const ShaderHotReloader &) = delete;
+
+			// Watches the directory and all of its sub-directories. virtualRoot is the path prefix the directory is mounted as for the shader system, e.g. "shaders/".
+			bool AddWatchDirectory(const std::string &absolutePath, const std::string &virtualRoot);
+			// filePath is relative to the virtual root, e.g. "shaders/common/lighting.glsl"
+			void NotifyFileChanged(const std::string &filePath);
+			void SetDebounceDelay(std::chrono::milliseconds delay) { m_debounceDelay = delay; }
+
+			// Reloads the affected shaders once the debounce delay has passed. Has to be called from the main thread.
+			void Poll();
+
+			ShaderDependencyGraph &GetDependencyGraph() { return m_dependencyGraph; }
+		  private:
+			struct WatchDirectory {
+				std::string absolutePath;
+				std::string virtualPath;
+			};
+			void ReloadShaders(const std::unordered_set<std::string> &changedFiles);
+			void RunWatcher();
+			bool AddWatch(const std::string &absolutePath, const std::string &virtualPath);
+
+			IPrContext &m_context;
+			ShaderDependencyGraph m_dependencyGraph;
+			std::chrono::milliseconds m_debounceDelay {250};
+
+			std::mutex m_pendingChangesMutex;
+			std::unordered_set<std::string> m_pendingChanges;
+			std::chrono::steady_clock::time_point m_lastChangeTime {};
+
+			int m_inotifyFd = -1;
+			std::mutex m_watchMutex;
+			std::unordered_map<int, WatchDirectory> m_watchDirectories;
+			std::atomic<bool> m_running = true;
+			std::thread m_watcherThread;
+		};
+	};
+#pragma warning(pop)
+}
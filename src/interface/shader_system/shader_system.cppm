@@ -9,5 +9,7 @@ export import :shader_system.manager;
 export import :shader_system.pipeline_create_info;
 export import :shader_system.pipeline_loader;
 export import :shader_system.pipeline_manager;
+export import :shader_system.shader_cache;
+export import :shader_system.shader_hot_reloader;
 export import :shader_system.shader;
 export import :shader_system.shaders;
@@ -14,6 +14,24 @@ export namespace prosper {
 	class ICommandBufferPool;
 
 	using RenderThreadRecordCall = std::function<void(ISecondaryCommandBuffer &)>;
+	// Worker threads shared by all multi-threaded swap command buffer groups of a context
+	class DLLPROSPER CommandRecordThreadPool {
+	  public:
+		CommandRecordThreadPool(uint32_t numThreads);
+		~CommandRecordThreadPool();
+		CommandRecordThreadPool(const CommandRecordThreadPool &) = delete;
+		CommandRecordThreadPool &operator=(const CommandRecordThreadPool &) = delete;
+		void Push(std::function<void()> &&task);
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+	  private:
+		void RunWorker();
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_taskAvailable;
+		std::deque<std::function<void()>> m_tasks;
+		bool m_running = true;
+	};
+
 	class SwapCommandBufferGroup;
 	class DLLPROSPER ISwapCommandBufferGroup {
 	  public:
@@ -43,6 +61,8 @@ export namespace prosper {
 		std::string m_debugName;
 	};
 
+	// Records on the command record thread pool of the context. The record calls of a group are executed in order and never
+	// concurrently, so the command buffers of different groups are recorded in parallel.
 	class DLLPROSPER MtSwapCommandBufferGroup : public ISwapCommandBufferGroup {
 	  public:
 		MtSwapCommandBufferGroup(Window &window, const std::string &debugName = {});
@@ -51,11 +71,12 @@ export namespace prosper {
 		virtual void Wait() override;
 	  private:
 		virtual void Record(const RenderThreadRecordCall &record) override;
+		void RunRecordCalls();
 
-		std::thread m_thread;
 		std::condition_variable m_conditionVar;
 		std::mutex m_waitMutex;
-		std::atomic<bool> m_close = false;
+		uint32_t m_numPendingCalls = 0; // Join counter for Wait
+		bool m_scheduled = false;       // Whether a task for this group has been pushed to the thread pool
 		std::atomic<bool> m_pending = false;
 	};
 
@@ -7,6 +7,7 @@ module;
 
 export module pragma.prosper:util;
 
+export import :format_info;
 export import :structs;
 import pragma.image;
 
@@ -89,6 +90,9 @@ export {
 			DLLPROSPER bool compress_image(IImage &image, const pragma::image::TextureInfo &texInfo, std::vector<std::vector<std::vector<uint8_t>>> &outputData, const std::function<void(const std::string &)> &errorHandler = nullptr);
 			DLLPROSPER bool save_texture(const std::string &fileName, IImage &image, const pragma::image::TextureInfo &texInfo, const std::function<void(const std::string &)> &errorHandler = nullptr);
 			DLLPROSPER std::function<const uint8_t *(uint32_t, uint32_t, std::function<void(void)> &)> image_to_data(IImage &image, const std::optional<Format> &dstFormat = {});
+			// Non-blocking version of image_to_data, see ImageReadback. The callback is invoked on the main thread, with nullptr if the readback has failed.
+			DLLPROSPER void image_to_data_async(IImage &image, const std::optional<Format> &dstFormat, const std::function<void(std::function<const uint8_t *(uint32_t, uint32_t, std::function<void(void)> &)>)> &callback,
+			  ImageLayout curImgLayout = ImageLayout::ShaderReadOnlyOptimal);
 
 			// Returns the padding required to align the offset with the specified alignment
 			DLLPROSPER uint32_t get_offset_alignment_padding(uint32_t offset, uint32_t alignment);